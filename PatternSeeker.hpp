@@ -4,11 +4,52 @@
 #include <string_view>
 #include <string>
 #include <optional>
+#include <array>
+#include <bit>
+
+#include <charconv>
+#include <limits>
+#include <type_traits>
 
 #include <cstdint>
 #include <cctype>
-#include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <initializer_list>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <memory_resource>
+#include <tuple>
+
+#if defined(PATTERN_SEEKER_WITH_STATS)
+#include "PatternSeekerStats.hpp"
+// Counts the call of the enclosing method, the method reports the outcome with PATTERN_SEEKER_STATS_RESULT
+#define PATTERN_SEEKER_STATS(operation) \
+    ::PatterSeekerNS::detail::StatsScope patternSeekerStats(::PatterSeekerNS::StatsOperation::operation)
+#define PATTERN_SEEKER_STATS_RESULT(found, scannedBytes) patternSeekerStats.result(found, scannedBytes)
+#else
+// Without PATTERN_SEEKER_WITH_STATS the hooks and their arguments compile away
+#define PATTERN_SEEKER_STATS(operation) ((void)0)
+#define PATTERN_SEEKER_STATS_RESULT(found, scannedBytes) ((void)0)
+#endif
+
+#if !defined(PATTERN_SEEKER_NO_SIMD)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PATTERN_SEEKER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PATTERN_SEEKER_NEON
+#include <arm_neon.h>
+#endif
+#endif
 
 namespace PatterSeekerNS
 {
@@ -22,413 +63,5196 @@ enum MoveMode
     move_after,
 };
 
-// PatternSeeker is a class that is easy to use for parsing small strings with a predefined pattern.
-// This class is just a display of the string passed in the constructor.
-// Because of this, the object is very lightweight and can be copied at zero cost.
-// Therefore, the responsibility for the lifetime of the original string falls on the developer.
-// PatternSeeker also allows you to parse Json and XML.
-// The author strongly recommends using appropriate parsers, however,
-// this class is convenient because it doesn't make a copy of the data
-// and allows you to easily and quickly parse a large structure and not use complex and heavy regular expressions.
-// For better performance, this class offers the user to decide for himself when to move the pointer and when not.
-class PatternSeeker
+// FixedString keeps a string literal, so it can be passed as a template argument.
+template <size_t N>
+struct FixedString
 {
-private:
-    static constexpr const char* EMPTY_STR = "";
-    static inline const std::string DOUBLE_QUOTE = "\"";
+    char data[N]{};
 
-    std::string_view m_str;
-    const char* m_originalPointer;
+    constexpr FixedString(const char (&str)[N])
+    {
+        for (size_t i = 0; i < N; ++i)
+            data[i] = str[i];
+    }
 
-    PatternSeeker(std::string_view str, const char* originalPointer)
-        : m_str(str.data() ? str : EMPTY_STR)
-        , m_originalPointer(originalPointer)
-    {}
+    constexpr std::string_view view() const
+    {
+        return { data, N - 1 };
+    }
+};
 
-    PatternSeeker()
-        : m_str(EMPTY_STR)
-        , m_originalPointer(EMPTY_STR)
-    {}
+// SearchBackend is the implementation of the substring search used by PatternSeeker.
+// The best backend the CPU supports is chosen at the first search,
+// setSearchBackend() allows you to force another one, for example for testing.
+enum class SearchBackend
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512,
+    neon,
+};
 
-public:
-    PatternSeeker(std::string_view str)
-        : m_str(str.data() ? str : EMPTY_STR)
-        , m_originalPointer(m_str.data())
-    {}
+// CharClass is a set of bytes for skipWhile, takeWhile and extractUntilOneOf.
+// It is built at compile time where possible: `constexpr auto hex = CharClass::digits() | CharClass("abcdefABCDEF");`
+// Besides a 256-bit set it keeps the nibble tables of the SIMD kernels: a byte is in the class when
+// bit (high nibble % 8) is set in the row of its low nibble, with separate rows for the ASCII bytes and the others.
+class CharClass
+{
+private:
+    std::array<uint64_t, 4> m_bits{};
+    alignas(16) std::array<uint8_t, 16> m_asciiRows{};
+    alignas(16) std::array<uint8_t, 16> m_otherRows{};
 
-    // Returns the size of the displayed string
-    size_t size() const
+    constexpr void add(uint8_t byte)
     {
-        return m_str.size();
+        m_bits[byte >> 6] |= uint64_t(1) << (byte & 63);
+        auto& rows = byte < 0x80 ? m_asciiRows : m_otherRows;
+        rows[byte & 0x0F] |= static_cast<uint8_t>(1u << ((byte >> 4) & 7));
     }
 
-    // Checks the string for emptiness
-    bool isEmpty() const
+public:
+    constexpr CharClass() = default;
+
+    // The class of the given chars
+    constexpr explicit CharClass(std::string_view chars)
     {
-        return size() == 0;
+        for (const char c : chars)
+            add(static_cast<uint8_t>(c));
     }
 
-    // Checking for non-emptiness (for better readability)
-    bool isNotEmpty() const
+    // The chars from `first` to `last` including
+    static constexpr CharClass range(char first, char last)
     {
-        return size() != 0;
+        CharClass result;
+        for (unsigned c = static_cast<uint8_t>(first); c <= static_cast<uint8_t>(last); ++c)
+            result.add(static_cast<uint8_t>(c));
+        return result;
     }
 
-    // Returns the string_view of the visible part
-    std::string_view to_string_view() const
+    // The whitespace of the "C" locale, whatever the current locale is
+    static constexpr CharClass spaces()
     {
-        return m_str;
+        return CharClass(" \t\n\v\f\r");
     }
 
-    // Returns the string of the visible part
-    std::string to_string() const
+    static constexpr CharClass digits()
     {
-        return std::string{ m_str.data(), m_str.size() };
+        return range('0', '9');
     }
 
-    // check what next and move the pointer after `expected`
-    // return true if found `expected`
-    bool expect(std::string_view expected)
+    static constexpr CharClass letters()
     {
-        if (m_str.starts_with(expected))
-        {
-            m_str.remove_prefix(expected.size());
-            return true;
-        }
+        return range('a', 'z') | range('A', 'Z');
+    }
 
-        return false;
+    // Letters, digits and `_`
+    static constexpr CharClass identifier()
+    {
+        return letters() | digits() | CharClass("_");
     }
 
-    // Check what next and don't move the pointer
-    bool startsWith(std::string_view expected) const
+    constexpr bool contains(char c) const
     {
-        return m_str.starts_with(expected);
+        const auto byte = static_cast<uint8_t>(c);
+        return (m_bits[byte >> 6] >> (byte & 63)) & 1;
     }
 
-    // Find the `expected` string and move the pointer after `expected`
-    bool to(std::string_view expected, MoveMode mode=none)
+    constexpr CharClass operator|(const CharClass& other) const
     {
-        const size_t pos = m_str.find(expected);
-        if (pos == std::string_view::npos)
+        CharClass result = *this;
+        for (size_t i = 0; i < 4; ++i)
+            result.m_bits[i] |= other.m_bits[i];
+        for (size_t i = 0; i < 16; ++i)
         {
-            return false;
+            result.m_asciiRows[i] |= other.m_asciiRows[i];
+            result.m_otherRows[i] |= other.m_otherRows[i];
         }
+        return result;
+    }
 
-        switch (mode)
+    // All the bytes that aren't in the class
+    constexpr CharClass operator~() const
+    {
+        CharClass result;
+        for (unsigned c = 0; c < 256; ++c)
         {
-        case move_before:
-            m_str.remove_prefix(pos);
-            break;
-        case move_after:
-            m_str.remove_prefix(pos + expected.size());
-            break;
-        case none:
-            // don't move
-            break;
+            if (!contains(static_cast<char>(c)))
+                result.add(static_cast<uint8_t>(c));
         }
+        return result;
+    }
 
-        return true;
+    // The nibble tables of the bytes below 0x80 and of the rest, 16-byte aligned
+    const uint8_t* asciiRows() const
+    {
+        return m_asciiRows.data();
     }
 
-    // Extract data `from` and `to` the desired strings.
-    PatternSeeker extract(std::string_view from, std::string_view to, MoveMode mode=none)
+    const uint8_t* otherRows() const
     {
-        auto startIt = m_str.find(from);
-        if (startIt == std::string::npos)
+        return m_otherRows.data();
+    }
+};
+
+namespace detail
+{
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PATTERN_SEEKER_TARGET(features) __attribute__((target(features)))
+#else
+#define PATTERN_SEEKER_TARGET(features)
+#endif
+
+using FindFunction = size_t (*)(const char* haystack, size_t size, const char* needle, size_t needleSize);
+
+// The reference implementation. All the kernels below must return exactly the same.
+inline size_t findScalar(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    return std::string_view(haystack, size).find(std::string_view(needle, needleSize));
+}
+
+// The reference implementation of the reverse search, it returns the last match
+inline size_t rfindScalar(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    return std::string_view(haystack, size).rfind(std::string_view(needle, needleSize));
+}
+
+// Returns whether the needle whose first and last bytes match at `pos` matches entirely
+inline bool needleAt(const char* haystack, size_t pos, const char* needle, size_t needleSize)
+{
+    return needleSize <= 2 || std::memcmp(haystack + pos + 1, needle + 1, needleSize - 2) == 0;
+}
+
+// The bit that folds the ASCII case of `c`, 0 if it isn't a letter.
+// `byte | bit == c | bit` holds only for the two cases of the letter, so the kernels fold with one OR.
+constexpr char caseFoldBit(char c)
+{
+    const char lower = static_cast<char>(c | 0x20);
+    return lower >= 'a' && lower <= 'z' ? 0x20 : 0;
+}
+
+constexpr char asciiLower(char c)
+{
+    return static_cast<char>(c | caseFoldBit(c));
+}
+
+// Compares ASCII case-insensitively, the other bytes have to be equal
+inline bool equalsIgnoreCase(const char* a, const char* b, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (asciiLower(a[i]) != asciiLower(b[i]))
+            return false;
+    }
+    return true;
+}
+
+// The reference implementation of the case-insensitive search
+inline size_t ifindScalar(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    if (needleSize > size)
+        return std::string_view::npos;
+    if (needleSize == 0)
+        return 0;
+
+    const char first = asciiLower(needle[0]);
+    for (size_t pos = 0; pos + needleSize <= size; ++pos)
+    {
+        if (asciiLower(haystack[pos]) == first && equalsIgnoreCase(haystack + pos + 1, needle + 1, needleSize - 1))
+            return pos;
+    }
+    return std::string_view::npos;
+}
+
+// Checks the middle of a candidate of the forward kernels at `candidate`
+template <bool IgnoreCase>
+inline bool middleMatches(const char* candidate, const char* needle, size_t needleSize)
+{
+    if constexpr (IgnoreCase)
+        return equalsIgnoreCase(candidate + 1, needle + 1, needleSize - 2);
+    else
+        return std::memcmp(candidate + 1, needle + 1, needleSize - 2) == 0;
+}
+
+template <bool IgnoreCase>
+inline size_t findTail(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    if constexpr (IgnoreCase)
+        return ifindScalar(haystack, size, needle, needleSize);
+    else
+        return findScalar(haystack, size, needle, needleSize);
+}
+
+// The kernels compare the first and the last bytes of the needle with a whole block of the haystack
+// and check the rest of the needle only where both of them match.
+// They expect needleSize >= 2 and leave the tail shorter than a block to findScalar.
+// With IgnoreCase the letters among the first and the last bytes are folded with caseFoldBit
+// before comparing and the candidates are checked with equalsIgnoreCase, so the haystack isn't copied.
+// The reverse kernels do the same from the end of the haystack, they also take a single byte
+// and leave the head shorter than a block to rfindScalar.
+
+#if defined(PATTERN_SEEKER_X86)
+
+template <bool IgnoreCase>
+PATTERN_SEEKER_TARGET("sse2")
+inline size_t findSse2Impl(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    const char firstByte = needle[0];
+    const char lastByte = needle[needleSize - 1];
+    const __m128i firstFold = _mm_set1_epi8(IgnoreCase ? caseFoldBit(firstByte) : 0);
+    const __m128i lastFold = _mm_set1_epi8(IgnoreCase ? caseFoldBit(lastByte) : 0);
+    const __m128i first = _mm_set1_epi8(IgnoreCase ? asciiLower(firstByte) : firstByte);
+    const __m128i last = _mm_set1_epi8(IgnoreCase ? asciiLower(lastByte) : lastByte);
+
+    size_t i = 0;
+    for (; i + needleSize + 15 <= size; i += 16)
+    {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + needleSize - 1));
+        if constexpr (IgnoreCase)
         {
-            return {};
+            blockFirst = _mm_or_si128(blockFirst, firstFold);
+            blockLast = _mm_or_si128(blockLast, lastFold);
         }
-        startIt += from.size();
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast));
 
-        const auto endIt = m_str.find(to, startIt);
-        if (endIt == std::string::npos) {
-            return {};
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        while (mask)
+        {
+            const size_t pos = i + std::countr_zero(mask);
+            if (middleMatches<IgnoreCase>(haystack + pos, needle, needleSize))
+                return pos;
+            mask &= mask - 1;
         }
+    }
 
-        auto substr = m_str.substr(startIt, endIt - startIt);
+    const size_t pos = findTail<IgnoreCase>(haystack + i, size - i, needle, needleSize);
+    return pos == std::string_view::npos ? pos : i + pos;
+}
 
-        switch (mode)
+template <bool IgnoreCase>
+PATTERN_SEEKER_TARGET("avx2")
+inline size_t findAvx2Impl(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    const char firstByte = needle[0];
+    const char lastByte = needle[needleSize - 1];
+    const __m256i firstFold = _mm256_set1_epi8(IgnoreCase ? caseFoldBit(firstByte) : 0);
+    const __m256i lastFold = _mm256_set1_epi8(IgnoreCase ? caseFoldBit(lastByte) : 0);
+    const __m256i first = _mm256_set1_epi8(IgnoreCase ? asciiLower(firstByte) : firstByte);
+    const __m256i last = _mm256_set1_epi8(IgnoreCase ? asciiLower(lastByte) : lastByte);
+
+    size_t i = 0;
+    for (; i + needleSize + 31 <= size; i += 32)
+    {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needleSize - 1));
+        if constexpr (IgnoreCase)
         {
-        case move_before:
-            m_str.remove_prefix(startIt - from.size());
-            break;
-        case move_after:
-            m_str.remove_prefix(endIt + to.size());
-            break;
-        case none:
-            // don't move
-            break;
-        default:
-            break;
+            blockFirst = _mm256_or_si256(blockFirst, firstFold);
+            blockLast = _mm256_or_si256(blockLast, lastFold);
         }
+        const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast));
 
-        return PatternSeeker(substr, m_originalPointer);
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        while (mask)
+        {
+            const size_t pos = i + std::countr_zero(mask);
+            if (middleMatches<IgnoreCase>(haystack + pos, needle, needleSize))
+                return pos;
+            mask &= mask - 1;
+        }
     }
 
-    // Extract data from current position and `to` the desired strings.
-    PatternSeeker extract(std::string_view to, MoveMode mode=none)
+    const size_t pos = findSse2Impl<IgnoreCase>(haystack + i, size - i, needle, needleSize);
+    return pos == std::string_view::npos ? pos : i + pos;
+}
+
+template <bool IgnoreCase>
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline size_t findAvx512Impl(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    const char firstByte = needle[0];
+    const char lastByte = needle[needleSize - 1];
+    const __m512i firstFold = _mm512_set1_epi8(IgnoreCase ? caseFoldBit(firstByte) : 0);
+    const __m512i lastFold = _mm512_set1_epi8(IgnoreCase ? caseFoldBit(lastByte) : 0);
+    const __m512i first = _mm512_set1_epi8(IgnoreCase ? asciiLower(firstByte) : firstByte);
+    const __m512i last = _mm512_set1_epi8(IgnoreCase ? asciiLower(lastByte) : lastByte);
+
+    size_t i = 0;
+    for (; i + needleSize + 63 <= size; i += 64)
     {
-        const auto endIt = m_str.find(to);
-        if (endIt == std::string::npos)
+        __m512i blockFirst = _mm512_loadu_si512(haystack + i);
+        __m512i blockLast = _mm512_loadu_si512(haystack + i + needleSize - 1);
+        if constexpr (IgnoreCase)
         {
-            return {};
+            blockFirst = _mm512_or_si512(blockFirst, firstFold);
+            blockLast = _mm512_or_si512(blockLast, lastFold);
         }
 
-        auto substr = m_str.substr(0, endIt);
-
-        switch (mode)
+        uint64_t mask = _mm512_cmpeq_epi8_mask(first, blockFirst) & _mm512_cmpeq_epi8_mask(last, blockLast);
+        while (mask)
         {
-        case move_before:
-            m_str.remove_prefix(endIt);
-            break;
-        case move_after:
-            m_str.remove_prefix(endIt + to.size());
-            break;
-        case none:
-            // don't move
-            break;
-        default:
-            break;
+            const size_t pos = i + std::countr_zero(mask);
+            if (middleMatches<IgnoreCase>(haystack + pos, needle, needleSize))
+                return pos;
+            mask &= mask - 1;
         }
-
-        return PatternSeeker(substr, m_originalPointer);
     }
 
-    // Extract data from current position `to` the desired symbols.
-    PatternSeeker extractUntilOneOf(std::string_view to, MoveMode mode=none)
+    const size_t pos = findAvx2Impl<IgnoreCase>(haystack + i, size - i, needle, needleSize);
+    return pos == std::string_view::npos ? pos : i + pos;
+}
+
+PATTERN_SEEKER_TARGET("sse2")
+inline size_t rfindSse2(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    if (needleSize > size)
+        return std::string_view::npos;
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needleSize - 1]);
+
+    // the matches may start before `i`
+    size_t i = size - needleSize + 1;
+    while (i >= 16)
     {
-        const auto endIt = m_str.find_first_of(to);
-        if (endIt == std::string::npos)
+        i -= 16;
+        const __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+        const __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + needleSize - 1));
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast));
+
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        while (mask)
         {
-            return {};
+            const unsigned bit = 31 - std::countl_zero(mask);
+            if (needleAt(haystack, i + bit, needle, needleSize))
+                return i + bit;
+            mask ^= 1u << bit;
         }
+    }
 
-        auto substr = m_str.substr(0, endIt);
+    return rfindScalar(haystack, i + needleSize - 1, needle, needleSize);
+}
 
-        if (mode == move_after)
-            m_str.remove_prefix(endIt + 1);
+PATTERN_SEEKER_TARGET("avx2")
+inline size_t rfindAvx2(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    if (needleSize > size)
+        return std::string_view::npos;
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needleSize - 1]);
 
-        return PatternSeeker(substr, m_originalPointer);
+    size_t i = size - needleSize + 1;
+    while (i >= 32)
+    {
+        i -= 32;
+        const __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+        const __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needleSize - 1));
+        const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast));
+
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        while (mask)
+        {
+            const unsigned bit = 31 - std::countl_zero(mask);
+            if (needleAt(haystack, i + bit, needle, needleSize))
+                return i + bit;
+            mask ^= 1u << bit;
+        }
     }
 
-    // to avoid implicit convertion
-    PatternSeeker extract(char) = delete;
+    return rfindSse2(haystack, i + needleSize - 1, needle, needleSize);
+}
 
-    // Extracts data from one character to another.
-    // However, if another `start` character is founded during the search for the `end` character,
-    // the search continues until the corresponding `end` character is found.
-    // It is convenient to search for objects in curly or square brackets.
-    PatternSeeker extract(char start, char end, MoveMode mode=none)
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline size_t rfindAvx512(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    if (needleSize > size)
+        return std::string_view::npos;
+    const __m512i first = _mm512_set1_epi8(needle[0]);
+    const __m512i last = _mm512_set1_epi8(needle[needleSize - 1]);
+
+    size_t i = size - needleSize + 1;
+    while (i >= 64)
     {
-        size_t startIndex = m_str.find(start);
-        if (startIndex == std::string::npos)
-            return {};
+        i -= 64;
+        const __m512i blockFirst = _mm512_loadu_si512(haystack + i);
+        const __m512i blockLast = _mm512_loadu_si512(haystack + i + needleSize - 1);
 
-        size_t i = startIndex + 1;
-        int depth = 1;
-        while (i < m_str.size())
+        uint64_t mask = _mm512_cmpeq_epi8_mask(first, blockFirst) & _mm512_cmpeq_epi8_mask(last, blockLast);
+        while (mask)
         {
-            char ch = m_str[i++];
-            if (ch == start) ++depth;
-            else if (ch == end) {
-                --depth;
-                if (depth == 0) break;
-            }
+            const unsigned bit = 63 - std::countl_zero(mask);
+            if (needleAt(haystack, i + bit, needle, needleSize))
+                return i + bit;
+            mask ^= 1ull << bit;
         }
-        if (depth != 0)
-            return {};
+    }
 
-        auto substr = m_str.substr(startIndex, i - startIndex);
+    return rfindAvx2(haystack, i + needleSize - 1, needle, needleSize);
+}
 
-        switch (mode)
+#endif
+
+#if defined(PATTERN_SEEKER_NEON)
+
+template <bool IgnoreCase>
+inline size_t findNeonImpl(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    const char firstByte = needle[0];
+    const char lastByte = needle[needleSize - 1];
+    const uint8x16_t firstFold = vdupq_n_u8(static_cast<uint8_t>(IgnoreCase ? caseFoldBit(firstByte) : 0));
+    const uint8x16_t lastFold = vdupq_n_u8(static_cast<uint8_t>(IgnoreCase ? caseFoldBit(lastByte) : 0));
+    const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(IgnoreCase ? asciiLower(firstByte) : firstByte));
+    const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(IgnoreCase ? asciiLower(lastByte) : lastByte));
+
+    size_t i = 0;
+    for (; i + needleSize + 15 <= size; i += 16)
+    {
+        uint8x16_t blockFirst = vld1q_u8(reinterpret_cast<const uint8_t*>(haystack + i));
+        uint8x16_t blockLast = vld1q_u8(reinterpret_cast<const uint8_t*>(haystack + i + needleSize - 1));
+        if constexpr (IgnoreCase)
         {
-        case move_before:
-            m_str.remove_prefix(startIndex);
-            break;
-        case move_after:
-            m_str.remove_prefix(i);
-            break;
-        case none:
-            break;
+            blockFirst = vorrq_u8(blockFirst, firstFold);
+            blockLast = vorrq_u8(blockLast, lastFold);
         }
+        const uint8x16_t eq = vandq_u8(vceqq_u8(first, blockFirst), vceqq_u8(last, blockLast));
 
-        return PatternSeeker{substr, m_originalPointer};
+        // NEON has no movemask, so every byte is narrowed to 4 bits of a 64-bit mask
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        mask &= 0x8888888888888888ull;
+        while (mask)
+        {
+            const size_t pos = i + std::countr_zero(mask) / 4;
+            if (middleMatches<IgnoreCase>(haystack + pos, needle, needleSize))
+                return pos;
+            mask &= mask - 1;
+        }
     }
 
-    // Extracts the required number of characters
-    PatternSeeker extract(size_t size, MoveMode mode=none)
-    {
-        auto substr = m_str.substr(0, size);
+    const size_t pos = findTail<IgnoreCase>(haystack + i, size - i, needle, needleSize);
+    return pos == std::string_view::npos ? pos : i + pos;
+}
 
-        if (mode == move_after)
-            m_str.remove_prefix(size);
+inline size_t rfindNeon(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    if (needleSize > size)
+        return std::string_view::npos;
+    const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(needle[0]));
+    const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(needle[needleSize - 1]));
 
-        return PatternSeeker{substr, m_originalPointer};
+    size_t i = size - needleSize + 1;
+    while (i >= 16)
+    {
+        i -= 16;
+        const uint8x16_t blockFirst = vld1q_u8(reinterpret_cast<const uint8_t*>(haystack + i));
+        const uint8x16_t blockLast = vld1q_u8(reinterpret_cast<const uint8_t*>(haystack + i + needleSize - 1));
+        const uint8x16_t eq = vandq_u8(vceqq_u8(first, blockFirst), vceqq_u8(last, blockLast));
+
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        mask &= 0x8888888888888888ull;
+        while (mask)
+        {
+            const unsigned bit = 63 - std::countl_zero(mask);
+            if (needleAt(haystack, i + bit / 4, needle, needleSize))
+                return i + bit / 4;
+            mask ^= 1ull << bit;
+        }
+    }
+
+    return rfindScalar(haystack, i + needleSize - 1, needle, needleSize);
+}
+
+#endif
+
+// ClassifyFunction builds bitmasks of the bytes equal to each of `count` chars
+// for `blocks` consecutive 64-byte blocks: bit i of masks[block * count + c] is set
+// when byte i of the block is chars[c]. The bitmasks are processed with ordinary
+// integer instructions afterwards, so the SIMD part stays tiny.
+using ClassifyFunction = void (*)(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks);
+
+// The maximal number of chars and blocks that can be classified in one call
+inline constexpr size_t MAX_CLASSIFY_CHARS = 8;
+inline constexpr size_t MAX_CLASSIFY_BLOCKS = 16;
+
+// Classifies `size` < 64 bytes, the rest of the bits stay zero
+inline void classifyPartial(const char* data, size_t size, const char* chars, size_t count, uint64_t* masks)
+{
+    for (size_t c = 0; c < count; ++c)
+    {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < size; ++i)
+            mask |= static_cast<uint64_t>(data[i] == chars[c]) << i;
+        masks[c] = mask;
+    }
+}
+
+inline void classifyScalar(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks)
+{
+    for (size_t block = 0; block < blocks; ++block)
+        classifyPartial(data + block * 64, 64, chars, count, masks + block * count);
+}
+
+#if defined(PATTERN_SEEKER_X86)
+
+PATTERN_SEEKER_TARGET("sse2")
+inline void classifySse2(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks)
+{
+    for (size_t block = 0; block < blocks; ++block, data += 64, masks += count)
+    {
+        const __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        const __m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+        const __m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+        const __m128i in3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48));
+        for (size_t c = 0; c < count; ++c)
+        {
+            const __m128i ch = _mm_set1_epi8(chars[c]);
+            const uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in0, ch)));
+            const uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in1, ch)));
+            const uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in2, ch)));
+            const uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in3, ch)));
+            masks[c] = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+        }
+    }
+}
+
+PATTERN_SEEKER_TARGET("avx2")
+inline void classifyAvx2(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks)
+{
+    for (size_t block = 0; block < blocks; ++block, data += 64, masks += count)
+    {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+        for (size_t c = 0; c < count; ++c)
+        {
+            const __m256i ch = _mm256_set1_epi8(chars[c]);
+            const uint64_t lowMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, ch)));
+            const uint64_t highMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, ch)));
+            masks[c] = lowMask | (highMask << 32);
+        }
+    }
+}
+
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline void classifyAvx512(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks)
+{
+    for (size_t block = 0; block < blocks; ++block, data += 64, masks += count)
+    {
+        const __m512i in = _mm512_loadu_si512(data);
+        for (size_t c = 0; c < count; ++c)
+            masks[c] = _mm512_cmpeq_epi8_mask(in, _mm512_set1_epi8(chars[c]));
+    }
+}
+
+#endif
+
+#if defined(PATTERN_SEEKER_NEON)
+
+// Emulates movemask for a 16-byte comparison result
+inline uint64_t neonMask16(uint8x16_t eq)
+{
+    const uint8x16_t bits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t masked = vandq_u8(eq, bits);
+    return static_cast<uint64_t>(vaddv_u8(vget_low_u8(masked)))
+        | (static_cast<uint64_t>(vaddv_u8(vget_high_u8(masked))) << 8);
+}
+
+inline void classifyNeon(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks)
+{
+    for (size_t block = 0; block < blocks; ++block, data += 64, masks += count)
+    {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+        const uint8x16_t in0 = vld1q_u8(bytes);
+        const uint8x16_t in1 = vld1q_u8(bytes + 16);
+        const uint8x16_t in2 = vld1q_u8(bytes + 32);
+        const uint8x16_t in3 = vld1q_u8(bytes + 48);
+        for (size_t c = 0; c < count; ++c)
+        {
+            const uint8x16_t ch = vdupq_n_u8(static_cast<uint8_t>(chars[c]));
+            masks[c] = neonMask16(vceqq_u8(in0, ch))
+                | (neonMask16(vceqq_u8(in1, ch)) << 16)
+                | (neonMask16(vceqq_u8(in2, ch)) << 32)
+                | (neonMask16(vceqq_u8(in3, ch)) << 48);
+        }
+    }
+}
+
+#endif
+
+// Nibble tables of a Teddy search over the first `prefix` bytes of up to 8 patterns, see MultiPattern.
+// Bit i of low[k][n] is set when byte k of pattern i has the low nibble n, high[k] is the same for the high nibbles,
+// so a position may start pattern i only if bit i survives the AND of both tables for every byte of the prefix.
+struct TeddyTables
+{
+    alignas(16) uint8_t low[3][16];
+    alignas(16) uint8_t high[3][16];
+    size_t prefix;
+};
+
+// TeddyFunction finds the first position p where a pattern may start and fills buckets[j]
+// with the candidate patterns of position p + j for j < 64. The kernels may leave the buckets
+// after their first block zero without scanning them, so the caller continues after the last candidate.
+// Returns npos if there are no candidates at all.
+using TeddyFunction = size_t (*)(const TeddyTables& tables, const char* data, size_t size, uint8_t* buckets);
+
+inline uint8_t teddyCandidates(const TeddyTables& tables, const char* data)
+{
+    uint8_t bits = 0xFF;
+    for (size_t k = 0; k < tables.prefix; ++k)
+    {
+        const auto byte = static_cast<uint8_t>(data[k]);
+        bits &= tables.low[k][byte & 0x0F] & tables.high[k][byte >> 4];
+    }
+    return bits;
+}
+
+// The reference implementation, and the tail of the SIMD kernels starting with `from`
+inline size_t teddyScalarFrom(const TeddyTables& tables, const char* data, size_t size, size_t from, uint8_t* buckets)
+{
+    if (size < tables.prefix)
+        return std::string_view::npos;
+
+    const size_t last = size - tables.prefix;
+    for (size_t i = from; i <= last; ++i)
+    {
+        if (!teddyCandidates(tables, data + i))
+            continue;
+        for (size_t j = 0; j < 64; ++j)
+            buckets[j] = i + j <= last ? teddyCandidates(tables, data + i + j) : 0;
+        return i;
+    }
+    return std::string_view::npos;
+}
+
+inline size_t teddyScalar(const TeddyTables& tables, const char* data, size_t size, uint8_t* buckets)
+{
+    return teddyScalarFrom(tables, data, size, 0, buckets);
+}
+
+#if defined(PATTERN_SEEKER_X86)
+
+PATTERN_SEEKER_TARGET("avx2")
+inline size_t teddyAvx2(const TeddyTables& tables, const char* data, size_t size, uint8_t* buckets)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i low[3];
+    __m256i high[3];
+    for (size_t k = 0; k < 3; ++k)
+    {
+        low[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.low[k])));
+        high[k] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(tables.high[k])));
+    }
+
+    size_t i = 0;
+    for (; i + 31 + tables.prefix <= size; i += 32)
+    {
+        __m256i bits = _mm256_set1_epi8(-1);
+        for (size_t k = 0; k < tables.prefix; ++k)
+        {
+            const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + k));
+            const __m256i lo = _mm256_shuffle_epi8(low[k], _mm256_and_si256(in, nibble));
+            const __m256i hi = _mm256_shuffle_epi8(high[k], _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+            bits = _mm256_and_si256(bits, _mm256_and_si256(lo, hi));
+        }
+
+        if (!_mm256_testz_si256(bits, bits))
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(buckets), bits);
+            std::memset(buckets + 32, 0, 32);
+            return i;
+        }
+    }
+
+    return teddyScalarFrom(tables, data, size, i, buckets);
+}
+
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline size_t teddyAvx512(const TeddyTables& tables, const char* data, size_t size, uint8_t* buckets)
+{
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    __m512i low[3];
+    __m512i high[3];
+    for (size_t k = 0; k < 3; ++k)
+    {
+        low[k] = _mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), _mm_load_si128(reinterpret_cast<const __m128i*>(tables.low[k])));
+        high[k] = _mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), _mm_load_si128(reinterpret_cast<const __m128i*>(tables.high[k])));
+    }
+
+    size_t i = 0;
+    for (; i + 63 + tables.prefix <= size; i += 64)
+    {
+        __m512i bits = _mm512_set1_epi8(-1);
+        for (size_t k = 0; k < tables.prefix; ++k)
+        {
+            const __m512i in = _mm512_loadu_si512(data + i + k);
+            const __m512i lo = _mm512_shuffle_epi8(low[k], _mm512_and_si512(in, nibble));
+            const __m512i hi = _mm512_shuffle_epi8(high[k], _mm512_and_si512(_mm512_srli_epi16(in, 4), nibble));
+            bits = _mm512_and_si512(bits, _mm512_and_si512(lo, hi));
+        }
+
+        if (_mm512_test_epi8_mask(bits, bits))
+        {
+            _mm512_storeu_si512(buckets, bits);
+            return i;
+        }
+    }
+
+    return teddyScalarFrom(tables, data, size, i, buckets);
+}
+
+#endif
+
+#if defined(PATTERN_SEEKER_NEON)
+
+inline size_t teddyNeon(const TeddyTables& tables, const char* data, size_t size, uint8_t* buckets)
+{
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    uint8x16_t low[3];
+    uint8x16_t high[3];
+    for (size_t k = 0; k < 3; ++k)
+    {
+        low[k] = vld1q_u8(tables.low[k]);
+        high[k] = vld1q_u8(tables.high[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 15 + tables.prefix <= size; i += 16)
+    {
+        uint8x16_t bits = vdupq_n_u8(0xFF);
+        for (size_t k = 0; k < tables.prefix; ++k)
+        {
+            const uint8x16_t in = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i + k));
+            const uint8x16_t lo = vqtbl1q_u8(low[k], vandq_u8(in, nibble));
+            const uint8x16_t hi = vqtbl1q_u8(high[k], vshrq_n_u8(in, 4));
+            bits = vandq_u8(bits, vandq_u8(lo, hi));
+        }
+
+        if (vmaxvq_u8(bits))
+        {
+            vst1q_u8(buckets, bits);
+            std::memset(buckets + 16, 0, 48);
+            return i;
+        }
+    }
+
+    return teddyScalarFrom(tables, data, size, i, buckets);
+}
+
+#endif
+
+// SpanFunction returns the length of the prefix of `data` whose bytes are all in `chars` if `inClass`
+// or all out of it otherwise, so it both skips a class and finds the first byte of one.
+using SpanFunction = size_t (*)(const CharClass& chars, const char* data, size_t size, bool inClass);
+
+inline size_t spanScalar(const CharClass& chars, const char* data, size_t size, bool inClass)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (chars.contains(data[i]) != inClass)
+            return i;
+    }
+    return size;
+}
+
+// The kernels look the row of every byte up by its low nibble and test the bit of its high nibble in it,
+// picking the ASCII or the other row by the sign of the byte.
+
+#if defined(PATTERN_SEEKER_X86)
+
+PATTERN_SEEKER_TARGET("avx2")
+inline size_t spanAvx2(const CharClass& chars, const char* data, size_t size, bool inClass)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i ascii = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(chars.asciiRows())));
+    const __m256i other = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(chars.otherRows())));
+    const __m256i rowBits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                             1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const uint32_t flip = inClass ? 0 : ~0u;
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i low = _mm256_and_si256(in, nibble);
+        const __m256i rows = _mm256_blendv_epi8(_mm256_shuffle_epi8(ascii, low), _mm256_shuffle_epi8(other, low), in);
+        const __m256i bits = _mm256_shuffle_epi8(rowBits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+        const __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), _mm256_setzero_si256());
+
+        const uint32_t stop = static_cast<uint32_t>(_mm256_movemask_epi8(outside)) ^ flip;
+        if (stop)
+            return i + std::countr_zero(stop);
+    }
+
+    return i + spanScalar(chars, data + i, size - i, inClass);
+}
+
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline size_t spanAvx512(const CharClass& chars, const char* data, size_t size, bool inClass)
+{
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    const __m512i ascii = _mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), _mm_load_si128(reinterpret_cast<const __m128i*>(chars.asciiRows())));
+    const __m512i other = _mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), _mm_load_si128(reinterpret_cast<const __m128i*>(chars.otherRows())));
+    const __m512i rowBits = _mm512_set1_epi64(static_cast<long long>(0x8040201008040201ull));
+    const uint64_t flip = inClass ? ~0ull : 0;
+
+    // the tail is loaded with a mask, so there is no scalar loop
+    for (size_t i = 0; i < size; i += 64)
+    {
+        const uint64_t valid = size - i >= 64 ? ~0ull : (uint64_t(1) << (size - i)) - 1;
+        const __m512i in = _mm512_maskz_loadu_epi8(valid, data + i);
+        const __m512i low = _mm512_and_si512(in, nibble);
+        const __m512i rows = _mm512_mask_blend_epi8(_mm512_movepi8_mask(in), _mm512_shuffle_epi8(ascii, low),
+                                                    _mm512_shuffle_epi8(other, low));
+        const __m512i bits = _mm512_shuffle_epi8(rowBits, _mm512_and_si512(_mm512_srli_epi16(in, 4), nibble));
+
+        const uint64_t stop = (_mm512_test_epi8_mask(rows, bits) ^ flip) & valid;
+        if (stop)
+            return i + std::countr_zero(stop);
+    }
+
+    return size;
+}
+
+#endif
+
+#if defined(PATTERN_SEEKER_NEON)
+
+inline size_t spanNeon(const CharClass& chars, const char* data, size_t size, bool inClass)
+{
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    const uint8x16_t ascii = vld1q_u8(chars.asciiRows());
+    const uint8x16_t other = vld1q_u8(chars.otherRows());
+    const uint8x16_t rowBits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t flip = vdupq_n_u8(inClass ? 0xFF : 0);
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        const uint8x16_t in = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+        const uint8x16_t low = vandq_u8(in, nibble);
+        const uint8x16_t rows = vbslq_u8(vcltzq_s8(vreinterpretq_s8_u8(in)), vqtbl1q_u8(other, low), vqtbl1q_u8(ascii, low));
+        const uint8x16_t bits = vqtbl1q_u8(rowBits, vshrq_n_u8(in, 4));
+        const uint8x16_t stop = veorq_u8(vtstq_u8(rows, bits), flip);
+
+        const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(stop), 4)), 0);
+        if (mask)
+            return i + std::countr_zero(mask) / 4;
+    }
+
+    return i + spanScalar(chars, data + i, size - i, inClass);
+}
+
+#endif
+
+// Utf8Function returns whether `data` is valid UTF-8: there are no truncated sequences, stray continuation bytes,
+// overlong forms, surrogates or code points above U+10FFFF.
+// The SIMD kernels use the lookup algorithm of Keiser and Lemire: three nibble lookups of every byte
+// and the byte before it give the errors of two-byte sequences, and the bytes two and three positions back
+// tell which bytes must continue longer ones. A block of ASCII only checks that no sequence was left unfinished.
+using Utf8Function = bool (*)(const char* data, size_t size);
+
+inline bool validateUtf8Scalar(const char* data, size_t size)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    while (i < size)
+    {
+        // ASCII 8 bytes at a time
+        uint64_t word;
+        if (size - i >= 8 && (std::memcpy(&word, bytes + i, 8), (word & 0x8080808080808080ull) == 0))
+        {
+            i += 8;
+            continue;
+        }
+
+        const uint8_t lead = bytes[i];
+        if (lead < 0x80)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t length = 0;
+        uint32_t code = 0;
+        uint32_t min = 0;
+        if ((lead & 0xE0) == 0xC0)
+            length = 2, code = lead & 0x1F, min = 0x80;
+        else if ((lead & 0xF0) == 0xE0)
+            length = 3, code = lead & 0x0F, min = 0x800;
+        else if ((lead & 0xF8) == 0xF0)
+            length = 4, code = lead & 0x07, min = 0x10000;
+        else
+            return false;
+
+        if (size - i < length)
+            return false;
+        for (size_t k = 1; k < length; ++k)
+        {
+            if ((bytes[i + k] & 0xC0) != 0x80)
+                return false;
+            code = code << 6 | (bytes[i + k] & 0x3F);
+        }
+        if (code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+            return false;
+        i += length;
+    }
+    return true;
+}
+
+// The error bits of the lookup tables, each one is set in the rows of the byte pairs that make the error
+inline constexpr uint8_t UTF8_TOO_SHORT = 1 << 0;   // 11______ 0_______ or 11______ 11______
+inline constexpr uint8_t UTF8_TOO_LONG = 1 << 1;    // 0_______ 10______
+inline constexpr uint8_t UTF8_OVERLONG_3 = 1 << 2;  // 11100000 100_____
+inline constexpr uint8_t UTF8_TOO_LARGE = 1 << 3;   // 11110100 1001____, 11110100 101_____, 111101__ 10______ ...
+inline constexpr uint8_t UTF8_SURROGATE = 1 << 4;   // 11101101 101_____
+inline constexpr uint8_t UTF8_OVERLONG_2 = 1 << 5;  // 1100000_ 10______
+inline constexpr uint8_t UTF8_TOO_LARGE_1000 = 1 << 6; // 11110101 1000____ ...
+inline constexpr uint8_t UTF8_OVERLONG_4 = 1 << 6;  // 11110000 1000____
+inline constexpr uint8_t UTF8_TWO_CONTS = 1 << 7;   // 10______ 10______
+// the low nibble of the first byte doesn't matter for these
+inline constexpr uint8_t UTF8_CARRY = UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS;
+
+// By the high nibble of the first byte of a pair
+alignas(16) inline constexpr uint8_t UTF8_BYTE_1_HIGH[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+// By the low nibble of the first byte
+alignas(16) inline constexpr uint8_t UTF8_BYTE_1_LOW[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+// By the high nibble of the second byte
+alignas(16) inline constexpr uint8_t UTF8_BYTE_2_HIGH[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+};
+
+// A block is incomplete when one of its last three bytes starts a sequence longer than the rest of the block.
+// Subtracting these with saturation leaves non-zero bytes there; the kernels take the last 16, 32 or 64 of them.
+alignas(64) inline constexpr uint8_t UTF8_INCOMPLETE_MAX[64] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+#if defined(PATTERN_SEEKER_X86)
+
+// The errors of the block `input` that follows the block `prev`
+PATTERN_SEEKER_TARGET("avx2")
+inline __m256i utf8ErrorsAvx2(__m256i input, __m256i prev)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i shifted = _mm256_permute2x128_si256(prev, input, 0x21);
+    const __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    const __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+    const __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+
+    const auto table = [](const uint8_t* rows) {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(rows));
+    };
+    const __m256i byte1High = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(table(UTF8_BYTE_1_HIGH)),
+                                                  _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    const __m256i byte1Low = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(table(UTF8_BYTE_1_LOW)),
+                                                 _mm256_and_si256(prev1, nibble));
+    const __m256i byte2High = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(table(UTF8_BYTE_2_HIGH)),
+                                                  _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    const __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    // the bytes after the leads of three and four byte sequences must be continuations, and only they may be
+    // continuations that follow continuations
+    const __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(mustContinue, special);
+}
+
+PATTERN_SEEKER_TARGET("avx2")
+inline bool validateUtf8Avx2(const char* data, size_t size)
+{
+    const __m256i incompleteMax = _mm256_load_si256(reinterpret_cast<const __m256i*>(UTF8_INCOMPLETE_MAX + 32));
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prevIncomplete = _mm256_setzero_si256();
+
+    // the tail is copied to a block padded with zeros, which end an unfinished sequence with an error
+    alignas(32) char tail[32] = {};
+    for (size_t i = 0; i < size; i += 32)
+    {
+        const char* block = data + i;
+        if (size - i < 32)
+        {
+            std::memcpy(tail, data + i, size - i);
+            block = tail;
+        }
+
+        const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        if (_mm256_movemask_epi8(input) == 0)
+        {
+            error = _mm256_or_si256(error, prevIncomplete);
+            prevIncomplete = _mm256_setzero_si256();
+        }
+        else
+        {
+            error = _mm256_or_si256(error, utf8ErrorsAvx2(input, prev));
+            prevIncomplete = _mm256_subs_epu8(input, incompleteMax);
+        }
+        if (!_mm256_testz_si256(error, error))
+            return false;
+        prev = input;
+    }
+    return _mm256_testz_si256(prevIncomplete, prevIncomplete);
+}
+
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline __m512i utf8ErrorsAvx512(__m512i input, __m512i prev)
+{
+    const __m512i nibble = _mm512_set1_epi8(0x0F);
+    // the lane before each lane of the input; the zero mask keeps GCC from warning about the undefined source
+    const __m512i shifted = _mm512_maskz_alignr_epi64(0xFF, input, prev, 6);
+    const __m512i prev1 = _mm512_alignr_epi8(input, shifted, 15);
+    const __m512i prev2 = _mm512_alignr_epi8(input, shifted, 14);
+    const __m512i prev3 = _mm512_alignr_epi8(input, shifted, 13);
+
+    const auto table = [](const uint8_t* rows) {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(rows));
+    };
+    const __m512i byte1High = _mm512_shuffle_epi8(_mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), table(UTF8_BYTE_1_HIGH)),
+                                                  _mm512_and_si512(_mm512_srli_epi16(prev1, 4), nibble));
+    const __m512i byte1Low = _mm512_shuffle_epi8(_mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), table(UTF8_BYTE_1_LOW)),
+                                                 _mm512_and_si512(prev1, nibble));
+    const __m512i byte2High = _mm512_shuffle_epi8(_mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), table(UTF8_BYTE_2_HIGH)),
+                                                  _mm512_and_si512(_mm512_srli_epi16(input, 4), nibble));
+    const __m512i special = _mm512_and_si512(_mm512_and_si512(byte1High, byte1Low), byte2High);
+
+    const __m512i third = _mm512_subs_epu8(prev2, _mm512_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m512i fourth = _mm512_subs_epu8(prev3, _mm512_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m512i mustContinue = _mm512_and_si512(_mm512_or_si512(third, fourth), _mm512_set1_epi8(static_cast<char>(0x80)));
+    return _mm512_xor_si512(mustContinue, special);
+}
+
+PATTERN_SEEKER_TARGET("avx512f,avx512bw")
+inline bool validateUtf8Avx512(const char* data, size_t size)
+{
+    const __m512i incompleteMax = _mm512_load_si512(UTF8_INCOMPLETE_MAX);
+    __m512i error = _mm512_setzero_si512();
+    __m512i prev = _mm512_setzero_si512();
+    __m512i prevIncomplete = _mm512_setzero_si512();
+
+    // the tail is loaded with a mask, the zeros after it end an unfinished sequence with an error
+    for (size_t i = 0; i < size; i += 64)
+    {
+        const uint64_t valid = size - i >= 64 ? ~0ull : (uint64_t(1) << (size - i)) - 1;
+        const __m512i input = _mm512_maskz_loadu_epi8(valid, data + i);
+        if (_mm512_movepi8_mask(input) == 0)
+        {
+            error = _mm512_or_si512(error, prevIncomplete);
+            prevIncomplete = _mm512_setzero_si512();
+        }
+        else
+        {
+            error = _mm512_or_si512(error, utf8ErrorsAvx512(input, prev));
+            prevIncomplete = _mm512_subs_epu8(input, incompleteMax);
+        }
+        if (_mm512_test_epi64_mask(error, error))
+            return false;
+        prev = input;
+    }
+    return _mm512_test_epi64_mask(prevIncomplete, prevIncomplete) == 0;
+}
+
+#endif
+
+#if defined(PATTERN_SEEKER_NEON)
+
+inline uint8x16_t utf8ErrorsNeon(uint8x16_t input, uint8x16_t prev)
+{
+    const uint8x16_t prev1 = vextq_u8(prev, input, 15);
+    const uint8x16_t prev2 = vextq_u8(prev, input, 14);
+    const uint8x16_t prev3 = vextq_u8(prev, input, 13);
+
+    const uint8x16_t byte1High = vqtbl1q_u8(vld1q_u8(UTF8_BYTE_1_HIGH), vshrq_n_u8(prev1, 4));
+    const uint8x16_t byte1Low = vqtbl1q_u8(vld1q_u8(UTF8_BYTE_1_LOW), vandq_u8(prev1, vdupq_n_u8(0x0F)));
+    const uint8x16_t byte2High = vqtbl1q_u8(vld1q_u8(UTF8_BYTE_2_HIGH), vshrq_n_u8(input, 4));
+    const uint8x16_t special = vandq_u8(vandq_u8(byte1High, byte1Low), byte2High);
+
+    const uint8x16_t third = vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80));
+    const uint8x16_t fourth = vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80));
+    const uint8x16_t mustContinue = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+    return veorq_u8(mustContinue, special);
+}
+
+inline bool validateUtf8Neon(const char* data, size_t size)
+{
+    const uint8x16_t incompleteMax = vld1q_u8(UTF8_INCOMPLETE_MAX + 48);
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8x16_t prev = vdupq_n_u8(0);
+    uint8x16_t prevIncomplete = vdupq_n_u8(0);
+
+    alignas(16) uint8_t tail[16] = {};
+    for (size_t i = 0; i < size; i += 16)
+    {
+        const uint8_t* block = reinterpret_cast<const uint8_t*>(data + i);
+        if (size - i < 16)
+        {
+            std::memcpy(tail, data + i, size - i);
+            block = tail;
+        }
+
+        const uint8x16_t input = vld1q_u8(block);
+        if (vmaxvq_u8(input) < 0x80)
+        {
+            error = vorrq_u8(error, prevIncomplete);
+            prevIncomplete = vdupq_n_u8(0);
+        }
+        else
+        {
+            error = vorrq_u8(error, utf8ErrorsNeon(input, prev));
+            prevIncomplete = vqsubq_u8(input, incompleteMax);
+        }
+        if (vmaxvq_u8(error) != 0)
+            return false;
+        prev = input;
+    }
+    return vmaxvq_u8(prevIncomplete) == 0;
+}
+
+#endif
+
+inline bool cpuSupports(SearchBackend backend)
+{
+    switch (backend)
+    {
+    case SearchBackend::scalar:
+        return true;
+#if defined(PATTERN_SEEKER_X86) && (defined(__GNUC__) || defined(__clang__))
+    case SearchBackend::sse2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case SearchBackend::avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    case SearchBackend::avx512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#elif defined(PATTERN_SEEKER_X86) && defined(_MSC_VER)
+    case SearchBackend::sse2:
+    case SearchBackend::avx2:
+    case SearchBackend::avx512:
+    {
+        int info[4] = {};
+        __cpuid(info, 1);
+        if (backend == SearchBackend::sse2)
+            return (info[3] & (1 << 26)) != 0;
+        // the OS must save the vector registers
+        if ((info[2] & (1 << 27)) == 0)
+            return false;
+
+        const uint64_t xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        if (backend == SearchBackend::avx2)
+            return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+        return (xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+    }
+#endif
+#if defined(PATTERN_SEEKER_NEON)
+    case SearchBackend::neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+// Kernels of one backend
+struct Kernels
+{
+    SearchBackend backend;
+    FindFunction find;
+    FindFunction rfind;
+    FindFunction ifind;
+    ClassifyFunction classify;
+    TeddyFunction teddy;
+    SpanFunction span;
+    Utf8Function utf8;
+};
+
+inline constexpr Kernels SCALAR_KERNELS{ SearchBackend::scalar, &findScalar, &rfindScalar, &ifindScalar, &classifyScalar, &teddyScalar, &spanScalar, &validateUtf8Scalar };
+#if defined(PATTERN_SEEKER_X86)
+inline constexpr Kernels SSE2_KERNELS{ SearchBackend::sse2, &findSse2Impl<false>, &rfindSse2, &findSse2Impl<true>, &classifySse2, &teddyScalar, &spanScalar, &validateUtf8Scalar };
+inline constexpr Kernels AVX2_KERNELS{ SearchBackend::avx2, &findAvx2Impl<false>, &rfindAvx2, &findAvx2Impl<true>, &classifyAvx2, &teddyAvx2, &spanAvx2, &validateUtf8Avx2 };
+inline constexpr Kernels AVX512_KERNELS{ SearchBackend::avx512, &findAvx512Impl<false>, &rfindAvx512, &findAvx512Impl<true>, &classifyAvx512, &teddyAvx512, &spanAvx512, &validateUtf8Avx512 };
+#endif
+#if defined(PATTERN_SEEKER_NEON)
+inline constexpr Kernels NEON_KERNELS{ SearchBackend::neon, &findNeonImpl<false>, &rfindNeon, &findNeonImpl<true>, &classifyNeon, &teddyNeon, &spanNeon, &validateUtf8Neon };
+#endif
+
+inline const Kernels& kernelsFor(SearchBackend backend)
+{
+    switch (backend)
+    {
+#if defined(PATTERN_SEEKER_X86)
+    case SearchBackend::sse2:
+        return SSE2_KERNELS;
+    case SearchBackend::avx2:
+        return AVX2_KERNELS;
+    case SearchBackend::avx512:
+        return AVX512_KERNELS;
+#endif
+#if defined(PATTERN_SEEKER_NEON)
+    case SearchBackend::neon:
+        return NEON_KERNELS;
+#endif
+    default:
+        return SCALAR_KERNELS;
+    }
+}
+
+inline SearchBackend bestSearchBackend()
+{
+    for (auto backend : { SearchBackend::avx512, SearchBackend::avx2, SearchBackend::neon, SearchBackend::sse2 })
+    {
+        if (cpuSupports(backend))
+            return backend;
+    }
+    return SearchBackend::scalar;
+}
+
+const Kernels& resolveKernels();
+
+inline size_t findResolve(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    return resolveKernels().find(haystack, size, needle, needleSize);
+}
+
+inline size_t rfindResolve(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    return resolveKernels().rfind(haystack, size, needle, needleSize);
+}
+
+inline size_t ifindResolve(const char* haystack, size_t size, const char* needle, size_t needleSize)
+{
+    return resolveKernels().ifind(haystack, size, needle, needleSize);
+}
+
+inline void classifyResolve(const char* data, size_t blocks, const char* chars, size_t count, uint64_t* masks)
+{
+    resolveKernels().classify(data, blocks, chars, count, masks);
+}
+
+inline size_t teddyResolve(const TeddyTables& tables, const char* data, size_t size, uint8_t* buckets)
+{
+    return resolveKernels().teddy(tables, data, size, buckets);
+}
+
+inline size_t spanResolve(const CharClass& chars, const char* data, size_t size, bool inClass)
+{
+    return resolveKernels().span(chars, data, size, inClass);
+}
+
+inline bool utf8Resolve(const char* data, size_t size)
+{
+    return resolveKernels().utf8(data, size);
+}
+
+// The first call resolves the backend, the following ones go directly to the kernels.
+// Static initialization is constant, so the searches can be used from other static constructors.
+inline constexpr Kernels RESOLVE_KERNELS{ SearchBackend::scalar, &findResolve, &rfindResolve, &ifindResolve, &classifyResolve, &teddyResolve, &spanResolve, &utf8Resolve };
+inline std::atomic<const Kernels*> g_kernels{ &RESOLVE_KERNELS };
+
+inline const Kernels& resolveKernels()
+{
+    const Kernels& best = kernelsFor(bestSearchBackend());
+    g_kernels.store(&best, std::memory_order_relaxed);
+    return best;
+}
+
+inline const Kernels& kernels()
+{
+    return *g_kernels.load(std::memory_order_relaxed);
+}
+
+// Drop-in replacement of std::string_view::find that runs the selected kernel
+inline size_t find(std::string_view haystack, std::string_view needle, size_t from = 0)
+{
+    if (from > haystack.size() || haystack.size() - from < needle.size())
+        return std::string_view::npos;
+
+    const char* begin = haystack.data() + from;
+    const size_t size = haystack.size() - from;
+    size_t pos;
+    if (needle.size() < 2 || size < 16)
+        pos = findScalar(begin, size, needle.data(), needle.size());
+    else
+        pos = kernels().find(begin, size, needle.data(), needle.size());
+
+    return pos == std::string_view::npos ? pos : from + pos;
+}
+
+// Drop-in replacement of std::string_view::rfind that runs the selected kernel
+inline size_t rfind(std::string_view haystack, std::string_view needle)
+{
+    if (needle.empty() || haystack.size() < 16)
+        return rfindScalar(haystack.data(), haystack.size(), needle.data(), needle.size());
+    return kernels().rfind(haystack.data(), haystack.size(), needle.data(), needle.size());
+}
+
+// The same as find, but the ASCII letters match in either case
+inline size_t ifind(std::string_view haystack, std::string_view needle, size_t from = 0)
+{
+    if (from > haystack.size() || haystack.size() - from < needle.size())
+        return std::string_view::npos;
+
+    const char* begin = haystack.data() + from;
+    const size_t size = haystack.size() - from;
+    size_t pos;
+    if (needle.size() < 2 || size < 16)
+        pos = ifindScalar(begin, size, needle.data(), needle.size());
+    else
+        pos = kernels().ifind(begin, size, needle.data(), needle.size());
+
+    return pos == std::string_view::npos ? pos : from + pos;
+}
+
+// Returns the length of the prefix of `str` whose bytes are all in `chars` if `inClass` or all out of it.
+// Runs of whitespace and digits are mostly short, so the first bytes are checked before calling a kernel.
+inline size_t span(std::string_view str, const CharClass& chars, bool inClass)
+{
+    constexpr size_t INLINE_BYTES = 8;
+    const size_t head = std::min(str.size(), INLINE_BYTES);
+    for (size_t i = 0; i < head; ++i)
+    {
+        if (chars.contains(str[i]) != inClass)
+            return i;
+    }
+    if (head == str.size())
+        return head;
+    return head + kernels().span(chars, str.data() + head, str.size() - head, inClass);
+}
+
+inline bool isValidUtf8(std::string_view str)
+{
+    return kernels().utf8(str.data(), str.size());
+}
+
+inline constexpr CharClass ASCII = CharClass::range('\0', '\x7F');
+
+inline bool isAscii(std::string_view str)
+{
+    return span(str, ASCII, true) == str.size();
+}
+
+// Returns the offset of the code point `n` of `str`, counted from 0, or the size if there are fewer.
+// A code point starts at every byte that isn't a continuation byte 10______, so the continuation bytes
+// of an invalid sequence stay with the code point before them.
+inline size_t utf8Advance(std::string_view str, size_t n)
+{
+    if (n == 0)
+        return 0;
+
+    // one byte per code point while the bytes are ASCII
+    const size_t ascii = span(str.substr(0, n + 1), ASCII, true);
+    if (ascii > n || ascii == str.size())
+        return std::min(n, str.size());
+
+    // the starts at 1 ... pos - 1 are passed, `left` more are looked for 8 bytes at a time
+    size_t pos = std::max<size_t>(ascii, 1);
+    size_t left = n - (pos - 1);
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        for (; str.size() - pos >= 8; pos += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, str.data() + pos, 8);
+            // the high bit of a byte is set unless it is a continuation byte, whose bit 6 is clear
+            uint64_t starts = ~(word & ~(word << 1)) & HIGH_BITS;
+            const size_t count = static_cast<size_t>(std::popcount(starts));
+            if (count >= left)
+            {
+                for (; left > 1; --left)
+                    starts &= starts - 1;
+                return pos + static_cast<size_t>(std::countr_zero(starts)) / 8;
+            }
+            left -= count;
+        }
+    }
+
+    for (; pos < str.size(); ++pos)
+    {
+        if ((static_cast<uint8_t>(str[pos]) & 0xC0) != 0x80 && --left == 0)
+            return pos;
+    }
+    return str.size();
+}
+
+// Classifies `str` starting with `from` in growing batches of 64-byte blocks and calls
+// `onBlock(position, masks)` for each block until it returns true.
+// The last block may be partial, its missing bytes don't match any char.
+// Returns true if `onBlock` stopped the scan.
+template <size_t Count, typename OnBlock>
+bool forEachBlock(std::string_view str, size_t from, const char (&chars)[Count], OnBlock&& onBlock)
+{
+    static_assert(Count <= MAX_CLASSIFY_CHARS);
+    uint64_t masks[Count * MAX_CLASSIFY_BLOCKS];
+
+    // Most matches are close, so the batch starts with one block and then grows
+    size_t batch = 1;
+    size_t pos = from;
+    while (pos < str.size())
+    {
+        size_t blocks = std::min(batch, (str.size() - pos) / 64);
+        if (blocks == 0)
+        {
+            // the tail is copied to a padded block, so it is classified by the kernel too
+            const size_t size = str.size() - pos;
+            alignas(64) char tail[64] = {};
+            std::memcpy(tail, str.data() + pos, size);
+            kernels().classify(tail, 1, chars, Count, masks);
+            for (size_t c = 0; c < Count; ++c)
+                masks[c] &= (1ull << size) - 1;
+            return onBlock(pos, static_cast<const uint64_t*>(masks));
+        }
+
+        kernels().classify(str.data() + pos, blocks, chars, Count, masks);
+        for (size_t block = 0; block < blocks; ++block, pos += 64)
+        {
+            if (onBlock(pos, static_cast<const uint64_t*>(masks + block * Count)))
+                return true;
+        }
+        batch = std::min(batch * 2, MAX_CLASSIFY_BLOCKS);
+    }
+
+    return false;
+}
+
+// Sets bit i when byte i of the block is escaped by an odd run of backslashes.
+// `prevEscaped` carries an escape over the block boundary. The algorithm is the one of simdjson.
+inline uint64_t escapedMask(uint64_t backslash, uint64_t& prevEscaped)
+{
+    if (backslash == 0)
+    {
+        const uint64_t escaped = prevEscaped;
+        prevEscaped = 0;
+        return escaped;
+    }
+
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ull;
+    backslash &= ~prevEscaped;
+    const uint64_t followsEscape = (backslash << 1) | prevEscaped;
+    const uint64_t oddSequenceStarts = backslash & ~EVEN_BITS & ~followsEscape;
+    const uint64_t sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    prevEscaped = sequencesStartingOnEvenBits < oddSequenceStarts ? 1 : 0;
+    const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+    return (EVEN_BITS ^ invertMask) & followsEscape;
+}
+
+// Sets every bit from a set bit up to the next set bit exclusive,
+// which turns quote positions into the mask of string contents.
+inline uint64_t prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+// Tracks the bytes inside double-quoted strings across blocks
+struct StringScanner
+{
+    uint64_t prevEscaped = 0;
+    uint64_t prevInString = 0;
+    // The bytes of the last block escaped by a backslash
+    uint64_t escaped = 0;
+
+    // Returns the mask of the bytes inside strings, including the opening quotes
+    uint64_t next(uint64_t quotes, uint64_t backslashes)
+    {
+        escaped = escapedMask(backslashes, prevEscaped);
+        quotes &= ~escaped;
+        const uint64_t inString = prefixXor(quotes) ^ prevInString;
+        prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+        return inString;
+    }
+};
+
+// Walks `opens` and `closes` bits of one block, starting with `depth`.
+// Returns the bit index of the close that brings the depth to zero, or 64.
+inline unsigned closeInBlock(uint64_t opens, uint64_t closes, int64_t& depth)
+{
+    // The block can't close the bracket, skip it as a whole
+    const int64_t closeCount = std::popcount(closes);
+    if (closeCount < depth)
+    {
+        depth += std::popcount(opens) - closeCount;
+        return 64;
+    }
+
+    uint64_t all = opens | closes;
+    while (all)
+    {
+        const uint64_t bit = all & (0 - all);
+        if (opens & bit)
+            ++depth;
+        else if (--depth == 0)
+            return static_cast<unsigned>(std::countr_zero(bit));
+        all &= all - 1;
+    }
+    return 64;
+}
+
+// Returns the position of the quote that closes a string whose contents start at `from`, or npos.
+// A quote is escaped by an odd run of backslashes before it, the runs are found with the masks of 64-byte blocks.
+inline size_t closingQuote(std::string_view str, size_t from)
+{
+    // most strings have no escapes, so the first quote is checked right away
+    const size_t first = str.find('"', from);
+    if (first == std::string_view::npos || first == from || str[first - 1] != '\\')
+        return first;
+
+    const char chars[] = { '"', '\\' };
+    uint64_t prevEscaped = 0;
+    size_t result = std::string_view::npos;
+    forEachBlock(str, from, chars, [&](size_t pos, const uint64_t* masks) {
+        const uint64_t quotes = masks[0] & ~escapedMask(masks[1], prevEscaped);
+        if (quotes == 0)
+            return false;
+        result = pos + static_cast<size_t>(std::countr_zero(quotes));
+        return true;
+    });
+    return result;
+}
+
+// Finds the delimiters of delimiter-separated fields, 64 bytes at a time.
+// With `quoted` the delimiters between double quotes are skipped, so `"a;b";c` has two fields:
+// the quotes toggle the quoted state, and a doubled quote `""` inside a quoted field toggles it twice.
+// Up to MAX_CLASSIFY_CHARS chars, the quote included, are classified by the kernel, more by a scalar loop.
+class FieldSplitter
+{
+private:
+    char m_chars[MAX_CLASSIFY_CHARS] = {};
+    size_t m_count = 0;
+    size_t m_delims = 0;
+    bool m_quoted = false;
+    bool m_scalar = false;
+    CharClass m_class;
+    // all ones when the previous block ended inside quotes
+    uint64_t m_prevInQuotes = 0;
+
+    // Turns the delimiter and quote masks of a block into the mask of the delimiters outside quotes
+    uint64_t separators(uint64_t delims, uint64_t quotes)
+    {
+        if (!m_quoted)
+            return delims;
+        const uint64_t inQuotes = prefixXor(quotes) ^ m_prevInQuotes;
+        m_prevInQuotes = static_cast<uint64_t>(static_cast<int64_t>(inQuotes) >> 63);
+        return delims & ~inQuotes;
+    }
+
+    uint64_t scalarBlock(const char* data, size_t size)
+    {
+        uint64_t delims = 0;
+        uint64_t quotes = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            delims |= static_cast<uint64_t>(m_class.contains(data[i])) << i;
+            quotes |= static_cast<uint64_t>(m_quoted && data[i] == '"') << i;
+        }
+        return separators(delims & ~quotes, quotes);
+    }
+
+    uint64_t combine(const uint64_t* masks)
+    {
+        uint64_t delims = 0;
+        for (size_t c = 0; c < m_delims; ++c)
+            delims |= masks[c];
+        return separators(delims, m_quoted ? masks[m_delims] : 0);
+    }
+
+public:
+    FieldSplitter(std::string_view delims, bool quoted)
+        : m_quoted(quoted)
+        , m_class(delims)
+    {
+        m_delims = delims.size();
+        m_count = m_delims + quoted;
+        m_scalar = m_count > MAX_CLASSIFY_CHARS;
+        if (m_scalar)
+            return;
+        std::copy(delims.begin(), delims.end(), m_chars);
+        if (quoted)
+            m_chars[m_delims] = '"';
+    }
+
+    // Stores the masks of the delimiters in up to `blocks` blocks of `str` from `pos` on and returns their number.
+    // The blocks must come in order, and a tail shorter than 64 bytes comes alone.
+    size_t next(std::string_view str, size_t pos, size_t blocks, uint64_t* separators)
+    {
+        blocks = m_scalar ? 0 : std::min(blocks, (str.size() - pos) / 64);
+        if (blocks == 0)
+        {
+            const size_t size = std::min<size_t>(str.size() - pos, 64);
+            if (m_scalar)
+            {
+                *separators = scalarBlock(str.data() + pos, size);
+                return 1;
+            }
+
+            // the tail is copied to a padded block like in forEachBlock
+            uint64_t masks[MAX_CLASSIFY_CHARS];
+            alignas(64) char tail[64] = {};
+            std::memcpy(tail, str.data() + pos, size);
+            kernels().classify(tail, 1, m_chars, m_count, masks);
+            for (size_t c = 0; c < m_count; ++c)
+                masks[c] &= (1ull << size) - 1;
+            *separators = combine(masks);
+            return 1;
+        }
+
+        uint64_t masks[MAX_CLASSIFY_CHARS * MAX_CLASSIFY_BLOCKS];
+        kernels().classify(str.data() + pos, blocks, m_chars, m_count, masks);
+        for (size_t block = 0; block < blocks; ++block)
+            separators[block] = combine(masks + block * m_count);
+        return blocks;
+    }
+
+    // Calls `onBlock(pos, delimiters)` for the blocks from `from` on until it returns true.
+    // The blocks are classified in batches that grow like in forEachBlock.
+    template <typename OnBlock>
+    bool forEachBlock(std::string_view str, size_t from, OnBlock&& onBlock)
+    {
+        uint64_t separators[MAX_CLASSIFY_BLOCKS];
+        size_t batch = 1;
+        size_t pos = from;
+        while (pos < str.size())
+        {
+            const size_t blocks = next(str, pos, batch, separators);
+            for (size_t block = 0; block < blocks; ++block, pos += 64)
+            {
+                if (onBlock(pos, separators[block]))
+                    return true;
+            }
+            batch = std::min(batch * 2, MAX_CLASSIFY_BLOCKS);
+        }
+        return false;
+    }
+};
+
+// Drops the quotes around a quoted field, the doubled quotes inside are kept as they are
+inline std::string_view unquoteField(std::string_view field, bool quoted)
+{
+    if (quoted && field.size() >= 2 && field.front() == '"' && field.back() == '"')
+        return field.substr(1, field.size() - 2);
+    return field;
+}
+
+// Appends the code point as UTF-8 and returns the position after it
+inline char* appendUtf8(char* out, uint32_t code)
+{
+    if (code < 0x80)
+    {
+        *out++ = static_cast<char>(code);
+    }
+    else if (code < 0x800)
+    {
+        *out++ = static_cast<char>(0xC0 | (code >> 6));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000)
+    {
+        *out++ = static_cast<char>(0xE0 | (code >> 12));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else
+    {
+        *out++ = static_cast<char>(0xF0 | (code >> 18));
+        *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (code & 0x3F));
+    }
+    return out;
+}
+
+// Parses the 4 hex digits of a \u escape, returns false if they aren't hex
+inline bool parseHex4(const char* data, uint32_t& code)
+{
+    code = 0;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const char c = data[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            digit = (c | 0x20) - 'a' + 10;
+        else
+            return false;
+        code = (code << 4) | digit;
+    }
+    return true;
+}
+
+// The bit of a name length in a mask of the lengths of the names looked up, so the other names
+// are skipped without hashing. The names longer than 63 bytes share the last bit and are always hashed.
+constexpr uint64_t lengthBit(size_t size)
+{
+    return 1ull << (size < 64 ? size : 63);
+}
+
+// Decodes the contents of a Json string to `out`, which has room for at least `raw.size()` bytes:
+// no escape is shorter than what it decodes to. The runs without escapes are copied as a whole.
+// Returns the end of the decoded data, or nullptr for an invalid escape or a lone surrogate.
+inline char* decodeJsonString(std::string_view raw, char* out)
+{
+    size_t pos = 0;
+    while (true)
+    {
+        const size_t backslash = raw.find('\\', pos);
+        const size_t run = (backslash == std::string_view::npos ? raw.size() : backslash) - pos;
+        std::memcpy(out, raw.data() + pos, run);
+        out += run;
+        if (backslash == std::string_view::npos)
+            return out;
+
+        if (backslash + 1 == raw.size())
+            return nullptr;
+        pos = backslash + 2;
+        switch (raw[backslash + 1])
+        {
+        case '"': *out++ = '"'; break;
+        case '\\': *out++ = '\\'; break;
+        case '/': *out++ = '/'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u':
+        {
+            uint32_t code;
+            if (raw.size() - pos < 4 || !parseHex4(raw.data() + pos, code))
+                return nullptr;
+            pos += 4;
+            if (code >= 0xDC00 && code <= 0xDFFF)
+                return nullptr;
+            // a high surrogate must be followed by an escaped low one
+            if (code >= 0xD800 && code <= 0xDBFF)
+            {
+                uint32_t low;
+                if (raw.size() - pos < 6 || raw[pos] != '\\' || raw[pos + 1] != 'u'
+                    || !parseHex4(raw.data() + pos + 2, low) || low < 0xDC00 || low > 0xDFFF)
+                    return nullptr;
+                pos += 6;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            out = appendUtf8(out, code);
+            break;
+        }
+        default:
+            return nullptr;
+        }
+    }
+}
+
+// Returns the position after the `end` that closes an already opened `start`, or npos.
+// The scan starts with `from`.
+inline size_t closeBracket(std::string_view str, size_t from, char start, char end)
+{
+    const char chars[] = { start, end };
+    int64_t depth = 1;
+    size_t result = std::string_view::npos;
+    forEachBlock(str, from, chars, [&](size_t pos, const uint64_t* masks) {
+        const unsigned bit = closeInBlock(masks[0], masks[1], depth);
+        if (bit == 64)
+            return false;
+        result = pos + bit + 1;
+        return true;
+    });
+    return result;
+}
+
+// Finds the first `start` outside double-quoted strings and the `end` that closes it,
+// ignoring the brackets inside the strings and the ones escaped by a backslash. Returns {start position, position after the end}.
+inline std::pair<size_t, size_t> balancedOutsideStrings(std::string_view str, char start, char end)
+{
+    const char chars[] = { start, end, '"', '\\' };
+    StringScanner strings;
+    int64_t depth = 0;
+    size_t startPos = std::string_view::npos;
+    size_t endPos = std::string_view::npos;
+    forEachBlock(str, 0, chars, [&](size_t pos, const uint64_t* masks) {
+        // an escaped bracket is a literal character, even outside of a string
+        const uint64_t outside = ~strings.next(masks[2], masks[3]) & ~strings.escaped;
+        uint64_t opens = masks[0] & outside;
+        uint64_t closes = masks[1] & outside;
+        if (depth == 0)
+        {
+            if (opens == 0)
+                return false;
+            const unsigned first = static_cast<unsigned>(std::countr_zero(opens));
+            startPos = pos + first;
+            depth = 1;
+            // forget the bits up to the opening bracket including
+            const uint64_t after = first == 63 ? 0 : ~0ull << (first + 1);
+            opens &= after;
+            closes &= after;
+        }
+
+        const unsigned bit = closeInBlock(opens, closes, depth);
+        if (bit == 64)
+            return false;
+        endPos = pos + bit + 1;
+        return true;
+    });
+
+    if (endPos == std::string_view::npos)
+        return { std::string_view::npos, std::string_view::npos };
+    return { startPos, endPos };
+}
+
+// Checks that all 8 bytes of `word` are ASCII digits
+inline bool isEightDigits(uint64_t word)
+{
+    return (((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+        == 0x3333333333333333ull);
+}
+
+// Converts 8 ASCII digits loaded in little-endian order with three multiplications
+inline uint32_t parseEightDigits(uint64_t word)
+{
+    constexpr uint64_t MASK = 0x000000FF000000FFull;
+    constexpr uint64_t MUL1 = 100 + (1000000ull << 32);
+    constexpr uint64_t MUL2 = 1 + (10000ull << 32);
+    word -= 0x3030303030303030ull;
+    word = (word * 10) + (word >> 8);
+    word = (((word & MASK) * MUL1) + (((word >> 16) & MASK) * MUL2)) >> 32;
+    return static_cast<uint32_t>(word);
+}
+
+// Parses the decimal digits at [begin, end) into `value`.
+// Never reads past `end`, doesn't depend on the locale and doesn't touch errno.
+// Returns the end of the digits, which is `begin` if there are none.
+// `overflow` is set if the number doesn't fit, the returned pointer still skips all the digits.
+inline const char* parseDigits(const char* begin, const char* end, uint64_t& value, bool& overflow)
+{
+    const char* p = begin;
+    uint64_t result = 0;
+    overflow = false;
+
+    // Up to 16 digits 8 at a time. They always fit into uint64_t.
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        for (int chunk = 0; chunk < 2 && end - p >= 8; ++chunk)
+        {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            if (!isEightDigits(word))
+                break;
+            result = result * 100000000 + parseEightDigits(word);
+            p += 8;
+        }
+    }
+
+    // 19 digits always fit too
+    while (p != end && p - begin < 19 && static_cast<unsigned char>(*p - '0') < 10)
+        result = result * 10 + static_cast<unsigned>(*p++ - '0');
+
+    if (p != end && static_cast<unsigned char>(*p - '0') < 10)
+    {
+        // The 20th digit may or may not fit, std::from_chars knows it for sure
+        const auto [ptr, ec] = std::from_chars(begin, end, result);
+        p = ptr;
+        if (ec == std::errc::result_out_of_range)
+        {
+            overflow = true;
+            while (p != end && static_cast<unsigned char>(*p - '0') < 10)
+                ++p;
+        }
+    }
+
+    value = result;
+    return p;
+}
+
+// Parses a number of type T at [begin, end). Leading ASCII whitespace and a '+' sign are accepted,
+// like strtoull/strtoll did; '-' is accepted only for signed and floating-point types.
+// Returns the end of the number, or `begin` if there is no number.
+// `valid` is false if the number is out of range of T.
+template <typename T>
+const char* parseNumber(const char* begin, const char* end, T& value, bool& valid)
+{
+    const char* p = begin;
+    while (p != end && (*p == ' ' || (*p >= '\t' && *p <= '\r')))
+        ++p;
+
+    bool negative = false;
+    if (p != end && (*p == '+' || (*p == '-' && std::is_signed_v<T>)))
+    {
+        negative = *p == '-';
+        ++p;
+        // "+-1" is not a number
+        if (p != end && (*p == '+' || *p == '-'))
+            return begin;
+    }
+
+    const char* stop = p;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        const auto [ptr, ec] = std::from_chars(negative ? p - 1 : p, end, value);
+        if (ptr == (negative ? p - 1 : p) || ec == std::errc::invalid_argument)
+            return begin;
+        stop = ptr;
+        valid = ec == std::errc{};
+    }
+    else
+    {
+        uint64_t magnitude = 0;
+        bool overflow = false;
+        stop = parseDigits(p, end, magnitude, overflow);
+        if (stop == p)
+            return begin;
+
+        constexpr uint64_t MAX = static_cast<uint64_t>(std::numeric_limits<T>::max());
+        if constexpr (std::is_signed_v<T>)
+        {
+            valid = !overflow && magnitude <= MAX + (negative ? 1 : 0);
+            if (valid)
+                value = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+        }
+        else
+        {
+            valid = !overflow && magnitude <= MAX;
+            if (valid)
+                value = static_cast<T>(magnitude);
+        }
+    }
+
+    return stop;
+}
+
+// Checks that the tag at `pos`, after `<` or `</`, is `name` itself and not a longer name
+inline bool xmlIsName(std::string_view str, size_t pos, std::string_view name, bool ignoreCase = false)
+{
+    const auto candidate = str.substr(pos, name.size());
+    if (ignoreCase ? candidate.size() != name.size() || !equalsIgnoreCase(candidate.data(), name.data(), name.size())
+                   : candidate != name)
+        return false;
+    if (pos + name.size() == str.size())
+        return false;
+    const char next = str[pos + name.size()];
+    return next == '>' || next == '/' || next == ' ' || next == '\t' || next == '\r' || next == '\n';
+}
+
+// Returns the position after the `>` of the tag at `pos`, ignoring the ones inside quoted attributes.
+// `>` and both quotes are classified 64 bytes at a time and the quotes are paired within the masks.
+inline size_t xmlTagEnd(std::string_view str, size_t pos)
+{
+    const char chars[] = { '>', '"', '\'' };
+    size_t end = std::string_view::npos;
+    // the mask of the quote that is open at the start of the block, or 0
+    size_t open = 0;
+    forEachBlock(str, pos, chars, [&](size_t block, const uint64_t* masks) {
+        uint64_t rest = ~0ull;
+        while (true)
+        {
+            if (open)
+            {
+                const uint64_t close = masks[open] & rest;
+                if (!close)
+                    return false;
+                rest &= ~((close & (0 - close)) * 2 - 1);
+                open = 0;
+            }
+            const uint64_t next = (masks[0] | masks[1] | masks[2]) & rest;
+            if (!next)
+                return false;
+            const uint64_t bit = next & (0 - next);
+            if (masks[0] & bit)
+            {
+                end = block + std::countr_zero(bit) + 1;
+                return true;
+            }
+            open = masks[1] & bit ? 1 : 2;
+            rest &= ~(bit * 2 - 1);
+        }
+    });
+    return end;
+}
+
+// Returns the position after a comment, CDATA, a processing instruction or a declaration at `pos`,
+// or `pos` itself if it is an ordinary tag
+inline size_t xmlMarkupEnd(std::string_view str, size_t pos)
+{
+    const std::string_view rest = str.substr(pos);
+    std::string_view close;
+    if (rest.starts_with("<!--"))
+        close = "-->";
+    else if (rest.starts_with("<![CDATA["))
+        close = "]]>";
+    else if (rest.starts_with("<?"))
+        close = "?>";
+    else if (rest.starts_with("<!"))
+        close = ">";
+    else
+        return pos;
+
+    const size_t end = find(str, close, pos + 2);
+    return end == std::string_view::npos ? std::string_view::npos : end + close.size();
+}
+
+// Checks the tag that ends before `end`
+inline bool xmlSelfClosing(std::string_view str, size_t end)
+{
+    return end >= 2 && str[end - 2] == '/';
+}
+
+// Finds `<name` or `</name` starting with `from`, where the name is whole. Returns the position of `<`.
+// The name itself is searched, so the tags with other names cost nothing.
+inline size_t findXmlTag(std::string_view str, std::string_view name, size_t from, bool& closing, bool ignoreCase = false)
+{
+    if (name.empty())
+        return std::string_view::npos;
+
+    size_t pos = from + 1;
+    while ((pos = ignoreCase ? ifind(str, name, pos) : find(str, name, pos)) != std::string_view::npos)
+    {
+        if (str[pos - 1] == '<' && xmlIsName(str, pos, name, ignoreCase))
+        {
+            closing = false;
+            return pos - 1;
+        }
+        if (pos >= from + 2 && str[pos - 1] == '/' && str[pos - 2] == '<' && xmlIsName(str, pos, name, ignoreCase))
+        {
+            closing = true;
+            return pos - 2;
+        }
+        ++pos;
+    }
+    return std::string_view::npos;
+}
+
+// Counts the `name` tags from `pos` with `depth` elements open and returns the position after the one
+// that closes them all. If it isn't in `str`, returns npos and leaves `pos` and `depth` where the count
+// can be continued when more data is appended: the tags before `pos` are counted, a tag cut at the end isn't.
+inline size_t xmlElementEndFrom(std::string_view str, size_t& pos, size_t& depth, std::string_view name, bool ignoreCase = false)
+{
+    bool closing = false;
+    size_t tag;
+    while ((tag = findXmlTag(str, name, pos, closing, ignoreCase)) != std::string_view::npos)
+    {
+        const size_t end = xmlTagEnd(str, tag);
+        if (end == std::string_view::npos)
+        {
+            pos = tag;
+            return std::string_view::npos;
+        }
+        if (closing && --depth == 0)
+            return end;
+        if (!closing && !xmlSelfClosing(str, end))
+            ++depth;
+        pos = end;
+    }
+    // `</name` without the byte after the name isn't matched yet
+    const size_t overlap = name.size() + 2;
+    if (str.size() > pos + overlap)
+        pos = str.size() - overlap;
+    return std::string_view::npos;
+}
+
+// Returns the position after the `name` element whose start tag is at `start`,
+// with the nested elements of the same name, or npos if it isn't closed in `str`
+inline size_t xmlElementEnd(std::string_view str, size_t start, std::string_view name, bool ignoreCase = false)
+{
+    size_t pos = xmlTagEnd(str, start);
+    if (pos == std::string_view::npos || xmlSelfClosing(str, pos))
+        return pos;
+
+    size_t depth = 1;
+    return xmlElementEndFrom(str, pos, depth, name, ignoreCase);
+}
+
+// Searcher for a pattern that is known only at runtime.
+struct RuntimePattern
+{
+    std::string_view str;
+
+    size_t size() const
+    {
+        return str.size();
+    }
+
+    size_t find(std::string_view haystack, size_t from = 0) const
+    {
+        return detail::find(haystack, str, from);
+    }
+
+    bool isPrefixOf(std::string_view haystack) const
+    {
+        return haystack.starts_with(str);
+    }
+};
+
+}
+
+// A runtime pattern whose ASCII letters match in either case: `ps.to(ignore_case("content-type:"), move_after)`.
+// The case is folded inside the search kernels, the haystack isn't copied or lower-cased.
+struct ignore_case
+{
+    std::string_view str;
+
+    constexpr explicit ignore_case(std::string_view str)
+        : str(str)
+    {}
+
+    size_t size() const
+    {
+        return str.size();
+    }
+
+    size_t find(std::string_view haystack, size_t from = 0) const
+    {
+        return detail::ifind(haystack, str, from);
+    }
+
+    bool isPrefixOf(std::string_view haystack) const
+    {
+        return haystack.size() >= str.size() && detail::equalsIgnoreCase(haystack.data(), str.data(), str.size());
+    }
+};
+
+// Checks that the CPU can run the backend
+inline bool isSearchBackendSupported(SearchBackend backend)
+{
+    return detail::cpuSupports(backend);
+}
+
+// Returns the backend used by the searches
+inline SearchBackend activeSearchBackend()
+{
+    const detail::Kernels& kernels = detail::kernels();
+    if (&kernels == &detail::RESOLVE_KERNELS)
+        return detail::bestSearchBackend();
+    return kernels.backend;
+}
+
+// Forces the backend. Returns false if the CPU doesn't support it.
+inline bool setSearchBackend(SearchBackend backend)
+{
+    if (!detail::cpuSupports(backend))
+        return false;
+    detail::g_kernels.store(&detail::kernelsFor(backend), std::memory_order_relaxed);
+    return true;
+}
+
+// pattern is a search pattern known at compile time, for example `pattern<"\"user_id\":">{}`.
+// The length, the first and the last bytes and the skip table are computed by the compiler,
+// so a search doesn't do any setup per call.
+// Patterns shorter than 4 bytes are searched with memchr, longer ones with the Boyer-Moore-Horspool
+// algorithm. Candidates up to 16 bytes are compared with one or two register-width loads.
+template <FixedString Str>
+struct pattern
+{
+    static constexpr std::string_view str = Str.view();
+    static constexpr size_t length = str.size();
+    static_assert(length > 0, "pattern can't be empty");
+
+    static constexpr char first = str.front();
+    static constexpr char last = str.back();
+
+private:
+    // Packs `count` bytes starting at `offset` the same way memcpy would load them into an uint64_t
+    static constexpr uint64_t makeWord(size_t offset, size_t count)
+    {
+        uint64_t word = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint64_t byte = static_cast<unsigned char>(str[offset + i]);
+            if constexpr (std::endian::native == std::endian::little)
+                word |= byte << (8 * i);
+            else
+                word |= byte << (8 * (7 - i));
+        }
+        return word;
+    }
+
+    static constexpr std::array<uint8_t, 256> makeSkipTable()
+    {
+        std::array<uint8_t, 256> table{};
+        const size_t maxSkip = length < 255 ? length : 255;
+        table.fill(static_cast<uint8_t>(maxSkip));
+        for (size_t i = 0; i + 1 < length; ++i)
+        {
+            const size_t skip = length - 1 - i;
+            table[static_cast<unsigned char>(str[i])] = static_cast<uint8_t>(skip < maxSkip ? skip : maxSkip);
+        }
+        return table;
+    }
+
+    static constexpr uint64_t LOW_WORD = makeWord(0, length < 8 ? length : 8);
+    static constexpr uint64_t HIGH_WORD = length > 8 ? makeWord(8, length < 16 ? length - 8 : 8) : 0;
+    static constexpr std::array<uint8_t, 256> SKIP = makeSkipTable();
+
+public:
+    static constexpr size_t size()
+    {
+        return length;
+    }
+
+    // Checks that the pattern is located at `p`. At least `length` bytes must be readable.
+    static bool matchesAt(const char* p)
+    {
+        if constexpr (length <= 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, p, length);
+            return word == LOW_WORD;
+        }
+        else if constexpr (length <= 16)
+        {
+            uint64_t low = 0;
+            uint64_t high = 0;
+            std::memcpy(&low, p, 8);
+            std::memcpy(&high, p + 8, length - 8);
+            return low == LOW_WORD && high == HIGH_WORD;
+        }
+        else
+        {
+            return p[length - 1] == last && std::memcmp(p, str.data(), length - 1) == 0;
+        }
+    }
+
+    static bool isPrefixOf(std::string_view haystack)
+    {
+        return haystack.size() >= length && matchesAt(haystack.data());
+    }
+
+    static size_t find(std::string_view haystack, size_t from = 0)
+    {
+        if (from > haystack.size() || haystack.size() - from < length)
+            return std::string_view::npos;
+
+        const char* begin = haystack.data();
+        const size_t lastStart = haystack.size() - length;
+        size_t pos = from;
+
+        if constexpr (length < 4)
+        {
+            while (pos <= lastStart)
+            {
+                const void* found = std::memchr(begin + pos, first, lastStart - pos + 1);
+                if (!found)
+                    return std::string_view::npos;
+                pos = static_cast<const char*>(found) - begin;
+                if (length == 1 || matchesAt(begin + pos))
+                    return pos;
+                ++pos;
+            }
+        }
+        else
+        {
+            while (pos <= lastStart)
+            {
+                const char tail = begin[pos + length - 1];
+                if (tail == last && matchesAt(begin + pos))
+                    return pos;
+                pos += SKIP[static_cast<unsigned char>(tail)];
+            }
+        }
+
+        return std::string_view::npos;
+    }
+};
+
+namespace literals
+{
+
+// Creates a compile-time pattern: `"\"user_id\":"_pat`
+template <FixedString Str>
+constexpr pattern<Str> operator""_pat()
+{
+    return {};
+}
+
+}
+
+// Arena is a bump allocator for the memory of one request: the owned data of MultiPattern,
+// JsonIndex, JsonPath, StreamSeeker and decodeJsonString all take a std::pmr::memory_resource.
+// Allocation moves a pointer, deallocation does nothing, and reset() frees everything at once
+// but keeps the largest chunk, so after the first few requests the upstream resource isn't called at all:
+// `Arena arena; for (auto& request : requests) { arena.reset(); JsonIndex index(request, &arena); ... }`
+// It may start with a caller's buffer, for example on the stack. It isn't thread-safe, use one per thread.
+class Arena : public std::pmr::memory_resource
+{
+private:
+    struct Chunk
+    {
+        Chunk* next;
+        size_t size;
+    };
+
+    std::pmr::memory_resource* m_upstream;
+    char* m_buffer = nullptr;
+    size_t m_bufferSize = 0;
+    // the chunks taken from upstream, the newest and the biggest one first
+    Chunk* m_chunks = nullptr;
+    size_t m_nextSize;
+    char* m_current = nullptr;
+    char* m_end = nullptr;
+    bool m_inBuffer = false;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (void* result = bump(bytes, alignment))
+            return result;
+
+        // after reset() the caller's buffer is used first and then the kept chunk
+        if (m_inBuffer && m_chunks)
+        {
+            start(m_chunks);
+            if (void* result = bump(bytes, alignment))
+                return result;
+        }
+
+        const size_t size = std::max(m_nextSize, bytes + alignment + sizeof(Chunk));
+        auto* chunk = static_cast<Chunk*>(m_upstream->allocate(size, alignof(std::max_align_t)));
+        *chunk = Chunk{ m_chunks, size };
+        m_chunks = chunk;
+        m_nextSize = size * 2;
+        start(chunk);
+        return bump(bytes, alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override
+    {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    static char* chunkEnd(Chunk* chunk)
+    {
+        return chunk ? reinterpret_cast<char*>(chunk) + chunk->size : nullptr;
+    }
+
+    void start(Chunk* chunk)
+    {
+        m_current = reinterpret_cast<char*>(chunk + 1);
+        m_end = chunkEnd(chunk);
+        m_inBuffer = false;
+    }
+
+    void* bump(size_t bytes, size_t alignment)
+    {
+        if (!m_current)
+            return nullptr;
+        const auto address = reinterpret_cast<uintptr_t>(m_current);
+        const size_t padding = (alignment - address % alignment) % alignment;
+        if (static_cast<size_t>(m_end - m_current) < padding + bytes)
+            return nullptr;
+        char* result = m_current + padding;
+        m_current = result + bytes;
+        return result;
+    }
+
+    void release(Chunk* chunk)
+    {
+        while (chunk)
+        {
+            Chunk* next = chunk->next;
+            m_upstream->deallocate(chunk, chunk->size, alignof(std::max_align_t));
+            chunk = next;
+        }
+    }
+
+public:
+    // The first chunk is allocated with the first allocation
+    explicit Arena(size_t chunkSize = 4096, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream(upstream)
+        , m_nextSize(std::max(chunkSize, sizeof(Chunk) * 2))
+    {}
+
+    // Allocates from `buffer` first and from `upstream` when it runs out
+    Arena(void* buffer, size_t size, std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream(upstream)
+        , m_buffer(static_cast<char*>(buffer))
+        , m_bufferSize(size)
+        , m_nextSize(std::max(size, sizeof(Chunk) * 2))
+        , m_current(m_buffer)
+        , m_end(m_buffer + size)
+        , m_inBuffer(true)
+    {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() override
+    {
+        release(m_chunks);
+    }
+
+    // Frees all the allocations at once. The largest chunk is kept for the next request, the rest go upstream.
+    void reset()
+    {
+        if (m_chunks)
+        {
+            release(m_chunks->next);
+            m_chunks->next = nullptr;
+        }
+
+        if (m_buffer)
+        {
+            m_current = m_buffer;
+            m_end = m_buffer + m_bufferSize;
+            m_inBuffer = true;
+        }
+        else if (m_chunks)
+        {
+            start(m_chunks);
+        }
+    }
+
+    // Returns the size of the memory taken from upstream
+    size_t capacity() const
+    {
+        size_t result = 0;
+        for (Chunk* chunk = m_chunks; chunk; chunk = chunk->next)
+            result += chunk->size;
+        return result;
+    }
+};
+
+// The result of a search for several patterns: where the match is and which pattern it is
+struct PatternMatch
+{
+    size_t position = std::string_view::npos;
+    size_t index = std::string_view::npos;
+
+    explicit operator bool() const
+    {
+        return position != std::string_view::npos;
+    }
+};
+
+// MultiPattern is a precompiled set of patterns that are searched for at once, in one pass.
+// The leftmost match wins; when several patterns start at the same position, the first one in the set wins.
+// Up to 8 patterns are found with a Teddy kernel: SIMD nibble tables select the positions
+// where the first bytes of some pattern match, and only those are compared.
+// Larger sets are compiled into an Aho-Corasick automaton over classes of bytes,
+// the same tables let it jump over the bytes where no pattern can start.
+// Compile it once and reuse, the construction allocates.
+class MultiPattern
+{
+private:
+    static constexpr size_t TEDDY_MAX_PATTERNS = 8;
+
+    // all the patterns one after another
+    std::pmr::string m_storage;
+    std::pmr::vector<size_t> m_offsets;
+    size_t m_maxSize = 0;
+    // an empty pattern matches right away
+    size_t m_empty = std::string_view::npos;
+
+    // Teddy: the pattern index of each bucket bit
+    bool m_teddy = false;
+    detail::TeddyTables m_tables{};
+    std::array<uint8_t, TEDDY_MAX_PATTERNS> m_bucketPatterns{};
+
+    // Aho-Corasick: a full transition table of states by classes of bytes,
+    // and for each state the index + 1 of the longest pattern that ends there
+    std::array<uint8_t, 256> m_classes{};
+    size_t m_classCount = 1;
+    uint32_t m_shift = 0;
+    std::pmr::vector<uint32_t> m_transitions;
+    std::pmr::vector<uint32_t> m_outputs;
+
+    template <typename Range>
+    void compile(const Range& patterns)
+    {
+        m_offsets.push_back(0);
+        for (std::string_view pattern : patterns)
+        {
+            m_storage.append(pattern);
+            m_offsets.push_back(m_storage.size());
+        }
+
+        size_t nonEmpty = 0;
+        size_t prefix = 3;
+        for (size_t i = 0; i < count(); ++i)
+        {
+            const size_t size = pattern(i).size();
+            m_maxSize = std::max(m_maxSize, size);
+            if (size == 0)
+            {
+                m_empty = std::min(m_empty, i);
+                continue;
+            }
+            ++nonEmpty;
+            prefix = std::min(prefix, size);
+        }
+
+        // the tables find the candidates for Teddy and skip the bytes that start nothing for Aho-Corasick
+        m_teddy = nonEmpty <= TEDDY_MAX_PATTERNS;
+        compileTables(prefix);
+        if (!m_teddy)
+            compileAhoCorasick();
+    }
+
+    // Fills the nibble tables with the first `prefix` bytes of the patterns.
+    // With up to 8 patterns every pattern has its own bucket, otherwise the buckets are shared
+    // and the tables only tell where some pattern may start.
+    void compileTables(size_t prefix)
+    {
+        m_tables.prefix = prefix;
+        size_t bucket = 0;
+        for (size_t i = 0; i < count(); ++i)
+        {
+            const std::string_view str = pattern(i);
+            if (str.empty())
+                continue;
+            if (bucket < TEDDY_MAX_PATTERNS)
+                m_bucketPatterns[bucket] = static_cast<uint8_t>(i);
+            const auto bit = static_cast<uint8_t>(1u << (bucket++ % TEDDY_MAX_PATTERNS));
+            for (size_t k = 0; k < prefix; ++k)
+            {
+                const auto byte = static_cast<uint8_t>(str[k]);
+                m_tables.low[k][byte & 0x0F] |= bit;
+                m_tables.high[k][byte >> 4] |= bit;
+            }
+        }
+    }
+
+    void compileAhoCorasick()
+    {
+        // the bytes that don't occur in the patterns share the class 0
+        for (const char c : m_storage)
+        {
+            auto& byteClass = m_classes[static_cast<uint8_t>(c)];
+            if (byteClass == 0)
+                byteClass = static_cast<uint8_t>(m_classCount++);
+        }
+        // the rows are a power of two long, so a state is its row shifted back
+        m_shift = static_cast<uint32_t>(std::bit_width(m_classCount - 1));
+        const size_t stride = size_t(1) << m_shift;
+
+        // the trie, a missing edge is 0 because no edge leads to the root
+        m_transitions.assign(stride, 0);
+        m_outputs.assign(1, 0);
+        for (size_t i = 0; i < count(); ++i)
+        {
+            uint32_t state = 0;
+            for (const char c : pattern(i))
+            {
+                const size_t edge = state * stride + m_classes[static_cast<uint8_t>(c)];
+                if (m_transitions[edge] == 0)
+                {
+                    m_transitions[edge] = static_cast<uint32_t>(m_outputs.size());
+                    m_outputs.push_back(0);
+                    m_transitions.resize(m_transitions.size() + stride, 0);
+                }
+                state = m_transitions[edge];
+            }
+            // the same pattern twice keeps the first index
+            if (state != 0 && m_outputs[state] == 0)
+                m_outputs[state] = static_cast<uint32_t>(i + 1);
+        }
+
+        // breadth-first, the missing edges become the edges of the failure state
+        std::pmr::vector<uint32_t> failures(m_outputs.size(), 0, m_outputs.get_allocator());
+        std::pmr::vector<uint32_t> queue(m_outputs.get_allocator());
+        queue.reserve(m_outputs.size());
+        for (size_t c = 0; c < m_classCount; ++c)
+        {
+            if (const uint32_t next = m_transitions[c])
+                queue.push_back(next);
+        }
+        for (size_t head = 0; head < queue.size(); ++head)
+        {
+            const uint32_t state = queue[head];
+            const uint32_t failure = failures[state];
+            // a state without its own pattern reports the longest one that ends there
+            if (m_outputs[state] == 0)
+                m_outputs[state] = m_outputs[failure];
+
+            for (size_t c = 0; c < m_classCount; ++c)
+            {
+                uint32_t& next = m_transitions[state * stride + c];
+                const uint32_t fallback = m_transitions[failure * stride + c];
+                if (next == 0)
+                {
+                    next = fallback;
+                    continue;
+                }
+                failures[next] = fallback;
+                queue.push_back(next);
+            }
+        }
+
+        // the scan follows rows, not states, to keep a multiplication out of its dependency chain
+        for (auto& next : m_transitions)
+            next <<= m_shift;
+    }
+
+    // Checks the patterns that could start at `from` before the empty one
+    PatternMatch matchEmpty(std::string_view haystack, size_t from) const
+    {
+        for (size_t i = 0; i < m_empty; ++i)
+        {
+            if (haystack.substr(from).starts_with(pattern(i)))
+                return { from, i };
+        }
+        return { from, m_empty };
+    }
+
+    PatternMatch findTeddy(std::string_view haystack, size_t from) const
+    {
+        uint8_t buckets[64];
+        size_t pos = from;
+        while (pos < haystack.size())
+        {
+            const size_t found = detail::kernels().teddy(m_tables, haystack.data() + pos, haystack.size() - pos, buckets);
+            if (found == std::string_view::npos)
+                return {};
+
+            const size_t base = pos + found;
+            size_t last = 0;
+            for (size_t j = 0; j < 64; ++j)
+            {
+                // the buckets are in the order of the patterns
+                for (uint32_t bits = buckets[j]; bits; bits &= bits - 1)
+                {
+                    last = j;
+                    const size_t index = m_bucketPatterns[std::countr_zero(bits)];
+                    if (haystack.substr(base + j).starts_with(pattern(index)))
+                        return { base + j, index };
+                }
+            }
+            pos = base + last + 1;
+        }
+        return {};
+    }
+
+    PatternMatch findAhoCorasick(std::string_view haystack, size_t from) const
+    {
+        PatternMatch best;
+        uint8_t buckets[64];
+        // the positions of [base, base + 64) where some pattern may start
+        uint64_t candidates = 0;
+        size_t base = 0;
+        uint32_t row = 0;
+        size_t i = from;
+        while (i < haystack.size())
+        {
+            if (row == 0)
+            {
+                // nothing is pending, a new match would start after the best one
+                if (best)
+                    break;
+
+                const size_t offset = i - base;
+                uint64_t next = offset < 64 ? candidates & (~0ull << offset) : 0;
+                if (next == 0)
+                {
+                    const size_t found = detail::kernels().teddy(m_tables, haystack.data() + i, haystack.size() - i, buckets);
+                    if (found == std::string_view::npos)
+                        break;
+                    base = i + found;
+                    candidates = 0;
+                    for (size_t j = 0; j < 64; ++j)
+                        candidates |= uint64_t(buckets[j] != 0) << j;
+                    next = candidates;
+                }
+                i = base + static_cast<size_t>(std::countr_zero(next));
+            }
+            // a match that starts before the best one would have ended already
+            else if (best && i >= best.position + m_maxSize)
+            {
+                break;
+            }
+
+            row = m_transitions[row + m_classes[static_cast<uint8_t>(haystack[i])]];
+            if (const uint32_t output = m_outputs[row >> m_shift])
+            {
+                const size_t index = output - 1;
+                const size_t start = i + 1 - pattern(index).size();
+                if (start < best.position || (start == best.position && index < best.index))
+                    best = { start, index };
+            }
+            ++i;
+        }
+        return best;
+    }
+
+public:
+    // The tables are allocated from `resource`, for example an Arena
+    MultiPattern(std::initializer_list<std::string_view> patterns,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_storage(resource)
+        , m_offsets(resource)
+        , m_transitions(resource)
+        , m_outputs(resource)
+    {
+        compile(patterns);
+    }
+
+    // Any range of strings, for example std::vector<std::string>
+    template <typename Range>
+        requires requires(const Range& range) { std::string_view(*std::begin(range)); }
+    explicit MultiPattern(const Range& patterns, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_storage(resource)
+        , m_offsets(resource)
+        , m_transitions(resource)
+        , m_outputs(resource)
+    {
+        compile(patterns);
+    }
+
+    // Returns the number of patterns
+    size_t count() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    std::string_view pattern(size_t index) const
+    {
+        return std::string_view(m_storage).substr(m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+    }
+
+    // Finds the leftmost match at `from` or after it
+    PatternMatch find(std::string_view haystack, size_t from = 0) const
+    {
+        if (from > haystack.size())
+            return {};
+        if (m_empty != std::string_view::npos)
+            return matchEmpty(haystack, from);
+        return m_teddy ? findTeddy(haystack, from) : findAhoCorasick(haystack, from);
+    }
+};
+
+template <typename... Fields>
+class schema;
+class CachedSeeker;
+class UncheckedSeeker;
+class SeekChain;
+
+// PatternSeeker is a class that is easy to use for parsing small strings with a predefined pattern.
+// This class is just a display of the string passed in the constructor.
+// Because of this, the object is very lightweight and can be copied at zero cost.
+// Therefore, the responsibility for the lifetime of the original string falls on the developer.
+// PatternSeeker also allows you to parse Json and XML.
+// The author strongly recommends using appropriate parsers, however,
+// this class is convenient because it doesn't make a copy of the data
+// and allows you to easily and quickly parse a large structure and not use complex and heavy regular expressions.
+// For better performance, this class offers the user to decide for himself when to move the pointer and when not.
+class PatternSeeker
+{
+private:
+    static constexpr const char* EMPTY_STR = "";
+    static constexpr std::string_view DOUBLE_QUOTE = "\"";
+    // the stack memory of the sets that toAnyOf and extractUntilAnyOf compile per call
+    static constexpr size_t ONE_OFF_PATTERNS_BUFFER = 512;
+
+    std::string_view m_str;
+    const char* m_originalPointer;
+    // the view is known to be ASCII, see markAscii()
+    bool m_ascii = false;
+
+    PatternSeeker(std::string_view str, const char* originalPointer)
+        : m_str(str.data() ? str : EMPTY_STR)
+        , m_originalPointer(originalPointer)
+    {}
+
+    PatternSeeker()
+        : m_str(EMPTY_STR)
+        , m_originalPointer(EMPTY_STR)
+    {}
+
+    // Finds `prefix + body + suffix` without building the concatenated string.
+    // Returns the position of `prefix`, which is never less than `from`.
+    template <typename Pattern>
+    size_t findFramed(std::string_view prefix, const Pattern& body, std::string_view suffix, size_t from = 0) const
+    {
+        size_t pos = from + prefix.size();
+        while ((pos = body.find(m_str, pos)) != std::string_view::npos)
+        {
+            const size_t start = pos - prefix.size();
+            if (m_str.compare(start, prefix.size(), prefix) == 0
+                && m_str.substr(pos + body.size()).starts_with(suffix))
+            {
+                return start;
+            }
+            ++pos;
+        }
+
+        return std::string_view::npos;
+    }
+
+    // The number of bytes of the first `n` code points
+    size_t charsToBytes(size_t n) const
+    {
+        return m_ascii ? std::min(n, m_str.size()) : detail::utf8Advance(m_str, n);
+    }
+
+    // Returns the data before `pos` and moves the pointer after the char at `pos` for move_after
+    PatternSeeker extractUntilOneOfAt(size_t pos, MoveMode mode)
+    {
+        if (pos == std::string_view::npos)
+        {
+            return {};
+        }
+
+        auto substr = m_str.substr(0, pos);
+
+        if (mode == move_after)
+            m_str.remove_prefix(pos + 1);
+
+        return PatternSeeker(substr, m_originalPointer);
+    }
+
+    // Returns [startIndex, endIndex) and moves the pointer before or after it
+    PatternSeeker spanAt(size_t startIndex, size_t endIndex, MoveMode mode)
+    {
+        auto substr = m_str.substr(startIndex, endIndex - startIndex);
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(startIndex);
+            break;
+        case move_after:
+            m_str.remove_prefix(endIndex);
+            break;
+        case none:
+            break;
+        }
+
+        return PatternSeeker{substr, m_originalPointer};
+    }
+
+    // The implementations below are shared by runtime and compile-time patterns.
+
+    template <typename Pattern>
+    bool expectImpl(const Pattern& expected)
+    {
+        if (expected.isPrefixOf(m_str))
+        {
+            m_str.remove_prefix(expected.size());
+            return true;
+        }
+
+        return false;
+    }
+
+    template <typename Pattern>
+    bool toImpl(const Pattern& expected, MoveMode mode)
+    {
+        PATTERN_SEEKER_STATS(to);
+        const size_t pos = expected.find(m_str);
+        if (pos == std::string_view::npos)
+        {
+            PATTERN_SEEKER_STATS_RESULT(false, m_str.size());
+            return false;
+        }
+        PATTERN_SEEKER_STATS_RESULT(true, pos + expected.size());
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(pos);
+            break;
+        case move_after:
+            m_str.remove_prefix(pos + expected.size());
+            break;
+        case none:
+            // don't move
+            break;
+        }
+
+        return true;
+    }
+
+    template <typename From, typename To>
+    PatternSeeker extractImpl(const From& from, const To& to, MoveMode mode)
+    {
+        PATTERN_SEEKER_STATS(extract);
+        auto startIt = from.find(m_str);
+        if (startIt == std::string::npos)
+        {
+            PATTERN_SEEKER_STATS_RESULT(false, m_str.size());
+            return {};
+        }
+        startIt += from.size();
+
+        const auto endIt = to.find(m_str, startIt);
+        if (endIt == std::string::npos) {
+            PATTERN_SEEKER_STATS_RESULT(false, m_str.size());
+            return {};
+        }
+        PATTERN_SEEKER_STATS_RESULT(true, endIt + to.size());
+
+        auto substr = m_str.substr(startIt, endIt - startIt);
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(startIt - from.size());
+            break;
+        case move_after:
+            m_str.remove_prefix(endIt + to.size());
+            break;
+        case none:
+            // don't move
+            break;
+        default:
+            break;
+        }
+
+        return PatternSeeker(substr, m_originalPointer);
+    }
+
+    template <typename To>
+    PatternSeeker extractImpl(const To& to, MoveMode mode)
+    {
+        PATTERN_SEEKER_STATS(extract);
+        const auto endIt = to.find(m_str);
+        if (endIt == std::string::npos)
+        {
+            PATTERN_SEEKER_STATS_RESULT(false, m_str.size());
+            return {};
+        }
+        PATTERN_SEEKER_STATS_RESULT(true, endIt + to.size());
+
+        auto substr = m_str.substr(0, endIt);
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(endIt);
+            break;
+        case move_after:
+            m_str.remove_prefix(endIt + to.size());
+            break;
+        case none:
+            // don't move
+            break;
+        default:
+            break;
+        }
+
+        return PatternSeeker(substr, m_originalPointer);
+    }
+
+    // getXmlTag for both the exact and the case-insensitive names
+    PatternSeeker getXmlTagImpl(std::string_view prop, bool ignoreCase, MoveMode mode)
+    {
+        PATTERN_SEEKER_STATS(xml_tag);
+        // a closing tag before the opening one is skipped
+        bool closing = false;
+        size_t startPos = detail::findXmlTag(m_str, prop, 0, closing, ignoreCase);
+        while (startPos != std::string::npos && closing)
+            startPos = detail::findXmlTag(m_str, prop, startPos + 1, closing, ignoreCase);
+        const size_t endPos = startPos == std::string::npos ? startPos
+                                                            : detail::xmlElementEnd(m_str, startPos, prop, ignoreCase);
+        PATTERN_SEEKER_STATS_RESULT(endPos != std::string::npos, endPos != std::string::npos ? endPos : m_str.size());
+        if (endPos == std::string::npos)
+            return {};
+
+        auto substr = m_str.substr(startPos, endPos - startPos);
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(startPos);
+            break;
+        case move_after:
+            m_str.remove_prefix(endPos);
+            break;
+        default:
+            break;
+        }
+
+        return PatternSeeker{substr, m_originalPointer};
+    }
+
+    template <typename Pattern>
+    PatternSeeker getJsonPropImpl(const Pattern& prop)
+    {
+        PATTERN_SEEKER_STATS(json_prop);
+        auto copy = *this;
+        const size_t pos = copy.findFramed(DOUBLE_QUOTE, prop, DOUBLE_QUOTE);
+        if (pos == std::string_view::npos)
+        {
+            PATTERN_SEEKER_STATS_RESULT(false, m_str.size());
+            return {};
+        }
+        copy.m_str.remove_prefix(pos + prop.size() + 2 * DOUBLE_QUOTE.size());
+        auto value = copy.jsonValueAfterName();
+        PATTERN_SEEKER_STATS_RESULT(value.m_str.data() != EMPTY_STR, copy.m_str.data() - m_str.data());
+        return value;
+    }
+
+    // Returns the Json value that follows a property name. The pointer must be right after the closing quote.
+    PatternSeeker jsonValueAfterName()
+    {
+        skipWhiteSpaces();
+        if (!expect(":"))
+            return {};
+
+        skipWhiteSpaces();
+        if (expect(DOUBLE_QUOTE))
+        {
+            const size_t close = closingQuote(0);
+            if (close == std::string_view::npos)
+                return {};
+            return PatternSeeker(m_str.substr(0, close), m_originalPointer);
+        }
+
+        if (startsWith("["))
+            return extract('[', ']');
+
+        if (startsWith("{"))
+            return extract('{', '}');
+
+        // the class is built once, not per value
+        static constexpr CharClass SCALAR_END(", \r\n]}");
+        return extractUntilOneOf(SCALAR_END);
+    }
+
+    // Takes the Json value at the current position, after whitespace, and moves the pointer after it.
+    // Strings come without quotes, objects and arrays with their brackets, the brackets inside strings are ignored.
+    // Returns false if there is no value, an empty string is a value.
+    bool takeJsonValue(PatternSeeker& value)
+    {
+        // a scalar ends with a comma, a bracket or a whitespace
+        static constexpr CharClass SCALAR = ~CharClass(", \t\n\v\f\r]}");
+
+        skipWhiteSpaces();
+        if (m_str.empty())
+            return false;
+
+        const char first = m_str[0];
+        if (first == '"')
+        {
+            const size_t close = closingQuote(1);
+            if (close == std::string_view::npos)
+                return false;
+            value = PatternSeeker(m_str.substr(1, close - 1), m_originalPointer);
+            m_str.remove_prefix(close + 1);
+            return true;
+        }
+
+        if (first == '{' || first == '[')
+        {
+            value = extractQuoteAware(first, first == '{' ? '}' : ']', move_after);
+            return value.isNotEmpty();
+        }
+
+        value = takeWhile(SCALAR);
+        return value.isNotEmpty();
+    }
+
+    // Returns the position of the quote that closes a string whose contents start at `from`
+    size_t closingQuote(size_t from) const
+    {
+        return detail::closingQuote(m_str, from);
+    }
+
+    friend class JsonPath;
+    template <typename... Fields>
+    friend class schema;
+    friend class CachedSeeker;
+    friend class UncheckedSeeker;
+    friend class SeekChain;
+
+    // Returns the contents of the tag returned by getXmlTag.
+    // It always ends with the closing tag, so there is no need to search for it again.
+    PatternSeeker xmlTagBody() const
+    {
+        const size_t startPos = detail::xmlTagEnd(m_str, 0);
+        if (detail::xmlSelfClosing(m_str, startPos))
+            return PatternSeeker{m_str.substr(startPos), m_originalPointer};
+        const size_t endPos = m_str.rfind('<');
+        return PatternSeeker{m_str.substr(startPos, endPos - startPos), m_originalPointer};
+    }
+
+    // Calls `onName(open, close)` with the positions of the quotes of every string that may be a Json name,
+    // until `remaining` becomes zero. Names are the strings followed by a colon, maybe after some whitespace.
+    // They are found with the bitmasks of 64-byte blocks: a string followed by a comma
+    // or a closing bracket is a value for sure, the rest are checked by `onName`, see valueAfterName.
+    template <typename OnName>
+    void forEachJsonName(const size_t& remaining, OnName&& onName) const
+    {
+        const char chars[] = { '"', '\\', ',', '}', ']' };
+        detail::StringScanner strings;
+        size_t lastOpen = std::string_view::npos;
+        detail::forEachBlock(m_str, 0, chars, [&](size_t pos, const uint64_t* masks) {
+            const uint64_t inString = strings.next(masks[0], masks[1]);
+            const uint64_t quotes = masks[0] & ~strings.escaped;
+            const uint64_t opens = quotes & inString;
+            const uint64_t valueEnds = (masks[2] | masks[3] | masks[4]) >> 1;
+            // the byte after the last one of the block is unknown, so it is checked anyway
+            uint64_t names = quotes & ~inString & ~(valueEnds & ~(1ull << 63));
+
+            for (; names && remaining; names &= names - 1)
+            {
+                const unsigned bit = static_cast<unsigned>(std::countr_zero(names));
+                const uint64_t before = opens & ((1ull << bit) - 1);
+                const size_t open = before ? pos + 63 - std::countl_zero(before) : lastOpen;
+                if (open != std::string_view::npos)
+                    onName(open, pos + bit);
+            }
+
+            if (opens)
+                lastOpen = pos + 63 - std::countl_zero(opens);
+            return remaining == 0;
+        });
+    }
+
+    // Returns the value of a Json name whose closing quote is at `close`,
+    // false if the string isn't followed by a colon and so is a value, not a name
+    bool valueAfterName(size_t close, PatternSeeker& value) const
+    {
+        auto copy = *this;
+        copy.m_str.remove_prefix(close + 1);
+        copy.skipWhiteSpaces();
+        if (!copy.startsWith(":"))
+            return false;
+
+        value = copy.jsonValueAfterName();
+        return true;
+    }
+
+public:
+    // A structural index of a Json document for repeated queries, see below
+    class JsonIndex;
+    // Lazy ranges of Json array elements, of sibling XML tags and of delimiter-separated fields, see below
+    class JsonElements;
+    class XmlChildren;
+    class Fields;
+
+    PatternSeeker(std::string_view str)
+        : m_str(str.data() ? str : EMPTY_STR)
+        , m_originalPointer(m_str.data())
+    {}
+
+    // Returns the size of the displayed string
+    size_t size() const
+    {
+        return m_str.size();
+    }
+
+    // Checks the string for emptiness
+    bool isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    // Checking for non-emptiness (for better readability)
+    bool isNotEmpty() const
+    {
+        return size() != 0;
+    }
+
+    // Returns the string_view of the visible part
+    std::string_view to_string_view() const
+    {
+        return m_str;
+    }
+
+    // Returns the string of the visible part
+    std::string to_string() const
+    {
+        return std::string{ m_str.data(), m_str.size() };
+    }
+
+    // check what next and move the pointer after `expected`
+    // return true if found `expected`
+    bool expect(std::string_view expected)
+    {
+        return expectImpl(detail::RuntimePattern{expected});
+    }
+
+    template <FixedString Str>
+    bool expect(pattern<Str> expected)
+    {
+        return expectImpl(expected);
+    }
+
+    // The ignore_case overloads below match the ASCII letters in either case
+    bool expect(ignore_case expected)
+    {
+        return expectImpl(expected);
+    }
+
+    // Check what next and don't move the pointer
+    bool startsWith(std::string_view expected) const
+    {
+        return m_str.starts_with(expected);
+    }
+
+    template <FixedString Str>
+    bool startsWith(pattern<Str> expected) const
+    {
+        return expected.isPrefixOf(m_str);
+    }
+
+    bool startsWith(ignore_case expected) const
+    {
+        return expected.isPrefixOf(m_str);
+    }
+
+    // Find the `expected` string and move the pointer after `expected`
+    bool to(std::string_view expected, MoveMode mode=none)
+    {
+        return toImpl(detail::RuntimePattern{expected}, mode);
+    }
+
+    template <FixedString Str>
+    bool to(pattern<Str> expected, MoveMode mode=none)
+    {
+        return toImpl(expected, mode);
+    }
+
+    bool to(ignore_case expected, MoveMode mode=none)
+    {
+        return toImpl(expected, mode);
+    }
+
+    // Extract data `from` and `to` the desired strings.
+    PatternSeeker extract(std::string_view from, std::string_view to, MoveMode mode=none)
+    {
+        return extractImpl(detail::RuntimePattern{from}, detail::RuntimePattern{to}, mode);
+    }
+
+    template <FixedString From, FixedString To>
+    PatternSeeker extract(pattern<From> from, pattern<To> to, MoveMode mode=none)
+    {
+        return extractImpl(from, to, mode);
+    }
+
+    PatternSeeker extract(ignore_case from, ignore_case to, MoveMode mode=none)
+    {
+        return extractImpl(from, to, mode);
+    }
+
+    // Extract data from current position and `to` the desired strings.
+    PatternSeeker extract(std::string_view to, MoveMode mode=none)
+    {
+        return extractImpl(detail::RuntimePattern{to}, mode);
+    }
+
+    template <FixedString To>
+    PatternSeeker extract(pattern<To> to, MoveMode mode=none)
+    {
+        return extractImpl(to, mode);
+    }
+
+    PatternSeeker extract(ignore_case to, MoveMode mode=none)
+    {
+        return extractImpl(to, mode);
+    }
+
+    // The reverse searches below read the view from its end, so finding something near the end
+    // of a large buffer costs the distance from the end, not the size.
+
+    // Finds the last `expected` and moves the pointer before or after it
+    bool rto(std::string_view expected, MoveMode mode=none)
+    {
+        PATTERN_SEEKER_STATS(to);
+        const size_t pos = detail::rfind(m_str, expected);
+        PATTERN_SEEKER_STATS_RESULT(pos != std::string_view::npos, pos != std::string_view::npos ? m_str.size() - pos : m_str.size());
+        if (pos == std::string_view::npos)
+            return false;
+
+        if (mode == move_before)
+            m_str.remove_prefix(pos);
+        else if (mode == move_after)
+            m_str.remove_prefix(pos + expected.size());
+        return true;
+    }
+
+    // Extracts data between the last `to` and the last `from` before it: `ps.rextract("crc=", "\n")`.
+    // The pointer moves as with extract, before `from` or after `to`.
+    PatternSeeker rextract(std::string_view from, std::string_view to, MoveMode mode=none)
+    {
+        PATTERN_SEEKER_STATS(extract);
+        const size_t endIt = detail::rfind(m_str, to);
+        const size_t fromIt = endIt == std::string_view::npos ? endIt : detail::rfind(m_str.substr(0, endIt), from);
+        PATTERN_SEEKER_STATS_RESULT(fromIt != std::string_view::npos, fromIt != std::string_view::npos ? m_str.size() - fromIt : m_str.size());
+        if (fromIt == std::string_view::npos)
+            return {};
+
+        const size_t startIt = fromIt + from.size();
+        auto substr = m_str.substr(startIt, endIt - startIt);
+        if (mode == move_before)
+            m_str.remove_prefix(fromIt);
+        else if (mode == move_after)
+            m_str.remove_prefix(endIt + to.size());
+        return PatternSeeker(substr, m_originalPointer);
+    }
+
+    // Extracts data after the last `from` up to the end of the view.
+    // move_before moves the pointer before `from`, move_after to the end.
+    PatternSeeker rextract(std::string_view from, MoveMode mode=none)
+    {
+        PATTERN_SEEKER_STATS(extract);
+        const size_t fromIt = detail::rfind(m_str, from);
+        PATTERN_SEEKER_STATS_RESULT(fromIt != std::string_view::npos, fromIt != std::string_view::npos ? m_str.size() - fromIt : m_str.size());
+        if (fromIt == std::string_view::npos)
+            return {};
+
+        auto substr = m_str.substr(fromIt + from.size());
+        if (mode == move_before)
+            m_str.remove_prefix(fromIt);
+        else if (mode == move_after)
+            m_str.remove_prefix(m_str.size());
+        return PatternSeeker(substr, m_originalPointer);
+    }
+
+    // Check how the view ends
+    bool endsWith(std::string_view expected) const
+    {
+        return m_str.ends_with(expected);
+    }
+
+    // Cuts `expected` off the end of the view if it ends with it
+    bool expectBack(std::string_view expected)
+    {
+        if (!m_str.ends_with(expected))
+            return false;
+        m_str.remove_suffix(expected.size());
+        return true;
+    }
+
+    // to avoid implicit convertion
+    void skipBack(char n) = delete;
+
+    // Cuts `n` elements off the end of the view
+    void skipBack(size_t n)
+    {
+        m_str.remove_suffix(n);
+    }
+
+    void skipWhiteSpacesBack()
+    {
+        static constexpr CharClass SPACES = CharClass::spaces();
+        size_t size = m_str.size();
+        while (size && SPACES.contains(m_str[size - 1]))
+            --size;
+        m_str.remove_suffix(m_str.size() - size);
+    }
+
+    // Extract data from current position `to` the desired symbols.
+    PatternSeeker extractUntilOneOf(std::string_view to, MoveMode mode=none)
+    {
+        if (to.size() == 1)
+            return extractUntilOneOfAt(m_str.find(to[0]), mode);
+        return extractUntilOneOf(CharClass(to), mode);
+    }
+
+    // The same for a class of chars, reuse it when the set is big: `extractUntilOneOf(CharClass::digits())`
+    PatternSeeker extractUntilOneOf(const CharClass& to, MoveMode mode=none)
+    {
+        const size_t endIt = detail::span(m_str, to, false);
+        return extractUntilOneOfAt(endIt == m_str.size() ? std::string_view::npos : endIt, mode);
+    }
+
+    // Skips the chars of the class and returns how many were skipped
+    size_t skipWhile(const CharClass& chars)
+    {
+        const size_t count = detail::span(m_str, chars, true);
+        m_str.remove_prefix(count);
+        return count;
+    }
+
+    // Extracts the chars of the class from the current position and moves the pointer after them:
+    // `auto name = ps.takeWhile(CharClass::identifier());`
+    PatternSeeker takeWhile(const CharClass& chars)
+    {
+        const size_t count = detail::span(m_str, chars, true);
+        return extract(count, move_after);
+    }
+
+    // Finds whichever of the patterns comes first in one pass and moves the pointer before or after it.
+    // Returns the position of the match and the index of the pattern, or an empty PatternMatch.
+    PatternMatch toAnyOf(const MultiPattern& patterns, MoveMode mode=none)
+    {
+        PATTERN_SEEKER_STATS(to_any_of);
+        const PatternMatch match = patterns.find(m_str);
+        PATTERN_SEEKER_STATS_RESULT(bool(match), match ? match.position + patterns.pattern(match.index).size() : m_str.size());
+        if (!match)
+            return match;
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(match.position);
+            break;
+        case move_after:
+            m_str.remove_prefix(match.position + patterns.pattern(match.index).size());
+            break;
+        case none:
+            break;
+        }
+
+        return match;
+    }
+
+    // The same for a set used once: `ps.toAnyOf({"\"error\"", "\"warn\"", "\"fatal\""}, move_after)`.
+    // A small set is compiled on the stack, so the call doesn't allocate.
+    PatternMatch toAnyOf(std::initializer_list<std::string_view> patterns, MoveMode mode=none)
+    {
+        alignas(std::max_align_t) std::byte stack[ONE_OFF_PATTERNS_BUFFER];
+        Arena arena(stack, sizeof(stack));
+        return toAnyOf(MultiPattern(patterns, &arena), mode);
+    }
+
+    // Extracts data from current position to whichever of the patterns comes first.
+    // Returns the data and the match: `auto [item, match] = ps.extractUntilAnyOf(tags, move_after);`
+    std::pair<PatternSeeker, PatternMatch> extractUntilAnyOf(const MultiPattern& patterns, MoveMode mode=none)
+    {
+        PATTERN_SEEKER_STATS(to_any_of);
+        const PatternMatch match = patterns.find(m_str);
+        PATTERN_SEEKER_STATS_RESULT(bool(match), match ? match.position + patterns.pattern(match.index).size() : m_str.size());
+        if (!match)
+            return { PatternSeeker{}, match };
+
+        auto substr = m_str.substr(0, match.position);
+
+        switch (mode)
+        {
+        case move_before:
+            m_str.remove_prefix(match.position);
+            break;
+        case move_after:
+            m_str.remove_prefix(match.position + patterns.pattern(match.index).size());
+            break;
+        case none:
+            break;
+        }
+
+        return { PatternSeeker(substr, m_originalPointer), match };
+    }
+
+    std::pair<PatternSeeker, PatternMatch> extractUntilAnyOf(std::initializer_list<std::string_view> patterns, MoveMode mode=none)
+    {
+        alignas(std::max_align_t) std::byte stack[ONE_OFF_PATTERNS_BUFFER];
+        Arena arena(stack, sizeof(stack));
+        return extractUntilAnyOf(MultiPattern(patterns, &arena), mode);
+    }
+
+    // to avoid implicit convertion
+    PatternSeeker extract(char) = delete;
+
+    // Extracts data from one character to another.
+    // However, if another `start` character is founded during the search for the `end` character,
+    // the search continues until the corresponding `end` character is found.
+    // It is convenient to search for objects in curly or square brackets.
+    PatternSeeker extract(char start, char end, MoveMode mode=none)
+    {
+        size_t startIndex = m_str.find(start);
+        if (startIndex == std::string::npos)
+            return {};
+
+        // a `start` that is also the `end` only deepens the nesting, so it is never closed
+        if (start == end)
+            return {};
+
+        // the brackets are found 64 bytes at a time, see detail::closeBracket
+        const size_t endIndex = detail::closeBracket(m_str, startIndex + 1, start, end);
+        if (endIndex == std::string::npos)
+            return {};
+
+        return spanAt(startIndex, endIndex, mode);
+    }
+
+    // Works like extract(start, end), but ignores the brackets inside double-quoted strings,
+    // so `{"text": "}"}` is extracted as a whole. Escaped quotes are handled as in JSON.
+    PatternSeeker extractQuoteAware(char start, char end, MoveMode mode=none)
+    {
+        if (start == end)
+            return {};
+
+        const auto [startIndex, endIndex] = detail::balancedOutsideStrings(m_str, start, end);
+        if (endIndex == std::string::npos)
+            return {};
+
+        return spanAt(startIndex, endIndex, mode);
+    }
+
+    // Extracts the required number of characters
+    PatternSeeker extract(size_t size, MoveMode mode=none)
+    {
+        auto substr = m_str.substr(0, size);
+
+        if (mode == move_after)
+            m_str.remove_prefix(size);
+
+        return PatternSeeker{substr, m_originalPointer};
+    }
+
+    // to avoid implicit convertion
+    void skip(char n) = delete;
+
+    // Move the pointer and skip `n` elements
+    void skip(size_t n)
+    {
+        m_str.remove_prefix(n);
+    }
+
+    // Checks that the view is valid UTF-8: there are no truncated or overlong sequences, stray continuation bytes,
+    // surrogates or code points above U+10FFFF. The bytes are checked 16 to 64 at a time.
+    bool isValidUtf8() const
+    {
+        return detail::isValidUtf8(m_str);
+    }
+
+    // Checks that all the bytes are ASCII
+    bool isAscii() const
+    {
+        return detail::isAscii(m_str);
+    }
+
+    // Checks the view with isAscii() and remembers the answer, so skipChars() and extractChars() count bytes then.
+    // The copies keep the flag, and so does the view as it moves and the results of extractChars().
+    // The other results don't have it.
+    bool markAscii()
+    {
+        m_ascii = isAscii();
+        return m_ascii;
+    }
+
+    bool isMarkedAscii() const
+    {
+        return m_ascii;
+    }
+
+    // Extracts `n` code points of UTF-8, or the rest if there are fewer, so a code point is never split.
+    // The continuation bytes of an invalid sequence go with the code point before them.
+    PatternSeeker extractChars(size_t n, MoveMode mode=none)
+    {
+        auto res = extract(charsToBytes(n), mode);
+        res.m_ascii = m_ascii;
+        return res;
+    }
+
+    // Moves the pointer by `n` code points of UTF-8, to the end if there are fewer
+    void skipChars(size_t n)
+    {
+        m_str.remove_prefix(charsToBytes(n));
+    }
+
+    // Parses a number of any arithmetic type and shifts the pointer.
+    // The parser never reads past the visible part, so the source doesn't have to be NUL-terminated,
+    // and it doesn't depend on the locale. Integers are parsed 8 digits at a time.
+    // An empty std::optional is returned on failure. If the number is out of range,
+    // the pointer still moves past it.
+    template <typename T>
+    std::optional<T> take()
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "take() parses numbers only");
+
+        PATTERN_SEEKER_STATS(take_number);
+        T value{};
+        bool valid = false;
+        const char* begin = m_str.data();
+        const char* end = detail::parseNumber(begin, begin + m_str.size(), value, valid);
+        PATTERN_SEEKER_STATS_RESULT(end != begin && valid, end - begin);
+        m_str.remove_prefix(end - begin);
+        if (end == begin || !valid)
+            return {};
+        return value;
+    }
+
+    // An auxiliary number parsing method
+    // that takes the default value and returns it in case of failure.
+    template <typename T>
+    T take(T def)
+    {
+        auto res = take<T>();
+        if (!res)
+            return def;
+        return *res;
+    }
+
+    // Parses an unsigned number and shifts the pointer.
+    // An empty std::optional is returned on failure
+    std::optional<uint64_t> takeUInt64()
+    {
+        return take<uint64_t>();
+    }
+
+    // An auxiliary number parsing method
+    // that takes the default value and returns it in case of failure.
+    uint64_t takeUInt64(uint64_t def)
+    {
+        return take<uint64_t>(def);
+    }
+
+    // Parses a signed number and shifts the pointer.
+    // An empty std::optional is returned on failure
+    std::optional<int64_t> takeInt64()
+    {
+        return take<int64_t>();
+    }
+
+    // An auxiliary number parsing method
+    // that takes the default value and returns it in case of failure.
+    int64_t takeInt64(int64_t def)
+    {
+        return take<int64_t>(def);
+    }
+
+    // Parses an unsigned 32-bit number and shifts the pointer.
+    std::optional<uint32_t> takeUInt32()
+    {
+        return take<uint32_t>();
+    }
+
+    uint32_t takeUInt32(uint32_t def)
+    {
+        return take<uint32_t>(def);
+    }
+
+    // Parses a floating-point number and shifts the pointer.
+    std::optional<double> takeDouble()
+    {
+        return take<double>();
+    }
+
+    double takeDouble(double def)
+    {
+        return take<double>(def);
+    }
+
+    std::optional<float> takeFloat()
+    {
+        return take<float>();
+    }
+
+    float takeFloat(float def)
+    {
+        return take<float>(def);
+    }
+
+    // Removes all whitespace characters, the ones of std::isspace in the "C" locale
+    void skipWhiteSpaces()
+    {
+        static constexpr CharClass SPACES = CharClass::spaces();
+        skipWhile(SPACES);
+    }
+
+    // Returns Json data by its name, whether it is a string, a number, an array, or a new object.
+    // The quoted name is matched in place, so the lookup doesn't allocate.
+    PatternSeeker getJsonProp(std::string_view prop)
+    {
+        return getJsonPropImpl(detail::RuntimePattern{prop});
+    }
+
+    // The same, but the name is a compile-time pattern without quotes: `getJsonProp("user_id"_pat)`
+    template <FixedString Str>
+    PatternSeeker getJsonProp(pattern<Str> prop)
+    {
+        return getJsonPropImpl(prop);
+    }
+
+    // Returns several Json properties at once: `auto [id, name] = ps.getJsonProps({"id", "name"});`
+    // Unlike N calls of getJsonProp, the data is scanned once, string by string,
+    // and the scan stops as soon as all the properties are found.
+    // The names are looked up in a small hash table built per call.
+    // Nested objects are searched too and the first occurrence of a name wins; a property that isn't found
+    // is returned empty. Unlike getJsonProp, only the names are matched, not the string values:
+    // for `{"type": "id", "id": 7}` getJsonProp("id") stops at the value "id" and is empty, getJsonProps gives 7.
+    template <size_t N>
+    std::array<PatternSeeker, N> getJsonProps(const std::string_view (&props)[N])
+    {
+        std::array<PatternSeeker, N> result{};
+
+        // Open addressing table of indices + 1, at most half full
+        constexpr size_t TABLE_SIZE = std::bit_ceil(std::max<size_t>(2 * N, 8));
+        std::array<uint16_t, TABLE_SIZE> table{};
+        std::array<size_t, N> alias{};
+        std::array<bool, N> found{};
+        const auto hash = [](std::string_view name) -> size_t {
+            const size_t first = name.empty() ? 0 : static_cast<unsigned char>(name.front());
+            const size_t last = name.empty() ? 0 : static_cast<unsigned char>(name.back());
+            return (name.size() * 0x9E3779B1u) ^ (first * 0x85EBCA77u) ^ (last * 0xC2B2AE3Du) ^ (last >> 3);
+        };
+
+        size_t remaining = N;
+        for (size_t i = 0; i < N; ++i)
+        {
+            alias[i] = i;
+            size_t slot = hash(props[i]) & (TABLE_SIZE - 1);
+            while (table[slot] && props[table[slot] - 1] != props[i])
+                slot = (slot + 1) & (TABLE_SIZE - 1);
+
+            if (table[slot])
+            {
+                // the same name twice gets the same value
+                alias[i] = table[slot] - 1;
+                --remaining;
+                continue;
+            }
+            table[slot] = static_cast<uint16_t>(i + 1);
+        }
+
+        // a name of another length is skipped before hashing
+        uint64_t lengths = 0;
+        for (const auto prop : props)
+            lengths |= detail::lengthBit(prop.size());
+
+        const auto onName = [&](size_t open, size_t close) {
+            const size_t size = close - open - 1;
+            if (!(lengths & detail::lengthBit(size)))
+                return;
+
+            const auto name = m_str.substr(open + 1, size);
+            size_t slot = hash(name) & (TABLE_SIZE - 1);
+            while (table[slot] && props[table[slot] - 1] != name)
+                slot = (slot + 1) & (TABLE_SIZE - 1);
+
+            const size_t index = table[slot] - 1;
+            if (!table[slot] || found[index])
+                return;
+
+            if (!valueAfterName(close, result[index]))
+                return;
+
+            found[index] = true;
+            --remaining;
+        };
+        forEachJsonName(remaining, onName);
+
+        for (size_t i = 0; i < N; ++i)
+            result[i] = result[alias[i]];
+        return result;
+    }
+
+    // Decodes the escapes of a Json string value, as getJsonProp returns it, to `buffer`.
+    // A string without escapes is returned as it is, without copying. Otherwise `buffer` needs size() bytes,
+    // the decoded string is never longer. Returns nullopt for an invalid escape or a small buffer.
+    std::optional<std::string_view> decodeJsonString(std::span<char> buffer) const
+    {
+        if (m_str.find('\\') == std::string_view::npos)
+            return m_str;
+        if (buffer.size() < m_str.size())
+            return std::nullopt;
+
+        const char* end = detail::decodeJsonString(m_str, buffer.data());
+        if (!end)
+            return std::nullopt;
+        return std::string_view(buffer.data(), static_cast<size_t>(end - buffer.data()));
+    }
+
+    // The same, but the memory for a string with escapes is taken from `arena`,
+    // for example a std::pmr::monotonic_buffer_resource that is released after a batch of records
+    std::optional<std::string_view> decodeJsonString(std::pmr::memory_resource& arena) const
+    {
+        if (m_str.find('\\') == std::string_view::npos)
+            return m_str;
+
+        auto* buffer = static_cast<char*>(arena.allocate(m_str.size(), 1));
+        return decodeJsonString(std::span<char>(buffer, m_str.size()));
+    }
+
+    // Returns the contents of the XML tag
+    PatternSeeker getXmlTagBody(std::string_view prop, MoveMode mode=none)
+    {
+        auto res = getXmlTag(prop, mode);
+        if (res.isEmpty())
+            return {};
+        return res.xmlTagBody();
+    }
+
+    PatternSeeker getXmlTagBody(ignore_case prop, MoveMode mode=none)
+    {
+        auto res = getXmlTag(prop, mode);
+        if (res.isEmpty())
+            return {};
+        return res.xmlTagBody();
+    }
+
+    // Returns the entire tag, including the tag name and its attributes.
+    // Only the whole name matches, so `<names>` isn't taken for `name`, and the nested tags
+    // of the same name are counted, so the tag ends with its own closing tag.
+    // A self-closing tag is returned as it is. The lookup doesn't allocate.
+    PatternSeeker getXmlTag(std::string_view prop, MoveMode mode=none)
+    {
+        return getXmlTagImpl(prop, false, mode);
+    }
+
+    // The same, but the names match in either case: `<Item>` is closed by `</ITEM>` too
+    PatternSeeker getXmlTag(ignore_case prop, MoveMode mode=none)
+    {
+        return getXmlTagImpl(prop.str, true, mode);
+    }
+
+    // Returns the elements of the Json array at the current position one by one, without collecting them:
+    // `for (auto item : ps.jsonArrayElements() | std::views::take(10))`
+    // Strings come without quotes as in getJsonProp, objects and arrays with their brackets.
+    JsonElements jsonArrayElements() const;
+
+    // Returns the first `name` tag and the `name` tags after it on the same level one by one,
+    // each one as the entire tag like getXmlTag. The name must outlive the range.
+    XmlChildren xmlChildren(std::string_view name) const;
+
+    // Returns the fields separated by any of the `delims` chars one by one: `for (auto pair : ps.fields(";"))`.
+    // n delimiters make n + 1 fields, so an empty view has one empty field and a trailing delimiter
+    // makes an empty last field. With `quoted` the delimiters inside double quotes don't split,
+    // and a field in quotes comes without them; the doubled quotes inside aren't decoded.
+    // The delimiters are found 64 bytes at a time. The delims must outlive the range.
+    Fields fields(std::string_view delims, bool quoted=false) const;
+
+    // Splits the view like fields() into `out` and returns the number of fields stored.
+    // The fields after the first out.size() ones are neither stored nor looked for.
+    size_t splitInto(std::span<std::string_view> out, std::string_view delims, bool quoted=false) const
+    {
+        if (out.empty())
+            return 0;
+
+        detail::FieldSplitter splitter(delims, quoted);
+        size_t count = 0;
+        size_t start = 0;
+        splitter.forEachBlock(m_str, 0, [&](size_t pos, uint64_t separators) {
+            for (; separators; separators &= separators - 1)
+            {
+                const size_t end = pos + static_cast<size_t>(std::countr_zero(separators));
+                out[count++] = detail::unquoteField(m_str.substr(start, end - start), quoted);
+                start = end + 1;
+                if (count == out.size())
+                    return true;
+            }
+            return false;
+        });
+        if (count < out.size())
+            out[count++] = detail::unquoteField(m_str.substr(start), quoted);
+        return count;
+    }
+
+    // Returns the field `n`, counted from 0, of the view split like fields(), or an empty one if there are
+    // less fields. The blocks before the one where the field starts are only counted, not split.
+    PatternSeeker column(size_t n, std::string_view delims, bool quoted=false) const
+    {
+        detail::FieldSplitter splitter(delims, quoted);
+        // the delimiters to skip before the field starts
+        size_t skip = n;
+        size_t start = n == 0 ? 0 : std::string_view::npos;
+        size_t end = m_str.size();
+        splitter.forEachBlock(m_str, 0, [&](size_t pos, uint64_t separators) {
+            if (start == std::string_view::npos)
+            {
+                const size_t count = static_cast<size_t>(std::popcount(separators));
+                if (count < skip)
+                {
+                    skip -= count;
+                    return false;
+                }
+                for (; skip > 1; --skip)
+                    separators &= separators - 1;
+                start = pos + static_cast<size_t>(std::countr_zero(separators)) + 1;
+                separators &= separators - 1;
+            }
+            if (separators == 0)
+                return false;
+            end = pos + static_cast<size_t>(std::countr_zero(separators));
+            return true;
+        });
+
+        if (start == std::string_view::npos)
+            return {};
+        return PatternSeeker(detail::unquoteField(m_str.substr(start, end - start), quoted), m_originalPointer);
+    }
+
+    // Returns the contents of the XML attribute
+    PatternSeeker getXmlAttr(std::string_view prop)
+    {
+        PATTERN_SEEKER_STATS(xml_attr);
+        auto copy = *this;
+        if (!copy.to(prop, move_after))
+        {
+            PATTERN_SEEKER_STATS_RESULT(false, m_str.size());
+            return {};
+        }
+        copy.skipWhiteSpaces();
+        copy.expect("=");
+        copy.skipWhiteSpaces();
+        const auto value = copy.extract(DOUBLE_QUOTE, DOUBLE_QUOTE);
+        // up to the closing quote
+        PATTERN_SEEKER_STATS_RESULT(value.m_str.data() != EMPTY_STR,
+                                    value.m_str.data() != EMPTY_STR ? value.m_str.data() + value.m_str.size() + 1 - m_str.data() : m_str.size());
+        return value;
+    }
+
+    // useful to know where a string starts
+    size_t getOriginalPosition()
+    {
+        return m_str.data() - m_originalPointer;
+    }
+
+    // useful to know how much we've moved on.
+    // For example, buffer.commit(offset)
+    size_t getOffset()
+    {
+        return m_str.data() - m_originalPointer;
+    }
+
+    // output to the stream
+    friend std::ostream& operator<<(std::ostream& oss, const PatternSeeker& parser) {
+        return oss << parser.to_string_view();
+    }
+};
+
+// Offsets of the structural characters of a Json document: brackets, colons, commas
+// and the quotes that open and close strings. The index is built in one pass
+// over 64-byte blocks, like the first stage of simdjson, so the lookups walk
+// the offsets instead of searching the text and skip nested objects as a whole.
+// The offsets are relative to the original pointer of the indexed PatternSeeker,
+// so the returned values work with getOffset() as usual.
+// The indexed data must outlive the index. build() reuses the memory of the previous document.
+class PatternSeeker::JsonIndex
+{
+public:
+    // A Json value found with the index: an object, an array, a string or a scalar
+    class Value
+    {
+    public:
+        Value() = default;
+
+        // Checks that the value exists
+        bool isEmpty() const
+        {
+            return m_index == nullptr;
+        }
+
+        explicit operator bool() const
+        {
+            return !isEmpty();
+        }
+
+        // Returns the member of this object by its name. Only the direct members are compared.
+        Value getJsonProp(std::string_view name) const
+        {
+            if (isEmpty() || m_kind != '{')
+                return {};
+
+            const uint32_t close = m_index->m_skips[m_token] - 1;
+            uint32_t token = m_token + 1;
+            // each member is the name quotes, the colon and the value
+            while (token + 2 < close)
+            {
+                if (m_index->stringSize(token) == name.size() && m_index->stringAt(token) == name)
+                    return m_index->valueAfter(token + 2);
+
+                // the value is skipped without reading the text, a nested object is one jump
+                const uint32_t next = m_index->skip(token + 3);
+                if (next >= close)
+                    return {};
+                token = next + 1;
+            }
+
+            return {};
+        }
+
+        // Returns the element of this array by its position
+        Value at(size_t position) const
+        {
+            if (isEmpty() || m_kind != '[')
+                return {};
+
+            const uint32_t close = m_index->m_skips[m_token] - 1;
+            uint32_t before = m_token;
+            for (; position; --position)
+            {
+                before = m_index->skip(before + 1);
+                if (before >= close)
+                    return {};
+            }
+            return m_index->valueAfter(before);
+        }
+
+        // Returns the value the way getJsonProp does: strings without the quotes,
+        // objects and arrays with the brackets
+        PatternSeeker seeker() const
+        {
+            if (isEmpty())
+                return {};
+            return PatternSeeker{std::string_view(m_index->m_data + m_begin, m_end - m_begin), m_index->m_data};
+        }
+
+    private:
+        friend class JsonIndex;
+
+        const JsonIndex* m_index = nullptr;
+        // '{', '[', '"' or 0 for numbers, booleans and null
+        char m_kind = 0;
+        // the opening bracket or quote, the token after a scalar
+        uint32_t m_token = 0;
+        uint32_t m_begin = 0;
+        uint32_t m_end = 0;
+    };
+
+    // The offsets are allocated from `resource`, for example an Arena that is reset per request
+    explicit JsonIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_tokens(resource)
+        , m_skips(resource)
+        , m_names(resource)
+        , m_stack(resource)
+    {}
+
+    explicit JsonIndex(const PatternSeeker& json, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : JsonIndex(resource)
+    {
+        build(json);
+    }
+
+    // Indexes the visible part of `json`.
+    // Returns false and leaves the index empty if the brackets don't match, a string isn't closed
+    // or the data doesn't fit 32-bit offsets.
+    bool build(const PatternSeeker& json)
+    {
+        clear();
+        const std::string_view str = json.m_str;
+        const size_t base = str.data() - json.m_originalPointer;
+        if (base + str.size() > std::numeric_limits<uint32_t>::max())
+            return false;
+        m_data = json.m_originalPointer;
+
+        const char chars[] = { '"', '\\', '{', '}', '[', ']', ':', ',' };
+        detail::StringScanner strings;
+        bool openQuote = false;
+        const bool broken = detail::forEachBlock(str, 0, chars, [&](size_t pos, const uint64_t* masks) {
+            const uint64_t inString = strings.next(masks[0], masks[1]);
+            const uint64_t quotes = masks[0] & ~strings.escaped;
+            const uint64_t structurals = masks[2] | masks[3] | masks[4] | masks[5] | masks[6] | masks[7];
+            for (uint64_t bits = quotes | (structurals & ~inString); bits; bits &= bits - 1)
+            {
+                const size_t at = pos + std::countr_zero(bits);
+                const uint32_t token = static_cast<uint32_t>(m_tokens.size());
+                m_tokens.push_back(static_cast<uint32_t>(base + at));
+                m_skips.push_back(0);
+
+                switch (str[at])
+                {
+                case '"':
+                    // the quotes alternate, the opening one skips the string
+                    openQuote = !openQuote;
+                    if (openQuote)
+                        m_skips[token] = token + 2;
+                    break;
+                case '{':
+                case '[':
+                    m_stack.push_back(token);
+                    break;
+                case '}':
+                case ']':
+                    if (m_stack.empty() || (charAt(m_stack.back()) == '{') != (str[at] == '}'))
+                        return true;
+                    m_skips[m_stack.back()] = token + 1;
+                    m_stack.pop_back();
+                    break;
+                case ':':
+                    // the name is the string right before the colon
+                    if (token >= 2 && charAt(token - 1) == '"')
+                        m_names.push_back(token - 2);
+                    break;
+                default:
+                    break;
+                }
+            }
+            return false;
+        });
+
+        if (broken || !m_stack.empty() || strings.prevInString)
+        {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Forgets the document, but keeps the memory for the next one
+    void clear()
+    {
+        m_data = nullptr;
+        m_tokens.clear();
+        m_skips.clear();
+        m_names.clear();
+        m_stack.clear();
+    }
+
+    bool isEmpty() const
+    {
+        return m_tokens.empty();
+    }
+
+    // Returns the number of indexed characters
+    size_t size() const
+    {
+        return m_tokens.size();
+    }
+
+    // Returns the offsets of the indexed characters relative to the original pointer
+    const std::pmr::vector<uint32_t>& offsets() const
+    {
+        return m_tokens;
+    }
+
+    // Returns the top-level object or array:
+    // `index.root().getJsonProp("user").getJsonProp("tags").at(2).seeker()`
+    Value root() const
+    {
+        if (isEmpty() || (charAt(0) != '{' && charAt(0) != '['))
+            return {};
+        return containerAt(0);
+    }
+
+    // Works like PatternSeeker::getJsonProp, the first member with the name at any depth wins.
+    // Only the names are compared, so quotes inside string values never match.
+    PatternSeeker getJsonProp(std::string_view name) const
+    {
+        for (const uint32_t token : m_names)
+        {
+            // the length is known from the offsets, so most names are rejected without reading the text
+            if (stringSize(token) == name.size() && stringAt(token) == name)
+                return valueAfter(token + 2).seeker();
+        }
+        return {};
+    }
+
+private:
+    const char* m_data = nullptr;
+    // offsets of every structural character and quote
+    std::pmr::vector<uint32_t> m_tokens;
+    // for an opening bracket or quote, the index of the token after the closing one, otherwise 0
+    std::pmr::vector<uint32_t> m_skips;
+    // indices of the opening quotes of the member names
+    std::pmr::vector<uint32_t> m_names;
+    // the opened brackets during the build
+    std::pmr::vector<uint32_t> m_stack;
+
+    char charAt(uint32_t token) const
+    {
+        return m_data[m_tokens[token]];
+    }
+
+    // Returns the size of the string opened by `token` without reading it
+    size_t stringSize(uint32_t token) const
+    {
+        return m_tokens[token + 1] - m_tokens[token] - 1;
+    }
+
+    // Returns the contents of the string opened by `token`
+    std::string_view stringAt(uint32_t token) const
+    {
+        return std::string_view(m_data + m_tokens[token] + 1, stringSize(token));
+    }
+
+    Value containerAt(uint32_t token) const
+    {
+        Value value;
+        value.m_index = this;
+        value.m_kind = charAt(token);
+        value.m_token = token;
+        value.m_begin = m_tokens[token];
+        value.m_end = m_tokens[m_skips[token] - 1] + 1;
+        return value;
+    }
+
+    // Returns the value that follows `before`: a colon, a comma or an opening bracket
+    Value valueAfter(uint32_t before) const
+    {
+        const uint32_t token = before + 1;
+        if (token >= m_tokens.size())
+            return {};
+
+        const char kind = charAt(token);
+        if (kind == '{' || kind == '[')
+            return containerAt(token);
+
+        Value value;
+        value.m_index = this;
+        value.m_token = token;
+        if (kind == '"' && token + 1 < m_tokens.size())
+        {
+            value.m_kind = kind;
+            value.m_begin = m_tokens[token] + 1;
+            value.m_end = m_tokens[token + 1];
+            return value;
+        }
+
+        // a scalar is the text up to the next token without the whitespaces
+        const auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+        uint32_t begin = m_tokens[before] + 1;
+        uint32_t end = m_tokens[token];
+        while (begin < end && isSpace(m_data[begin]))
+            ++begin;
+        while (end > begin && isSpace(m_data[end - 1]))
+            --end;
+        if (begin == end)
+            return {};
+
+        value.m_begin = begin;
+        value.m_end = end;
+        return value;
+    }
+
+    // Returns the token after the value that starts with `token`, a scalar ends with `token` itself
+    uint32_t skip(uint32_t token) const
+    {
+        return m_skips[token] ? m_skips[token] : token;
+    }
+};
+
+// The elements of a Json array, a forward-only view that parses the next element only when it is asked for,
+// so the bytes after the last element taken are never touched.
+// The iterators don't refer to the range, so it composes with std::views and outlives them.
+class PatternSeeker::JsonElements : public std::ranges::view_interface<PatternSeeker::JsonElements>
+{
+private:
+    // the data after the opening bracket
+    PatternSeeker m_rest{};
+    bool m_array = false;
+
+public:
+    class iterator
+    {
+    private:
+        PatternSeeker m_rest{};
+        PatternSeeker m_element{};
+        bool m_end = true;
+
+        void next()
+        {
+            m_rest.skipWhiteSpaces();
+            if (m_rest.startsWith("]") || !m_rest.takeJsonValue(m_element))
+            {
+                m_end = true;
+                return;
+            }
+
+            // after the last element the rest is dropped, so the next step ends the range
+            m_rest.skipWhiteSpaces();
+            if (!m_rest.expect(","))
+                m_rest.m_str = {};
+        }
+
+    public:
+        using value_type = PatternSeeker;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        explicit iterator(PatternSeeker rest)
+            : m_rest(rest)
+            , m_end(false)
+        {
+            next();
+        }
+
+        PatternSeeker operator*() const
+        {
+            return m_element;
+        }
+
+        iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            next();
+        }
+
+        // an empty string is an element too, so the end is a flag
+        friend bool operator==(const iterator& it, std::default_sentinel_t)
+        {
+            return it.m_end;
+        }
+    };
+
+    JsonElements() = default;
+
+    // The array that starts at the current position of `data`, after whitespace
+    explicit JsonElements(PatternSeeker data)
+        : m_rest(data)
+    {
+        m_rest.skipWhiteSpaces();
+        m_array = m_rest.expect("[");
+    }
+
+    iterator begin() const
+    {
+        return m_array ? iterator(m_rest) : iterator();
+    }
+
+    std::default_sentinel_t end() const
+    {
+        return {};
+    }
+};
+
+// The XML tags of one name on one level, a forward-only view like JsonElements.
+// The first tag is found at any depth, the next ones are its siblings: the tags of other names
+// between them are skipped with their contents and the range ends where the parent is closed.
+// Comments, CDATA sections, processing instructions and `>` inside quoted attributes are skipped too.
+class PatternSeeker::XmlChildren : public std::ranges::view_interface<PatternSeeker::XmlChildren>
+{
+private:
+    PatternSeeker m_data{};
+    std::string_view m_name;
+
+    // Finds the next `name` tag on the level of `str`, or on any level for the first one.
+    // Returns npos if the level is closed before it.
+    static size_t nextTag(std::string_view str, std::string_view name, bool anyLevel)
+    {
+        size_t depth = 0;
+        size_t pos = 0;
+        while ((pos = str.find('<', pos)) != std::string_view::npos)
+        {
+            const size_t markup = detail::xmlMarkupEnd(str, pos);
+            if (markup != pos)
+            {
+                pos = markup;
+                if (pos == std::string_view::npos)
+                    break;
+                continue;
+            }
+
+            if (pos + 1 < str.size() && str[pos + 1] == '/')
+            {
+                if (depth == 0 && !anyLevel)
+                    break;
+                depth -= depth > 0;
+                pos += 2;
+                continue;
+            }
+
+            if ((anyLevel || depth == 0) && detail::xmlIsName(str, pos + 1, name))
+                return pos;
+
+            const size_t end = detail::xmlTagEnd(str, pos);
+            if (end == std::string_view::npos)
+                break;
+            depth += !detail::xmlSelfClosing(str, end);
+            pos = end;
+        }
+        return std::string_view::npos;
+    }
+
+    // Returns the position after the tag that starts at `start` together with its contents,
+    // nested tags of the same name included
+    static size_t elementEnd(std::string_view str, size_t start, std::string_view name)
+    {
+        size_t pos = detail::xmlTagEnd(str, start);
+        if (pos == std::string_view::npos || detail::xmlSelfClosing(str, pos))
+            return pos;
+
+        size_t depth = 1;
+        while ((pos = str.find('<', pos)) != std::string_view::npos)
+        {
+            const size_t markup = detail::xmlMarkupEnd(str, pos);
+            if (markup != pos)
+            {
+                pos = markup;
+                if (pos == std::string_view::npos)
+                    break;
+                continue;
+            }
+
+            const bool closing = pos + 1 < str.size() && str[pos + 1] == '/';
+            const bool same = detail::xmlIsName(str, pos + 1 + closing, name);
+            const size_t end = detail::xmlTagEnd(str, pos);
+            if (end == std::string_view::npos)
+                break;
+            if (same && closing && --depth == 0)
+                return end;
+            if (same && !closing && !detail::xmlSelfClosing(str, end))
+                ++depth;
+            pos = end;
+        }
+        return std::string_view::npos;
+    }
+
+public:
+    class iterator
+    {
+    private:
+        PatternSeeker m_rest{};
+        PatternSeeker m_element{};
+        std::string_view m_name;
+        bool m_first = true;
+
+        void next()
+        {
+            const std::string_view str = m_rest.m_str;
+            const size_t start = nextTag(str, m_name, m_first);
+            const size_t end = start == std::string_view::npos ? start : elementEnd(str, start, m_name);
+            m_first = false;
+            if (end == std::string_view::npos)
+            {
+                m_element = PatternSeeker{};
+                return;
+            }
+
+            m_element = PatternSeeker(str.substr(start, end - start), m_rest.m_originalPointer);
+            m_rest.m_str.remove_prefix(end);
+        }
+
+    public:
+        using value_type = PatternSeeker;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        iterator(PatternSeeker data, std::string_view name)
+            : m_rest(data)
+            , m_name(name)
+        {
+            next();
+        }
+
+        PatternSeeker operator*() const
+        {
+            return m_element;
+        }
+
+        iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            next();
+        }
+
+        // a tag is never empty, it has its name at least
+        friend bool operator==(const iterator& it, std::default_sentinel_t)
+        {
+            return it.m_element.isEmpty();
+        }
+    };
+
+    XmlChildren() = default;
+
+    XmlChildren(PatternSeeker data, std::string_view name)
+        : m_data(data)
+        , m_name(name)
+    {}
+
+    iterator begin() const
+    {
+        return m_name.empty() ? iterator() : iterator(m_data, m_name);
     }
 
-    // to avoid implicit convertion
-    void skip(char n) = delete;
+    std::default_sentinel_t end() const
+    {
+        return {};
+    }
+};
 
-    // Move the pointer and skip `n` elements
-    void skip(size_t n)
+// The delimiter-separated fields of a view, a forward-only view like JsonElements.
+// The delimiters are classified in batches of up to 8 blocks of 64 bytes that grow from one block,
+// and the fields are cut from the masks without looking at the bytes again.
+class PatternSeeker::Fields : public std::ranges::view_interface<PatternSeeker::Fields>
+{
+private:
+    PatternSeeker m_data{};
+    std::string_view m_delims;
+    bool m_quoted = false;
+
+    static constexpr size_t BATCH_BLOCKS = 8;
+
+public:
+    class iterator
     {
-        m_str.remove_prefix(n);
+    private:
+        PatternSeeker m_data{};
+        PatternSeeker m_field{};
+        detail::FieldSplitter m_splitter{ {}, false };
+        // the delimiters of the blocks classified at a time, the batch grows to BATCH_BLOCKS
+        uint64_t m_batch[BATCH_BLOCKS] = {};
+        size_t m_batchSize = 1;
+        size_t m_filled = 0;
+        size_t m_index = 0;
+        // the block of the delimiters left in m_separators
+        size_t m_block = 0;
+        uint64_t m_separators = 0;
+        size_t m_start = 0;
+        bool m_quoted = false;
+        bool m_end = true;
+
+        void classify()
+        {
+            m_filled = m_splitter.next(m_data.m_str, m_block, m_batchSize, m_batch);
+            m_index = 0;
+            m_batchSize = std::min(m_batchSize * 2, BATCH_BLOCKS);
+        }
+
+        void next()
+        {
+            const std::string_view str = m_data.m_str;
+            if (m_start > str.size())
+            {
+                m_end = true;
+                return;
+            }
+
+            while (m_separators == 0 && m_block + 64 < str.size())
+            {
+                m_block += 64;
+                if (++m_index == m_filled)
+                    classify();
+                m_separators = m_batch[m_index];
+            }
+
+            size_t end = str.size();
+            if (m_separators)
+            {
+                end = m_block + static_cast<size_t>(std::countr_zero(m_separators));
+                m_separators &= m_separators - 1;
+            }
+            m_field = PatternSeeker(detail::unquoteField(str.substr(m_start, end - m_start), m_quoted), m_data.m_originalPointer);
+            m_start = end + 1;
+        }
+
+    public:
+        using value_type = PatternSeeker;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        iterator(PatternSeeker data, std::string_view delims, bool quoted)
+            : m_data(data)
+            , m_splitter(delims, quoted)
+            , m_quoted(quoted)
+            , m_end(false)
+        {
+            if (!m_data.m_str.empty())
+            {
+                classify();
+                m_separators = m_batch[0];
+            }
+            next();
+        }
+
+        PatternSeeker operator*() const
+        {
+            return m_field;
+        }
+
+        iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            next();
+        }
+
+        // a field may be empty, so the end is a flag
+        friend bool operator==(const iterator& it, std::default_sentinel_t)
+        {
+            return it.m_end;
+        }
+    };
+
+    Fields() = default;
+
+    Fields(PatternSeeker data, std::string_view delims, bool quoted)
+        : m_data(data)
+        , m_delims(delims)
+        , m_quoted(quoted)
+    {}
+
+    iterator begin() const
+    {
+        return iterator(m_data, m_delims, m_quoted);
     }
 
-    // Parses an unsigned number and shifts the pointer.
-    // An empty boost::optional is returned on failure
-    std::optional<uint64_t> takeUInt64()
+    std::default_sentinel_t end() const
     {
-        errno = 0; // thread safe
-        char* end = nullptr;
-        const auto result = std::strtoull(m_str.data(), &end, 10);
-        bool isError = errno || end == m_str.data();
-        m_str.remove_prefix(end - m_str.data());
-        if (isError)
-            return {};
-        return result;
+        return {};
     }
+};
 
-    // An auxiliary number parsing method
-    // that takes the default value and returns it in case of failure.
-    uint64_t takeUInt64(uint64_t def)
+// A compiled Json path like `$.a.b[3].c` or `$["a"][0]`, reusable for any number of documents:
+// `static const auto path = JsonPath::compile("$.user.tags[2]"); auto tag = path.find(ps);`
+// find() walks the document forward once: at every level only the direct members or elements are looked at,
+// and the ones that don't match are skipped as a whole with the quote-aware bracket scanner.
+// So unlike chained getJsonProp calls, a name inside a nested object or a string is never mistaken for the one asked for.
+// The names are compared with the raw text of the keys, escapes aren't decoded: `$["x\"y"]` is the key `"x\"y"`.
+class JsonPath
+{
+private:
+    struct Step
     {
-        auto res = takeUInt64();
-        if (!res)
-            return def;
-        return *res;
+        // an element of an array, otherwise a member of an object
+        bool isIndex = false;
+        // the index or the offset of the name in m_names
+        size_t value = 0;
+        size_t size = 0;
+    };
+
+    std::pmr::string m_names;
+    std::pmr::vector<Step> m_steps;
+    bool m_valid = false;
+
+    void addName(std::string_view name)
+    {
+        m_steps.push_back({ false, m_names.size(), name.size() });
+        m_names.append(name);
     }
 
-    // Parses a signed number and shifts the pointer.
-    // An empty boost::optional is returned on failure
-    std::optional<int64_t> takeInt64()
+    std::string_view name(const Step& step) const
     {
-        errno = 0; // thread safe
-        char* end = nullptr;
-        const auto result = std::strtoll(m_str.data(), &end, 10);
-        bool isError = errno || end == m_str.data();
-        m_str.remove_prefix(end - m_str.data());
-        if (isError)
-            return {};
-        return result;
+        return std::string_view(m_names).substr(step.value, step.size);
     }
 
-    // An auxiliary number parsing method
-    // that takes the default value and returns it in case of failure.
-    int64_t takeInt64(int64_t def)
+    // Moves `data` to the value of the member `step` of the object at its position
+    bool findMember(PatternSeeker& data, const Step& step) const
     {
-        auto res = takeInt64();
-        if (!res)
-            return def;
-        return *res;
+        const std::string_view expected = name(step);
+        data.skipWhiteSpaces();
+        if (!data.expect("{"))
+            return false;
+
+        PatternSeeker skipped{};
+        while (true)
+        {
+            data.skipWhiteSpaces();
+            if (!data.startsWith("\""))
+                return false;
+            const size_t close = data.closingQuote(1);
+            if (close == std::string_view::npos)
+                return false;
+            const bool found = data.m_str.substr(1, close - 1) == expected;
+            data.m_str.remove_prefix(close + 1);
+
+            data.skipWhiteSpaces();
+            if (!data.expect(":"))
+                return false;
+            if (found)
+                return true;
+
+            if (!data.takeJsonValue(skipped))
+                return false;
+            data.skipWhiteSpaces();
+            if (!data.expect(","))
+                return false;
+        }
     }
 
-    // Removes all whitespace characters
-    void skipWhiteSpaces()
+    // Moves `data` to the element `step` of the array at its position
+    bool findElement(PatternSeeker& data, const Step& step) const
     {
-        while (m_str.size() && std::isspace(static_cast<unsigned char>(m_str[0]))) {
-            m_str.remove_prefix(1);
+        data.skipWhiteSpaces();
+        if (!data.expect("["))
+            return false;
+
+        PatternSeeker skipped{};
+        for (size_t i = 0; i < step.value; ++i)
+        {
+            data.skipWhiteSpaces();
+            if (data.startsWith("]") || !data.takeJsonValue(skipped))
+                return false;
+            data.skipWhiteSpaces();
+            if (!data.expect(","))
+                return false;
         }
+
+        data.skipWhiteSpaces();
+        return !data.startsWith("]");
     }
 
-    // Returns Json data by its name, whether it is a string, a number, an array, or a new object.
-    PatternSeeker getJsonProp(std::string prop)
+public:
+    explicit JsonPath(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_names(resource)
+        , m_steps(resource)
+    {}
+
+    // Parses the path: `$` followed by `.name`, `["name"]`, `['name']` or `[index]` steps.
+    // A path that can't be parsed is invalid, and it finds nothing.
+    static JsonPath compile(std::string_view path, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
     {
-        auto copy = *this;
-        if (!copy.to(DOUBLE_QUOTE + prop + DOUBLE_QUOTE, move_after))
-            return {};
+        JsonPath result(resource);
+        PatternSeeker ps(path);
+        if (!ps.expect("$"))
+            return result;
 
-        copy.skipWhiteSpaces();
-        if (!copy.expect(":"))
-            return {};
+        // a name after a dot ends with the next step
+        static constexpr CharClass NAME = ~CharClass(".[");
+        while (ps.isNotEmpty())
+        {
+            if (ps.expect("."))
+            {
+                const auto member = ps.takeWhile(NAME);
+                if (member.isEmpty())
+                    return result;
+                result.addName(member.to_string_view());
+                continue;
+            }
 
-        copy.skipWhiteSpaces();
-        if (copy.expect(DOUBLE_QUOTE))
-            return copy.extract(DOUBLE_QUOTE);
+            if (!ps.expect("["))
+                return result;
+            if (ps.startsWith("\"") || ps.startsWith("'"))
+            {
+                // the quote escaped by an odd run of backslashes is a part of the raw name
+                const std::string_view rest = ps.to_string_view();
+                size_t close = 0;
+                while ((close = rest.find(rest[0], close + 1)) != std::string_view::npos)
+                {
+                    size_t slashes = 0;
+                    while (rest[close - 1 - slashes] == '\\')
+                        ++slashes;
+                    if (slashes % 2 == 0)
+                        break;
+                }
+                if (close == std::string_view::npos)
+                    return result;
+                result.addName(rest.substr(1, close - 1));
+                ps.skip(close + 1);
+            }
+            else
+            {
+                auto digits = ps.takeWhile(CharClass::digits());
+                // an index that overflows isn't taken for 0
+                const auto index = digits.take<size_t>();
+                if (!index)
+                    return result;
+                result.m_steps.push_back({ true, *index, 0 });
+            }
+            if (!ps.expect("]"))
+                return result;
+        }
 
-        if (copy.startsWith("["))
-            return copy.extract('[', ']');
+        result.m_valid = true;
+        return result;
+    }
 
-        if (copy.startsWith("{"))
-            return copy.extract('{', '}');
+    bool isValid() const
+    {
+        return m_valid;
+    }
 
-        return copy.extractUntilOneOf(", \r\n]}");
+    explicit operator bool() const
+    {
+        return m_valid;
     }
 
-    // Returns the contents of the XML tag
-    PatternSeeker getXmlTagBody(std::string prop, MoveMode mode=none)
+    // Returns the number of steps after `$`
+    size_t size() const
     {
-        auto res = getXmlTag(prop, mode);
-        if (res.isEmpty())
-            return {};
-        auto startPos = res.m_str.find('>') + 1;
-        auto endPos = res.m_str.rfind("</" + prop + ">");
-        if (endPos == std::string::npos)
-            return {};
-        return res.m_str.substr(startPos, endPos - startPos);
+        return m_steps.size();
     }
 
-    // Returns the entire tag, including the tag name and its attributes
-    PatternSeeker getXmlTag(std::string prop, MoveMode mode=none)
+    // Returns the value of the path in the Json value at the current position of `data`,
+    // in the form of getJsonProp: strings without quotes, objects and arrays with their brackets.
+    // Returns an empty PatternSeeker if there is no such value.
+    PatternSeeker find(PatternSeeker data) const
     {
-        auto startTag = "<" + prop;
-        size_t startPos = m_str.find(startTag);
-        if (startPos == std::string::npos)
+        if (!m_valid)
             return {};
 
-        auto endTag = "</" + prop + ">";
-        size_t endPos = m_str.find(endTag, startPos + startTag.size());
-        if (endPos == std::string::npos)
+        for (const Step& step : m_steps)
+        {
+            if (!(step.isIndex ? findElement(data, step) : findMember(data, step)))
+                return {};
+        }
+
+        PatternSeeker value{};
+        if (!data.takeJsonValue(value))
             return {};
+        return value;
+    }
+};
 
-        auto substr = m_str.substr(startPos, endPos + endTag.size() - startPos);
+// A named value of a schema: `field<"id", uint64_t>`.
+// The type is std::string_view, PatternSeeker, bool or a number parsed like take<T>().
+template <FixedString Name, typename T>
+struct field
+{
+    static constexpr std::string_view name = Name.view();
+    using type = T;
+};
 
-        switch (mode)
+namespace detail {
+
+// Packs `count` <= 8 bytes of `name` starting at `from` the same way at compile time and at run time
+constexpr uint64_t schemaWord(std::string_view name, size_t from, size_t count)
+{
+    if constexpr (std::endian::native == std::endian::little)
+    {
+        if (!std::is_constant_evaluated() && count == 8)
         {
-        case move_before:
-            m_str.remove_prefix(startPos);
-            break;
-        case move_after:
-            m_str.remove_prefix(endPos + endTag.size());
-            break;
-        default:
-            break;
+            uint64_t word;
+            std::memcpy(&word, name.data() + from, 8);
+            return word;
         }
+    }
 
-        return PatternSeeker{substr, m_originalPointer};
+    uint64_t word = 0;
+    for (size_t i = 0; i < count; ++i)
+        word |= uint64_t(static_cast<unsigned char>(name[from + i])) << (8 * i);
+    return word;
+}
+
+// The key of a schema name before the seed is applied: its length and its first and last 8 bytes
+constexpr uint64_t schemaKey(std::string_view name)
+{
+    const size_t count = std::min<size_t>(name.size(), 8);
+    return schemaWord(name, 0, count) ^ std::rotl(schemaWord(name, name.size() - count, count), 29)
+        ^ (name.size() * 0x9E3779B97F4A7C15ull);
+}
+
+// The same for a short name that is followed by at least 8 readable bytes, so it is loaded as a whole word
+inline uint64_t schemaKeyOfShort(std::string_view name)
+{
+    if constexpr (std::endian::native != std::endian::little)
+        return schemaKey(name);
+
+    uint64_t word;
+    std::memcpy(&word, name.data(), 8);
+    word &= (1ull << (8 * name.size())) - 1;
+    return word ^ std::rotl(word, 29) ^ (name.size() * 0x9E3779B97F4A7C15ull);
+}
+
+}
+
+// schema describes a record once and parses it in one pass:
+// `using User = schema<field<"id", uint64_t>, field<"name", std::string_view>>;`
+// `auto user = User::parseJson(ps); if (user.complete()) use(user.get<"id">(), user.get<"name">());`
+// The names are dispatched with a perfect hash that is found at compile time, so every name of the data
+// costs a multiplication and at most one compare with the only field it can be.
+// parseJson finds the values as getJsonProps does, parseXmlAttrs reads the attributes of a start tag.
+// The names must differ in their length, first 8 or last 8 bytes.
+template <typename... Fields>
+class schema
+{
+private:
+    static constexpr size_t N = sizeof...(Fields);
+    static_assert(N > 0 && N <= 64, "a schema has 1 to 64 fields");
+
+    static constexpr std::array<std::string_view, N> NAMES{ Fields::name... };
+
+    struct PerfectHash
+    {
+        uint64_t seed = 0;
+        unsigned bits = 0;
+        // the index of the field + 1 by the slot, 0 for an empty slot
+        std::array<uint8_t, std::bit_ceil(32 * N)> table{};
+    };
+
+    static constexpr bool hasDuplicates()
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            for (size_t j = i + 1; j < N; ++j)
+            {
+                if (NAMES[i] == NAMES[j])
+                    return true;
+            }
+        }
+        return false;
     }
+    static_assert(!hasDuplicates(), "the names of a schema must be unique");
 
-    // Returns the contents of the XML attribute
-    PatternSeeker getXmlAttr(std::string prop)
+    // Tries the seeds one by one for tables from 4 to 32 slots per field
+    static constexpr PerfectHash findPerfectHash()
     {
-        auto copy = *this;
-        if (!copy.to(prop, move_after))
-            return {};
-        copy.skipWhiteSpaces();
-        copy.expect("=");
-        copy.skipWhiteSpaces();
-        return copy.extract(DOUBLE_QUOTE, DOUBLE_QUOTE);
+        PerfectHash hash;
+        uint64_t state = 0x2545F4914F6CDD1Dull;
+        for (unsigned bits = std::bit_width(4 * N - 1); (1ull << bits) <= 32 * N; ++bits)
+        {
+            for (size_t attempt = 0; attempt < 1000; ++attempt)
+            {
+                // splitmix64
+                state += 0x9E3779B97F4A7C15ull;
+                uint64_t seed = state;
+                seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+                seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+                seed = (seed ^ (seed >> 31)) | 1;
+
+                hash.table = {};
+                bool perfect = true;
+                for (size_t i = 0; i < N && perfect; ++i)
+                {
+                    const size_t slot = (detail::schemaKey(NAMES[i]) * seed) >> (64 - bits);
+                    perfect = hash.table[slot] == 0;
+                    hash.table[slot] = static_cast<uint8_t>(i + 1);
+                }
+                if (perfect)
+                {
+                    hash.seed = seed;
+                    hash.bits = bits;
+                    return hash;
+                }
+            }
+        }
+        hash.bits = 0;
+        return hash;
     }
 
-    // useful to know where a string starts
-    size_t getOriginalPosition()
+    static constexpr PerfectHash HASH = findPerfectHash();
+    static_assert(HASH.bits != 0, "the names of a schema must differ in their length, first 8 or last 8 bytes");
+
+    // the lengths of the field names, see lengthBit()
+    static constexpr uint64_t LENGTHS = (detail::lengthBit(Fields::name.size()) | ...);
+
+    // A missing value: an empty PatternSeeker, an empty view, false or zero
+    template <typename T>
+    static T empty()
     {
-        return m_str.data() - m_originalPointer;
+        if constexpr (std::is_same_v<T, PatternSeeker>)
+            return PatternSeeker{};
+        else
+            return T{};
     }
 
-    // useful to know how much we've moved on.
-    // For example, buffer.commit(offset)
-    size_t getOffset()
+    template <FixedString Name>
+    static constexpr size_t indexOf()
     {
-        return m_str.data() - m_originalPointer;
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (NAMES[i] == Name.view())
+                return i;
+        }
+        return N;
     }
 
-    // output to the stream
-    friend std::ostream& operator<<(std::ostream& oss, const PatternSeeker& parser) {
-        return oss << parser.to_string_view();
+public:
+    // The values of the fields by their names, the missing ones are value-initialized
+    class Record
+    {
+    private:
+        std::tuple<typename Fields::type...> m_values{ empty<typename Fields::type>()... };
+        uint64_t m_found = 0;
+
+        friend class schema;
+
+    public:
+        template <FixedString Name>
+        const auto& get() const
+        {
+            constexpr size_t index = indexOf<Name>();
+            static_assert(index < N, "the schema has no such field");
+            return std::get<index>(m_values);
+        }
+
+        // Checks that the field was found and its value has the right type
+        template <FixedString Name>
+        bool has() const
+        {
+            constexpr size_t index = indexOf<Name>();
+            static_assert(index < N, "the schema has no such field");
+            return (m_found >> index) & 1;
+        }
+
+        // Checks that all the fields were found
+        bool complete() const
+        {
+            return m_found == (N == 64 ? ~0ull : (1ull << N) - 1);
+        }
+
+        // The bits of the found fields in the order of the schema
+        uint64_t found() const
+        {
+            return m_found;
+        }
+
+        // Builds an aggregate whose members are the fields in the order of the schema: `record.as<User>()`
+        template <typename Struct>
+        Struct as() const
+        {
+            return std::apply([](const auto&... values) { return Struct{ values... }; }, m_values);
+        }
+    };
+
+private:
+    // Returns the index of the field with the name or N, the data must be readable up to `end`
+    static size_t lookup(std::string_view name, const char* end)
+    {
+        if (!(LENGTHS & detail::lengthBit(name.size())))
+            return N;
+
+        const uint64_t key = name.size() < 8 && end - name.data() >= 8 ? detail::schemaKeyOfShort(name)
+                                                                        : detail::schemaKey(name);
+        const uint8_t entry = HASH.table[(key * HASH.seed) >> (64 - HASH.bits)];
+        if (entry == 0)
+            return N;
+
+        // the only candidate is compared with a name of a known size
+        size_t index = N;
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ((entry == I + 1 && name == NAMES[I] ? (index = I, true) : false) || ...);
+        }(std::index_sequence_for<Fields...>{});
+        return index;
+    }
+
+    template <typename T>
+    static bool convert(PatternSeeker value, T& out)
+    {
+        if constexpr (std::is_same_v<T, std::string_view>)
+        {
+            out = value.to_string_view();
+            return true;
+        }
+        else if constexpr (std::is_same_v<T, PatternSeeker>)
+        {
+            out = value;
+            return true;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            // the whole value, so `trueish` isn't taken for true
+            value.skipWhiteSpaces();
+            value.skipWhiteSpacesBack();
+            const std::string_view str = value.to_string_view();
+            if (str != "true" && str != "false")
+                return false;
+            out = str == "true";
+            return true;
+        }
+        else
+        {
+            static_assert(std::is_arithmetic_v<T>, "a field is a string_view, a PatternSeeker, a bool or a number");
+            const auto number = value.take<T>();
+            if (number)
+                out = *number;
+            return number.has_value();
+        }
+    }
+
+    static void assign(size_t index, PatternSeeker value, Record& record)
+    {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ((index == I ? (record.m_found |= uint64_t(convert(value, std::get<I>(record.m_values))) << I, true)
+                         : false) || ...);
+        }(std::index_sequence_for<Fields...>{});
+    }
+
+public:
+    // Finds the fields in a Json object in one pass. As with getJsonProps, only the names are matched,
+    // not the string values as in getJsonProp, nested objects are searched too and the first occurrence
+    // of a name wins; a value of a wrong type leaves the field missing.
+    static Record parseJson(PatternSeeker data)
+    {
+        Record record;
+        uint64_t seen = 0;
+        size_t remaining = N;
+        data.forEachJsonName(remaining, [&](size_t open, size_t close) {
+            const size_t index = lookup(data.m_str.substr(open + 1, close - open - 1), data.m_str.data() + data.m_str.size());
+            if (index == N || ((seen >> index) & 1))
+                return;
+
+            PatternSeeker value;
+            if (!data.valueAfterName(close, value))
+                return;
+
+            seen |= 1ull << index;
+            --remaining;
+            assign(index, value, record);
+        });
+        return record;
+    }
+
+    // Reads the attributes of the first start tag in the data: `<user id="7" name='Ann'>`.
+    // Unlike getXmlAttr, only whole attribute names match, so `id` isn't found in `uid="1"`.
+    static Record parseXmlAttrs(PatternSeeker data)
+    {
+        Record record;
+        if (!data.to("<", move_after))
+            return record;
+
+        static constexpr CharClass NAME_END = CharClass::spaces() | CharClass("=/>");
+        data.skipWhile(~NAME_END);
+        while (true)
+        {
+            data.skipWhiteSpaces();
+            const auto name = data.takeWhile(~NAME_END);
+            if (name.isEmpty())
+                break;
+
+            data.skipWhiteSpaces();
+            if (!data.expect("="))
+                break;
+
+            data.skipWhiteSpaces();
+            // an unquoted value ends the tag, the quote isn't searched in the next ones
+            const std::string_view quote = data.startsWith("'") ? "'" : "\"";
+            if (!data.expect(quote))
+                break;
+            const auto value = data.extract(quote, move_after);
+            if (value.to_string_view().data() == PatternSeeker::EMPTY_STR)
+                break;
+
+            const size_t index = lookup(name.to_string_view(), data.m_str.data() + data.m_str.size());
+            if (index != N && !((record.m_found >> index) & 1))
+                assign(index, value, record);
+        }
+        return record;
     }
 };
 
+inline PatternSeeker::JsonElements PatternSeeker::jsonArrayElements() const
+{
+    return JsonElements(*this);
+}
+
+inline PatternSeeker::XmlChildren PatternSeeker::xmlChildren(std::string_view name) const
+{
+    return XmlChildren(*this, name);
+}
+
+inline PatternSeeker::Fields PatternSeeker::fields(std::string_view delims, bool quoted) const
+{
+    return Fields(*this, delims, quoted);
+}
+
 }
 
+// The iterators of the ranges keep their own views of the data, so they may outlive the ranges
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<PatterSeekerNS::PatternSeeker::JsonElements> = true;
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<PatterSeekerNS::PatternSeeker::XmlChildren> = true;
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<PatterSeekerNS::PatternSeeker::Fields> = true;
+
 #endif
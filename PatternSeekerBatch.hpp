@@ -0,0 +1,426 @@
+#ifndef PATTERN_SEEKER_BATCH_H
+#define PATTERN_SEEKER_BATCH_H
+
+#include "PatternSeeker.hpp"
+
+#include <span>
+#include <vector>
+#include <memory_resource>
+
+#if defined(_MSC_VER) && defined(PATTERN_SEEKER_X86)
+#include <xmmintrin.h>
+#endif
+
+namespace PatterSeekerNS {
+
+// The type of an output column of an ExtractionPlan
+enum class ColumnType
+{
+    string,
+    uint64,
+    int64,
+    float64,
+};
+
+// ExtractionPlan is a sequence of PatternSeeker calls that is compiled once and applied to every record of a batch:
+// `ExtractionPlan plan; plan.to("user=").extract(" ").to("bytes=", move_after).takeUInt64();`
+// Every call that produces a value adds an output column, the columns are numbered in the order of the calls.
+// The calls move the pointer as the PatternSeeker methods of the same names do, except that `to` and `extract`
+// move after the match by default (not `none`), as a plan walks through the record.
+// A record stops at the first failed call, the columns of the calls after it stay empty or zero.
+class ExtractionPlan
+{
+public:
+    enum Operation : uint8_t
+    {
+        to_operation,
+        expect_operation,
+        skip_operation,
+        skip_whitespaces_operation,
+        extract_between_operation,
+        extract_to_operation,
+        json_prop_operation,
+        take_uint64_operation,
+        take_int64_operation,
+        take_double_operation,
+    };
+
+    struct Step
+    {
+        Operation operation;
+        MoveMode mode;
+        // the index of the column among the columns of its type
+        uint32_t slot;
+        // the pattern offsets and sizes; skip_operation keeps the low half of its count in `first`, the high one in `second`
+        uint32_t first;
+        uint32_t firstSize;
+        uint32_t second;
+        uint32_t secondSize;
+    };
+
+private:
+    std::pmr::string m_patterns;
+    std::pmr::vector<Step> m_steps;
+    std::pmr::vector<ColumnType> m_columns;
+    std::pmr::vector<uint32_t> m_slots;
+    std::array<uint32_t, 4> m_typeCounts{};
+
+    uint32_t addPattern(std::string_view pattern)
+    {
+        const auto offset = static_cast<uint32_t>(m_patterns.size());
+        m_patterns.append(pattern);
+        return offset;
+    }
+
+    ExtractionPlan& add(Operation operation, MoveMode mode, std::string_view first = {}, std::string_view second = {})
+    {
+        const uint32_t firstOffset = addPattern(first);
+        const uint32_t secondOffset = addPattern(second);
+        m_steps.push_back({ operation, mode, 0, firstOffset, static_cast<uint32_t>(first.size()),
+                            secondOffset, static_cast<uint32_t>(second.size()) });
+        return *this;
+    }
+
+    ExtractionPlan& addColumn(Operation operation, ColumnType type, MoveMode mode,
+                              std::string_view first = {}, std::string_view second = {})
+    {
+        add(operation, mode, first, second);
+        auto& count = m_typeCounts[static_cast<size_t>(type)];
+        m_steps.back().slot = count;
+        m_columns.push_back(type);
+        m_slots.push_back(count++);
+        return *this;
+    }
+
+public:
+    explicit ExtractionPlan(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_patterns(resource)
+        , m_steps(resource)
+        , m_columns(resource)
+        , m_slots(resource)
+    {}
+
+    ExtractionPlan& to(std::string_view expected, MoveMode mode = move_after)
+    {
+        return add(to_operation, mode, expected);
+    }
+
+    ExtractionPlan& expect(std::string_view expected)
+    {
+        return add(expect_operation, none, expected);
+    }
+
+    ExtractionPlan& skip(size_t n)
+    {
+        add(skip_operation, none);
+        m_steps.back().first = static_cast<uint32_t>(n);
+        m_steps.back().second = static_cast<uint32_t>(uint64_t(n) >> 32);
+        return *this;
+    }
+
+    ExtractionPlan& skipWhiteSpaces()
+    {
+        return add(skip_whitespaces_operation, none);
+    }
+
+    // A string column between `from` and `to`
+    ExtractionPlan& extract(std::string_view from, std::string_view to, MoveMode mode = move_after)
+    {
+        return addColumn(extract_between_operation, ColumnType::string, mode, from, to);
+    }
+
+    // A string column from the current position `to` the string
+    ExtractionPlan& extract(std::string_view to, MoveMode mode = move_after)
+    {
+        return addColumn(extract_to_operation, ColumnType::string, mode, to);
+    }
+
+    // A string column of a Json property, the pointer doesn't move
+    ExtractionPlan& getJsonProp(std::string_view name)
+    {
+        return addColumn(json_prop_operation, ColumnType::string, none, name);
+    }
+
+    ExtractionPlan& takeUInt64()
+    {
+        return addColumn(take_uint64_operation, ColumnType::uint64, none);
+    }
+
+    ExtractionPlan& takeInt64()
+    {
+        return addColumn(take_int64_operation, ColumnType::int64, none);
+    }
+
+    ExtractionPlan& takeDouble()
+    {
+        return addColumn(take_double_operation, ColumnType::float64, none);
+    }
+
+    std::span<const Step> steps() const
+    {
+        return m_steps;
+    }
+
+    // The patterns of all the steps, a step refers to them by offsets
+    std::string_view patterns() const
+    {
+        return m_patterns;
+    }
+
+    // Returns the number of output columns
+    size_t columns() const
+    {
+        return m_columns.size();
+    }
+
+    ColumnType columnType(size_t column) const
+    {
+        return m_columns[column];
+    }
+
+    // Returns the index of the column among the columns of its type
+    size_t columnSlot(size_t column) const
+    {
+        return m_slots[column];
+    }
+
+    // Returns the number of columns of the type
+    size_t columnCount(ColumnType type) const
+    {
+        return m_typeCounts[static_cast<size_t>(type)];
+    }
+};
+
+// The output of a batch as structure of arrays: one contiguous column per value of the plan,
+// so the values of one field of all the records are next to each other.
+// The string columns are views of the inputs. Reuse the object for the next batch to keep its memory.
+class BatchResult
+{
+private:
+    size_t m_size = 0;
+    std::pmr::vector<uint8_t> m_valid;
+    // the columns of one type one after another, m_size values each
+    std::pmr::vector<std::string_view> m_strings;
+    std::pmr::vector<uint64_t> m_uint64s;
+    std::pmr::vector<int64_t> m_int64s;
+    std::pmr::vector<double> m_doubles;
+    const ExtractionPlan* m_plan = nullptr;
+
+    template <typename T>
+    std::span<const T> column(const std::pmr::vector<T>& values, size_t column, ColumnType type) const
+    {
+        if (!m_plan || column >= m_plan->columns() || m_plan->columnType(column) != type)
+            return {};
+        return std::span<const T>(values).subspan(m_plan->columnSlot(column) * m_size, m_size);
+    }
+
+    friend class BatchExecutor;
+
+public:
+    explicit BatchResult(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_valid(resource)
+        , m_strings(resource)
+        , m_uint64s(resource)
+        , m_int64s(resource)
+        , m_doubles(resource)
+    {}
+
+    // Returns the number of records
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    // 1 for every record where all the calls of the plan succeeded
+    std::span<const uint8_t> valid() const
+    {
+        return m_valid;
+    }
+
+    // The columns by their numbers in the plan, a column of another type is empty
+    std::span<const std::string_view> strings(size_t column) const
+    {
+        return this->column(m_strings, column, ColumnType::string);
+    }
+
+    std::span<const uint64_t> uint64s(size_t column) const
+    {
+        return this->column(m_uint64s, column, ColumnType::uint64);
+    }
+
+    std::span<const int64_t> int64s(size_t column) const
+    {
+        return this->column(m_int64s, column, ColumnType::int64);
+    }
+
+    std::span<const double> doubles(size_t column) const
+    {
+        return this->column(m_doubles, column, ColumnType::float64);
+    }
+};
+
+namespace detail {
+
+// A hint to bring the line into the caches before it is read
+inline void prefetch(const void* address)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && defined(PATTERN_SEEKER_X86)
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+}
+
+// BatchExecutor applies a plan to many small records, like lines of a log.
+// The records are processed in chunks; while a chunk is parsed, the first cache lines
+// of the records of the next one are prefetched, so their loads overlap with the work
+// and the plan and its patterns stay hot in the caches for the whole batch.
+class BatchExecutor
+{
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    const ExtractionPlan& m_plan;
+    size_t m_prefetchDistance;
+    size_t m_prefetchBytes;
+
+    void prefetchRecord(std::string_view record) const
+    {
+        const size_t bytes = std::min(record.size(), m_prefetchBytes);
+        for (size_t offset = 0; offset < bytes; offset += CACHE_LINE)
+            detail::prefetch(record.data() + offset);
+    }
+
+    // The output columns of one batch
+    struct Columns
+    {
+        size_t size;
+        std::string_view* strings;
+        uint64_t* uint64s;
+        int64_t* int64s;
+        double* doubles;
+    };
+
+    // A failed search returns an empty seeker that doesn't point into the record
+    static bool store(const PatternSeeker& value, std::string_view record, std::string_view& cell)
+    {
+        const char* data = value.to_string_view().data();
+        if (data < record.data() || data > record.data() + record.size())
+            return false;
+        cell = value.to_string_view();
+        return true;
+    }
+
+    // Runs the steps over one record and writes its values to row `row`
+    bool runRecord(std::string_view record, size_t row, const Columns& columns) const
+    {
+        const char* patterns = m_plan.patterns().data();
+        const auto first = [patterns](const ExtractionPlan::Step& step) {
+            return std::string_view(patterns + step.first, step.firstSize);
+        };
+
+        PatternSeeker ps(record);
+        for (const auto& step : m_plan.steps())
+        {
+            const size_t cell = step.slot * columns.size + row;
+            switch (step.operation)
+            {
+            case ExtractionPlan::to_operation:
+                if (!ps.to(first(step), step.mode))
+                    return false;
+                break;
+            case ExtractionPlan::expect_operation:
+                if (!ps.expect(first(step)))
+                    return false;
+                break;
+            case ExtractionPlan::skip_operation:
+            {
+                const uint64_t n = uint64_t(step.second) << 32 | step.first;
+                if (ps.size() < n)
+                    return false;
+                ps.skip(size_t(n));
+                break;
+            }
+            case ExtractionPlan::skip_whitespaces_operation:
+                ps.skipWhiteSpaces();
+                break;
+            case ExtractionPlan::extract_between_operation:
+                if (!store(ps.extract(first(step), std::string_view(patterns + step.second, step.secondSize), step.mode),
+                           record, columns.strings[cell]))
+                    return false;
+                break;
+            case ExtractionPlan::extract_to_operation:
+                if (!store(ps.extract(first(step), step.mode), record, columns.strings[cell]))
+                    return false;
+                break;
+            case ExtractionPlan::json_prop_operation:
+                if (!store(ps.getJsonProp(first(step)), record, columns.strings[cell]))
+                    return false;
+                break;
+            case ExtractionPlan::take_uint64_operation:
+                if (auto value = ps.takeUInt64())
+                    columns.uint64s[cell] = *value;
+                else
+                    return false;
+                break;
+            case ExtractionPlan::take_int64_operation:
+                if (auto value = ps.takeInt64())
+                    columns.int64s[cell] = *value;
+                else
+                    return false;
+                break;
+            case ExtractionPlan::take_double_operation:
+                if (auto value = ps.takeDouble())
+                    columns.doubles[cell] = *value;
+                else
+                    return false;
+                break;
+            }
+        }
+        return true;
+    }
+
+public:
+    // `prefetchDistance` records ahead are prefetched, up to `prefetchBytes` of each one; 0 turns prefetching off
+    explicit BatchExecutor(const ExtractionPlan& plan, size_t prefetchDistance = 16, size_t prefetchBytes = 256)
+        : m_plan(plan)
+        , m_prefetchDistance(prefetchDistance)
+        , m_prefetchBytes(prefetchBytes)
+    {}
+
+    // Parses all the records to `result`, which is resized to them
+    void run(std::span<const std::string_view> records, BatchResult& result) const
+    {
+        const size_t size = records.size();
+        result.m_plan = &m_plan;
+        result.m_size = size;
+        result.m_valid.assign(size, 0);
+        result.m_strings.assign(m_plan.columnCount(ColumnType::string) * size, std::string_view{});
+        result.m_uint64s.assign(m_plan.columnCount(ColumnType::uint64) * size, 0);
+        result.m_int64s.assign(m_plan.columnCount(ColumnType::int64) * size, 0);
+        result.m_doubles.assign(m_plan.columnCount(ColumnType::float64) * size, 0.0);
+        const Columns columns{ size, result.m_strings.data(), result.m_uint64s.data(),
+                               result.m_int64s.data(), result.m_doubles.data() };
+
+        // the records are still parsed in chunks when nothing is prefetched
+        const size_t step = std::max<size_t>(m_prefetchDistance, 1);
+        for (size_t chunk = 0; chunk < size; chunk += step)
+        {
+            const size_t end = std::min(size, chunk + step);
+            const size_t ahead = std::min(size, end + m_prefetchDistance);
+            for (size_t i = end; i < ahead; ++i)
+                prefetchRecord(records[i]);
+
+            for (size_t i = chunk; i < end; ++i)
+                result.m_valid[i] = runRecord(records[i], i, columns);
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef PATTERN_SEEKER_CACHE_H
+#define PATTERN_SEEKER_CACHE_H
+
+#include "PatternSeeker.hpp"
+
+namespace PatterSeekerNS {
+
+// CachedSeeker remembers the results of the lookups on one buffer, so the rules that run the same
+// lookups on the same message scan it only once:
+// `CachedSeeker message(ps); for (auto& rule : rules) { message.reset(ps); rule(message); }`
+// It moves like a PatternSeeker and the results are the same views. A result is keyed by the operation,
+// its patterns and the visible part of the cursor, so it is found again from the same position only.
+// The table has a fixed number of slots and doesn't allocate; when it is full, old results are replaced.
+// Patterns longer than MAX_PATTERN_BYTES aren't cached. The cache belongs to the buffer its first
+// PatternSeeker points to: reset() with a view of another buffer clears it. If the bytes
+// of the buffer change in place, call clear().
+class CachedSeeker
+{
+public:
+    static constexpr size_t CAPACITY = 64;
+    static constexpr size_t MAX_PATTERN_BYTES = 32;
+
+private:
+    enum Operation : uint8_t
+    {
+        to_operation = 1,
+        extract_between_operation,
+        extract_operation,
+        json_prop_operation,
+        xml_attr_operation,
+        xml_tag_operation,
+    };
+
+    struct Entry
+    {
+        uint64_t hash = 0;
+        // the slot is empty unless it is the current generation
+        uint32_t generation = 0;
+        size_t begin = 0;
+        size_t end = 0;
+        Operation operation{};
+        uint8_t firstSize = 0;
+        uint8_t secondSize = 0;
+        bool found = false;
+        char patterns[MAX_PATTERN_BYTES];
+        // the result and the positions for move_before and move_after, relative to the original pointer
+        size_t resultBegin = 0;
+        size_t resultSize = 0;
+        size_t before = 0;
+        size_t after = 0;
+    };
+
+    static constexpr size_t MAX_PROBES = 8;
+    static_assert(std::has_single_bit(CAPACITY));
+
+    PatternSeeker m_seeker;
+    std::array<Entry, CAPACITY> m_entries{};
+    // clearing the cache starts a new generation, so it doesn't touch the entries
+    uint32_t m_generation = 1;
+    // the result of the last lookup whose patterns are too long to be cached
+    Entry m_uncached;
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+
+    size_t offset(const PatternSeeker& ps) const
+    {
+        return ps.m_str.data() - m_seeker.m_originalPointer;
+    }
+
+    PatternSeeker view(size_t begin, size_t size) const
+    {
+        return PatternSeeker{std::string_view(m_seeker.m_originalPointer + begin, size), m_seeker.m_originalPointer};
+    }
+
+    // The full key is compared anyway, so the hash only has to spread the slots
+    static uint64_t hashKey(Operation operation, size_t begin, size_t end, std::string_view first, std::string_view second)
+    {
+        uint64_t hash = (begin * 0x9E3779B97F4A7C15ull) ^ (end * 0xC2B2AE3D27D4EB4Full)
+            ^ (uint64_t(operation) << 56 | first.size() << 8 | second.size());
+        for (const auto pattern : { first, second })
+        {
+            for (size_t i = 0; i < pattern.size(); i += 8)
+            {
+                uint64_t word = 0;
+                if (i + 8 <= pattern.size())
+                    std::memcpy(&word, pattern.data() + i, 8);
+                else
+                    for (size_t j = i; j < pattern.size(); ++j)
+                        word = word << 8 | static_cast<unsigned char>(pattern[j]);
+                hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+            }
+        }
+        return hash ^ (hash >> 32);
+    }
+
+    // Returns the result of `search(copy)` for the current position, searching only on a miss.
+    // `search` runs on a copy of the cursor and fills the entry as if the copy moved before the match.
+    template <typename Search>
+    const Entry& lookup(Operation operation, std::string_view first, std::string_view second, Search&& search)
+    {
+        const size_t begin = offset(m_seeker);
+        const size_t end = begin + m_seeker.size();
+        Entry* slot = &m_uncached;
+        if (first.size() + second.size() <= MAX_PATTERN_BYTES)
+        {
+            const uint64_t hash = hashKey(operation, begin, end, first, second);
+            const size_t home = hash & (CAPACITY - 1);
+            slot = nullptr;
+            for (size_t probe = 0; probe < MAX_PROBES; ++probe)
+            {
+                Entry& entry = m_entries[(home + probe) & (CAPACITY - 1)];
+                if (entry.generation != m_generation)
+                {
+                    slot = &entry;
+                    break;
+                }
+                if (entry.hash == hash && entry.begin == begin && entry.end == end && entry.operation == operation
+                    && entry.firstSize == first.size() && entry.secondSize == second.size()
+                    && std::string_view(entry.patterns, first.size()) == first
+                    && std::string_view(entry.patterns + first.size(), second.size()) == second)
+                {
+                    ++m_hits;
+                    return entry;
+                }
+            }
+            // the probed slots are full, so the home one is replaced
+            if (!slot)
+                slot = &m_entries[home];
+
+            slot->hash = hash;
+            slot->generation = m_generation;
+            slot->begin = begin;
+            slot->end = end;
+            slot->operation = operation;
+            slot->firstSize = static_cast<uint8_t>(first.size());
+            slot->secondSize = static_cast<uint8_t>(second.size());
+            if (!first.empty())
+                std::memcpy(slot->patterns, first.data(), first.size());
+            if (!second.empty())
+                std::memcpy(slot->patterns + first.size(), second.data(), second.size());
+        }
+
+        ++m_misses;
+        slot->found = false;
+        auto copy = m_seeker;
+        search(copy, *slot);
+        return *slot;
+    }
+
+    void setResult(Entry& entry, const PatternSeeker& result, size_t before, size_t after) const
+    {
+        entry.found = true;
+        entry.resultBegin = offset(result);
+        entry.resultSize = result.size();
+        entry.before = before;
+        entry.after = after;
+    }
+
+    void move(const Entry& entry, MoveMode mode)
+    {
+        if (!entry.found || mode == none)
+            return;
+        m_seeker.skip((mode == move_before ? entry.before : entry.after) - offset(m_seeker));
+    }
+
+    PatternSeeker result(const Entry& entry) const
+    {
+        return entry.found ? view(entry.resultBegin, entry.resultSize) : PatternSeeker{};
+    }
+
+    static bool found(const PatternSeeker& result)
+    {
+        return result.m_str.data() != PatternSeeker::EMPTY_STR;
+    }
+
+public:
+    explicit CachedSeeker(PatternSeeker seeker)
+        : m_seeker(seeker)
+    {}
+
+    CachedSeeker(const CachedSeeker&) = delete;
+    CachedSeeker& operator=(const CachedSeeker&) = delete;
+
+    // Moves the cursor to `seeker`. The results stay if it is a view of the same buffer.
+    void reset(PatternSeeker seeker)
+    {
+        if (seeker.m_originalPointer != m_seeker.m_originalPointer)
+            clear();
+        m_seeker = seeker;
+    }
+
+    // Forgets all the results
+    void clear()
+    {
+        if (++m_generation == 0)
+        {
+            for (auto& entry : m_entries)
+                entry.generation = 0;
+            m_generation = 1;
+        }
+    }
+
+    // Returns the cursor
+    const PatternSeeker& seeker() const
+    {
+        return m_seeker;
+    }
+
+    size_t hits() const
+    {
+        return m_hits;
+    }
+
+    size_t misses() const
+    {
+        return m_misses;
+    }
+
+    bool to(std::string_view expected, MoveMode mode=none)
+    {
+        const Entry& entry = lookup(to_operation, expected, {}, [&](PatternSeeker& copy, Entry& out) {
+            if (copy.to(expected, move_before))
+                setResult(out, copy.extract(size_t(0)), offset(copy), offset(copy) + expected.size());
+        });
+        move(entry, mode);
+        return entry.found;
+    }
+
+    PatternSeeker extract(std::string_view from, std::string_view to, MoveMode mode=none)
+    {
+        const Entry& entry = lookup(extract_between_operation, from, to, [&](PatternSeeker& copy, Entry& out) {
+            const auto res = copy.extract(from, to, move_before);
+            if (found(res))
+                setResult(out, res, offset(copy), offset(res) + res.size() + to.size());
+        });
+        move(entry, mode);
+        return result(entry);
+    }
+
+    PatternSeeker extract(std::string_view to, MoveMode mode=none)
+    {
+        const Entry& entry = lookup(extract_operation, to, {}, [&](PatternSeeker& copy, Entry& out) {
+            const auto res = copy.extract(to, move_before);
+            if (found(res))
+                setResult(out, res, offset(copy), offset(copy) + to.size());
+        });
+        move(entry, mode);
+        return result(entry);
+    }
+
+    PatternSeeker getJsonProp(std::string_view prop)
+    {
+        return result(lookup(json_prop_operation, prop, {}, [&](PatternSeeker& copy, Entry& out) {
+            const auto res = copy.getJsonProp(prop);
+            if (found(res))
+                setResult(out, res, 0, 0);
+        }));
+    }
+
+    PatternSeeker getXmlAttr(std::string_view prop)
+    {
+        return result(lookup(xml_attr_operation, prop, {}, [&](PatternSeeker& copy, Entry& out) {
+            const auto res = copy.getXmlAttr(prop);
+            if (found(res))
+                setResult(out, res, 0, 0);
+        }));
+    }
+
+    PatternSeeker getXmlTag(std::string_view prop, MoveMode mode=none)
+    {
+        const Entry& entry = lookup(xml_tag_operation, prop, {}, [&](PatternSeeker& copy, Entry& out) {
+            const auto res = copy.getXmlTag(prop, move_before);
+            if (found(res))
+                setResult(out, res, offset(res), offset(res) + res.size());
+        });
+        move(entry, mode);
+        return result(entry);
+    }
+
+    // The body is taken from the cached tag
+    PatternSeeker getXmlTagBody(std::string_view prop, MoveMode mode=none)
+    {
+        const auto tag = getXmlTag(prop, mode);
+        return found(tag) ? tag.xmlTagBody() : PatternSeeker{};
+    }
+};
+
+}
+
+#endif
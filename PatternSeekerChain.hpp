@@ -0,0 +1,194 @@
+#ifndef PATTERN_SEEKER_CHAIN_H
+#define PATTERN_SEEKER_CHAIN_H
+
+#include "PatternSeeker.hpp"
+
+namespace PatterSeekerNS {
+
+// SeekChain runs a chain of PatternSeeker calls and stops at the first one that fails:
+// `SeekChain(ps).to("host=", move_after).extract(" ", host, move_after).to("status=", move_after).take(status)`
+// The results are written to the references passed to the steps. After a failure the following steps
+// return at once without scanning, so a message that doesn't match costs only the steps up to the failed one.
+// The chain remembers the number of the failed step, counted from 0, and the offset of the cursor
+// before it, and the cursor stays there.
+class SeekChain
+{
+public:
+    static constexpr size_t NO_STEP = static_cast<size_t>(-1);
+
+private:
+    PatternSeeker m_seeker;
+    size_t m_step = 0;
+    size_t m_failedStep = NO_STEP;
+    size_t m_failedOffset = 0;
+
+    static bool found(const PatternSeeker& result)
+    {
+        return result.m_str.data() != PatternSeeker::EMPTY_STR;
+    }
+
+    // Runs `step(seeker)` unless the chain has failed; a step that returns false fails the chain
+    template <typename Step>
+    SeekChain& run(Step&& step)
+    {
+        if (m_failedStep != NO_STEP)
+            return *this;
+
+        const PatternSeeker before = m_seeker;
+        if (!step(m_seeker))
+        {
+            m_failedStep = m_step;
+            m_failedOffset = before.m_str.data() - before.m_originalPointer;
+            m_seeker = before;
+        }
+        ++m_step;
+        return *this;
+    }
+
+    template <typename Extract>
+    SeekChain& extractStep(PatternSeeker& out, Extract&& extract)
+    {
+        return run([&](PatternSeeker& ps) {
+            out = extract(ps);
+            return found(out);
+        });
+    }
+
+public:
+    explicit SeekChain(PatternSeeker seeker)
+        : m_seeker(seeker)
+    {}
+
+    bool ok() const
+    {
+        return m_failedStep == NO_STEP;
+    }
+
+    explicit operator bool() const
+    {
+        return ok();
+    }
+
+    // The number of the failed step, or NO_STEP
+    size_t failedStep() const
+    {
+        return m_failedStep;
+    }
+
+    // The offset of the cursor before the failed step
+    size_t failedOffset() const
+    {
+        return m_failedOffset;
+    }
+
+    // The cursor after the last successful step
+    const PatternSeeker& seeker() const
+    {
+        return m_seeker;
+    }
+
+    SeekChain& expect(std::string_view expected)
+    {
+        return run([&](PatternSeeker& ps) { return ps.expect(expected); });
+    }
+
+    SeekChain& to(std::string_view expected, MoveMode mode=none)
+    {
+        return run([&](PatternSeeker& ps) { return ps.to(expected, mode); });
+    }
+
+    template <FixedString Str>
+    SeekChain& to(pattern<Str> expected, MoveMode mode=none)
+    {
+        return run([&](PatternSeeker& ps) { return ps.to(expected, mode); });
+    }
+
+    // Fails if there are less than `n` elements
+    SeekChain& skip(size_t n)
+    {
+        return run([&](PatternSeeker& ps) {
+            if (ps.size() < n)
+                return false;
+            ps.skip(n);
+            return true;
+        });
+    }
+
+    // to avoid implicit convertion
+    SeekChain& skip(char n) = delete;
+
+    // Never fails, but isn't run after a failure
+    SeekChain& skipWhiteSpaces()
+    {
+        return run([](PatternSeeker& ps) {
+            ps.skipWhiteSpaces();
+            return true;
+        });
+    }
+
+    SeekChain& extract(std::string_view from, std::string_view to, PatternSeeker& out, MoveMode mode=none)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.extract(from, to, mode); });
+    }
+
+    template <FixedString From, FixedString To>
+    SeekChain& extract(pattern<From> from, pattern<To> to, PatternSeeker& out, MoveMode mode=none)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.extract(from, to, mode); });
+    }
+
+    SeekChain& extract(std::string_view to, PatternSeeker& out, MoveMode mode=none)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.extract(to, mode); });
+    }
+
+    template <FixedString To>
+    SeekChain& extract(pattern<To> to, PatternSeeker& out, MoveMode mode=none)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.extract(to, mode); });
+    }
+
+    // Extracts the balanced `start`...`end` block
+    SeekChain& extract(char start, char end, PatternSeeker& out, MoveMode mode=none)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.extract(start, end, mode); });
+    }
+
+    SeekChain& getJsonProp(std::string_view prop, PatternSeeker& out)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.getJsonProp(prop); });
+    }
+
+    SeekChain& getXmlTag(std::string_view prop, PatternSeeker& out, MoveMode mode=none)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.getXmlTag(prop, mode); });
+    }
+
+    SeekChain& getXmlAttr(std::string_view prop, PatternSeeker& out)
+    {
+        return extractStep(out, [&](PatternSeeker& ps) { return ps.getXmlAttr(prop); });
+    }
+
+    // Parses a number and moves the pointer after it
+    template <typename T>
+    SeekChain& take(T& out)
+    {
+        return run([&](PatternSeeker& ps) {
+            const auto res = ps.take<T>();
+            if (res)
+                out = *res;
+            return res.has_value();
+        });
+    }
+
+    // A custom step, `step(PatternSeeker&)` returns false on failure
+    template <typename Step>
+    SeekChain& then(Step&& step)
+    {
+        return run(std::forward<Step>(step));
+    }
+};
+
+}
+
+#endif
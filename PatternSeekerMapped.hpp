@@ -0,0 +1,341 @@
+#ifndef PATTERN_SEEKER_MAPPED_H
+#define PATTERN_SEEKER_MAPPED_H
+
+#include "PatternSeeker.hpp"
+
+#include <string>
+#include <iterator>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PatterSeekerNS {
+
+// Hints about how the mapped file is going to be read, they can be combined with `|`
+enum MapAdvice : unsigned
+{
+    advice_none = 0,
+    // read-ahead aggressively and drop the pages behind
+    advice_sequential = 1 << 0,
+    // don't read ahead
+    advice_random = 1 << 1,
+    // ask for transparent huge pages where the kernel supports them for files
+    advice_huge_pages = 1 << 2,
+    // fault the whole file in right away
+    advice_populate = 1 << 3,
+};
+
+constexpr MapAdvice operator|(MapAdvice left, MapAdvice right)
+{
+    return static_cast<MapAdvice>(static_cast<unsigned>(left) | static_cast<unsigned>(right));
+}
+
+// The records of the data one by one, either separated by a delimiter
+// or framed by balanced brackets, see MappedPatternSeeker::records().
+// Every record is a PatternSeeker over the same data, so getOffset() is the offset in the whole data.
+class RecordRange
+{
+private:
+    PatternSeeker m_data;
+    char m_delimiter = '\n';
+    char m_end = 0;
+
+public:
+    class iterator
+    {
+    private:
+        const RecordRange* m_range = nullptr;
+        PatternSeeker m_rest{std::string_view{}};
+        PatternSeeker m_record{std::string_view{}};
+
+        void next()
+        {
+            if (m_range->m_end)
+            {
+                // strings may contain brackets, so the frames are matched outside of them
+                m_record = m_rest.extractQuoteAware(m_range->m_delimiter, m_range->m_end, move_after);
+                return;
+            }
+
+            // empty records are skipped, so are "\n\n" and a trailing delimiter
+            while (m_rest.isNotEmpty())
+            {
+                const std::string_view rest = m_rest.to_string_view();
+                const size_t pos = rest.find(m_range->m_delimiter);
+                if (pos == std::string_view::npos)
+                {
+                    m_record = m_rest.extract(rest.size(), move_after);
+                }
+                else
+                {
+                    m_record = m_rest.extract(pos, move_after);
+                    m_rest.skip(size_t(1));
+                }
+                if (m_record.isNotEmpty())
+                    return;
+            }
+            m_record = PatternSeeker{std::string_view{}};
+        }
+
+    public:
+        using value_type = PatternSeeker;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        explicit iterator(const RecordRange& range)
+            : m_range(&range)
+            , m_rest(range.m_data)
+        {
+            next();
+        }
+
+        PatternSeeker operator*() const
+        {
+            return m_record;
+        }
+
+        iterator& operator++()
+        {
+            next();
+            return *this;
+        }
+
+        void operator++(int)
+        {
+            next();
+        }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t)
+        {
+            return it.m_record.isEmpty();
+        }
+    };
+
+    // Records separated by `delimiter`
+    RecordRange(PatternSeeker data, char delimiter)
+        : m_data(data)
+        , m_delimiter(delimiter)
+    {}
+
+    // Records from `start` to the matching `end`, whatever is between them is skipped
+    RecordRange(PatternSeeker data, char start, char end)
+        : m_data(data)
+        , m_delimiter(start)
+        , m_end(end)
+    {}
+
+    iterator begin() const
+    {
+        return iterator(*this);
+    }
+
+    std::default_sentinel_t end() const
+    {
+        return {};
+    }
+};
+
+// MappedPatternSeeker maps a file to memory (mmap on POSIX, CreateFileMapping on Windows)
+// and shows it as a PatternSeeker, so a file is parsed without copying it with read().
+// The views it returns are valid while the object lives.
+class MappedPatternSeeker
+{
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data)
+            munmap(const_cast<char*>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+        m_open = false;
+    }
+
+#if defined(_WIN32)
+    void map(const std::string& path, MapAdvice advice)
+    {
+        const DWORD flags = (advice & advice_sequential) ? FILE_FLAG_SEQUENTIAL_SCAN
+            : (advice & advice_random) ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL;
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size))
+            return;
+        m_open = true;
+        // an empty file can't be mapped, but it is an empty document
+        if (size.QuadPart == 0)
+            return;
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping || !(m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0))))
+        {
+            close();
+            return;
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+
+        if (advice & advice_populate)
+        {
+            WIN32_MEMORY_RANGE_ENTRY range{ const_cast<char*>(m_data), m_size };
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+        }
+    }
+#else
+    void map(const std::string& path, MapAdvice advice)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return;
+        }
+        m_open = true;
+        // an empty file can't be mapped, but it is an empty document
+        if (info.st_size == 0)
+        {
+            ::close(fd);
+            return;
+        }
+
+        int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+        if (advice & advice_populate)
+            flags |= MAP_POPULATE;
+#endif
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, flags, fd, 0);
+        // the mapping keeps the file, the descriptor isn't needed anymore
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            m_open = false;
+            return;
+        }
+        m_data = static_cast<const char*>(data);
+        m_size = static_cast<size_t>(info.st_size);
+
+        // the hints are only hints, their failures are ignored
+        if (advice & advice_sequential)
+            madvise(data, m_size, MADV_SEQUENTIAL);
+        if (advice & advice_random)
+            madvise(data, m_size, MADV_RANDOM);
+#if defined(MADV_HUGEPAGE)
+        if (advice & advice_huge_pages)
+            madvise(data, m_size, MADV_HUGEPAGE);
+#endif
+        if (advice & advice_populate)
+            madvise(data, m_size, MADV_WILLNEED);
+    }
+#endif
+
+public:
+    MappedPatternSeeker() = default;
+
+    // Maps the whole file for reading. Check isOpen() for errors.
+    explicit MappedPatternSeeker(const std::string& path, MapAdvice advice = advice_sequential)
+    {
+        map(path, advice);
+    }
+
+    MappedPatternSeeker(const MappedPatternSeeker&) = delete;
+    MappedPatternSeeker& operator=(const MappedPatternSeeker&) = delete;
+
+    MappedPatternSeeker(MappedPatternSeeker&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedPatternSeeker& operator=(MappedPatternSeeker&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+            std::swap(m_open, other.m_open);
+#if defined(_WIN32)
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedPatternSeeker()
+    {
+        close();
+    }
+
+    // Checks that the file was opened and mapped, an empty file is open too
+    bool isOpen() const
+    {
+        return m_open;
+    }
+
+    // Returns the size of the file
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    std::string_view to_string_view() const
+    {
+        return std::string_view(m_data ? m_data : "", m_size);
+    }
+
+    // Returns the whole file as a PatternSeeker
+    PatternSeeker seeker() const
+    {
+        return PatternSeeker(to_string_view());
+    }
+
+    // Records separated by `delimiter`, newline-delimited Json by default:
+    // `for (auto record : file.records()) record.getJsonProp("id");`
+    RecordRange records(char delimiter = '\n') const
+    {
+        return RecordRange(seeker(), delimiter);
+    }
+
+    // Records framed by balanced brackets, like extract('{', '}') but ignoring the brackets inside strings
+    RecordRange records(char start, char end) const
+    {
+        return RecordRange(seeker(), start, end);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef PATTERN_SEEKER_PARALLEL_H
+#define PATTERN_SEEKER_PARALLEL_H
+
+#include "PatternSeeker.hpp"
+#include "PatternSeekerMapped.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+
+#if defined(PATTERN_SEEKER_WITH_EXECUTION)
+#include <execution>
+#endif
+
+namespace PatterSeekerNS {
+
+// A pool of threads for splitting a job into chunks.
+// Every worker takes the chunks of its own range from the front and, when it runs out of them,
+// steals from the back of the ranges of the others, so a slow chunk doesn't hold the rest.
+// The thread that calls run() works too and is always the worker 0.
+class ThreadPool
+{
+private:
+    // The [first, last) chunks of a worker are packed into one word,
+    // so both the owner and the thieves take a chunk with a single CAS
+    struct alignas(64) Range
+    {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    std::vector<std::thread> m_threads;
+    std::unique_ptr<Range[]> m_ranges;
+
+    std::mutex m_runMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    size_t m_busy = 0;
+    bool m_stop = false;
+    std::exception_ptr m_error;
+
+    // The current job, a type-erased reference to the callable of run()
+    void (*m_invoke)(void*, size_t, size_t) = nullptr;
+    void* m_context = nullptr;
+
+    // The pool and the worker whose chunk the current thread runs, so a nested run() is detected
+    struct Current
+    {
+        const ThreadPool* pool = nullptr;
+        size_t worker = 0;
+    };
+
+    static Current& current()
+    {
+        static thread_local Current value;
+        return value;
+    }
+
+    static uint64_t pack(uint64_t first, uint64_t last)
+    {
+        return (first << 32) | last;
+    }
+
+    bool takeOwn(size_t worker, size_t& chunk)
+    {
+        auto& bounds = m_ranges[worker].bounds;
+        uint64_t current = bounds.load(std::memory_order_relaxed);
+        while (true)
+        {
+            const uint64_t first = current >> 32;
+            const uint64_t last = current & 0xFFFFFFFFu;
+            if (first >= last)
+                return false;
+            if (bounds.compare_exchange_weak(current, pack(first + 1, last), std::memory_order_acq_rel))
+            {
+                chunk = static_cast<size_t>(first);
+                return true;
+            }
+        }
+    }
+
+    bool steal(size_t worker, size_t& chunk)
+    {
+        const size_t workers = size();
+        for (size_t i = 1; i < workers; ++i)
+        {
+            auto& bounds = m_ranges[(worker + i) % workers].bounds;
+            uint64_t current = bounds.load(std::memory_order_relaxed);
+            while (true)
+            {
+                const uint64_t first = current >> 32;
+                const uint64_t last = current & 0xFFFFFFFFu;
+                if (first >= last)
+                    break;
+                if (bounds.compare_exchange_weak(current, pack(first, last - 1), std::memory_order_acq_rel))
+                {
+                    chunk = static_cast<size_t>(last - 1);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void work(size_t worker)
+    {
+        const Current outer = std::exchange(current(), Current{ this, worker });
+        size_t chunk = 0;
+        while (takeOwn(worker, chunk) || steal(worker, chunk))
+        {
+            try
+            {
+                m_invoke(m_context, chunk, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard lock(m_mutex);
+                if (!m_error)
+                    m_error = std::current_exception();
+            }
+        }
+        current() = outer;
+    }
+
+    void loop(size_t worker)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop)
+                    return;
+                seen = m_generation;
+            }
+
+            work(worker);
+
+            std::lock_guard lock(m_mutex);
+            if (--m_busy == 0)
+                m_done.notify_one();
+        }
+    }
+
+public:
+    // `threads` includes the calling thread, so 1 runs everything in place
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency())
+        : m_ranges(new Range[std::max<size_t>(threads, 1)])
+    {
+        for (size_t worker = 1; worker < threads; ++worker)
+            m_threads.emplace_back([this, worker] { loop(worker); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    // Returns the number of workers, including the calling thread
+    size_t size() const
+    {
+        return m_threads.size() + 1;
+    }
+
+    // Calls `fn(chunk, worker)` for every chunk in [0, chunks) and waits for all of them.
+    // The first exception thrown by `fn` is rethrown here after the other chunks are done.
+    // A call from inside `fn` on the same pool runs its chunks in place with the worker of the caller,
+    // and its exceptions aren't deferred.
+    template <typename Fn>
+    void run(size_t chunks, Fn&& fn)
+    {
+        if (chunks == 0)
+            return;
+
+        if (current().pool == this)
+        {
+            const size_t worker = current().worker;
+            for (size_t chunk = 0; chunk < chunks; ++chunk)
+                fn(chunk, worker);
+            return;
+        }
+
+        std::lock_guard runLock(m_runMutex);
+        const size_t workers = size();
+        for (size_t worker = 0; worker < workers; ++worker)
+            m_ranges[worker].bounds.store(pack(chunks * worker / workers, chunks * (worker + 1) / workers));
+
+        m_invoke = [](void* context, size_t chunk, size_t worker) {
+            (*static_cast<std::remove_reference_t<Fn>*>(context))(chunk, worker);
+        };
+        m_context = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+        {
+            std::lock_guard lock(m_mutex);
+            m_busy = m_threads.size();
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        work(0);
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [&] { return m_busy == 0; });
+        if (m_error)
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+};
+
+// The pool of parallel_for_each_record by default, one worker per core
+inline ThreadPool& defaultThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+// One value per worker of a pool, each in its own cache line,
+// so the workers update them without locks and false sharing and merge() combines them at the end:
+// `PerThread<size_t> counts(pool); ... counts.local(worker) += 1; ... counts.merge(0, std::plus<>{})`
+template <typename T>
+class PerThread
+{
+private:
+    struct alignas(64) Slot
+    {
+        T value;
+    };
+
+    std::vector<Slot> m_slots;
+
+public:
+    explicit PerThread(const ThreadPool& pool = defaultThreadPool(), const T& init = T{})
+        : m_slots(pool.size(), Slot{init})
+    {}
+
+    T& local(size_t worker)
+    {
+        return m_slots[worker].value;
+    }
+
+    // Folds the values of all workers into `init` with `merge(T, const T&)`
+    template <typename Merge>
+    T merge(T init, Merge merge) const
+    {
+        for (const auto& slot : m_slots)
+            init = merge(std::move(init), slot.value);
+        return init;
+    }
+};
+
+namespace detail {
+
+// Every chunk is at least this big, so small buffers aren't split at all
+inline constexpr size_t MIN_RECORD_CHUNK = 64 * 1024;
+
+// Returns [from, to) of `data` as a view with the same original pointer
+inline PatternSeeker subSeeker(PatternSeeker data, size_t from, size_t to)
+{
+    data.skip(from);
+    return data.extract(to - from);
+}
+
+inline size_t recordChunkSize(size_t size, size_t workers)
+{
+    // a few chunks per worker leave something to steal
+    return std::max(MIN_RECORD_CHUNK, size / (workers * 8) + 1);
+}
+
+// Splits `data` into chunks of whole records separated by `delimiter`.
+// A cut is found with one search from the estimated position, so the split costs nothing.
+inline std::vector<PatternSeeker> splitRecords(PatternSeeker data, char delimiter, size_t workers)
+{
+    const std::string_view str = data.to_string_view();
+    const size_t chunkSize = recordChunkSize(str.size(), workers);
+
+    std::vector<PatternSeeker> chunks;
+    size_t begin = 0;
+    while (begin < str.size())
+    {
+        size_t end = str.size();
+        if (str.size() - begin > chunkSize)
+        {
+            const size_t pos = str.find(delimiter, begin + chunkSize);
+            end = pos == std::string_view::npos ? str.size() : pos + 1;
+        }
+        chunks.push_back(subSeeker(data, begin, end));
+        begin = end;
+    }
+    return chunks;
+}
+
+// The records framed by `start` and `end` and the chunks of them: chunk `i` is
+// the records [chunks[i], chunks[i + 1])
+struct FramedRecords
+{
+    std::vector<PatternSeeker> records;
+    std::vector<size_t> chunks;
+};
+
+// Finds the records from `start` to the matching `end` and splits them into chunks.
+// Unlike delimiters, a frame can't be found from the middle of the data, where it is unknown
+// whether a bracket is inside a string, so the frames are walked from the beginning.
+// It is the only sequential part and it runs at the speed of extractQuoteAware; the records are kept,
+// so the workers don't scan them again.
+inline FramedRecords splitFramedRecords(PatternSeeker data, char start, char end, size_t workers)
+{
+    const size_t chunkSize = recordChunkSize(data.size(), workers);
+    const size_t origin = data.getOffset();
+
+    FramedRecords result;
+    result.chunks.push_back(0);
+    size_t begin = 0;
+    for (auto record : RecordRange(data, start, end))
+    {
+        result.records.push_back(record);
+        const size_t last = record.getOffset() - origin + record.size();
+        if (last - begin >= chunkSize)
+        {
+            result.chunks.push_back(result.records.size());
+            begin = last;
+        }
+    }
+    if (result.chunks.back() != result.records.size())
+        result.chunks.push_back(result.records.size());
+    return result;
+}
+
+template <typename Fn>
+void invokeRecord(Fn& fn, PatternSeeker record, size_t worker)
+{
+    if constexpr (std::is_invocable_v<Fn&, PatternSeeker, size_t>)
+        fn(record, worker);
+    else
+        fn(record);
+}
+
+}
+
+// Calls `fn(record)` or `fn(record, worker)` for every record of `data` separated by `delimiter`,
+// in parallel on `pool`. The records keep the original pointer of `data`, so getOffset() works as usual.
+// The order of the calls is unspecified, use the worker index with PerThread to collect the results.
+template <typename Fn>
+void parallel_for_each_record(PatternSeeker data, char delimiter, Fn&& fn, ThreadPool& pool = defaultThreadPool())
+{
+    const auto chunks = detail::splitRecords(data, delimiter, pool.size());
+    pool.run(chunks.size(), [&](size_t chunk, size_t worker) {
+        for (auto record : RecordRange(chunks[chunk], delimiter))
+            detail::invokeRecord(fn, record, worker);
+    });
+}
+
+// The same for the records framed by balanced top-level `start` and `end`, like `{` and `}`.
+// The brackets inside strings are ignored as in extractQuoteAware.
+template <typename Fn>
+void parallel_for_each_record(PatternSeeker data, char start, char end, Fn&& fn, ThreadPool& pool = defaultThreadPool())
+{
+    const auto framed = detail::splitFramedRecords(data, start, end, pool.size());
+    pool.run(framed.chunks.size() - 1, [&](size_t chunk, size_t worker) {
+        for (size_t i = framed.chunks[chunk]; i < framed.chunks[chunk + 1]; ++i)
+            detail::invokeRecord(fn, framed.records[i], worker);
+    });
+}
+
+#if defined(PATTERN_SEEKER_WITH_EXECUTION)
+
+// The same with a standard execution policy instead of the pool: `parallel_for_each_record(std::execution::par, ...)`.
+// Define PATTERN_SEEKER_WITH_EXECUTION to enable it, with libstdc++ the parallel policies need TBB.
+// There is no worker index here, so the results have to be collected by `fn` itself.
+template <typename Policy, typename Fn>
+    requires std::is_execution_policy_v<std::remove_cvref_t<Policy>>
+void parallel_for_each_record(Policy&& policy, PatternSeeker data, char delimiter, Fn&& fn)
+{
+    const auto chunks = detail::splitRecords(data, delimiter, std::max(1u, std::thread::hardware_concurrency()));
+    std::for_each(std::forward<Policy>(policy), chunks.begin(), chunks.end(), [&](PatternSeeker chunk) {
+        for (auto record : RecordRange(chunk, delimiter))
+            fn(record);
+    });
+}
+
+#endif
+
+}
+
+#endif
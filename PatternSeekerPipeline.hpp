@@ -0,0 +1,633 @@
+#ifndef PATTERN_SEEKER_PIPELINE_H
+#define PATTERN_SEEKER_PIPELINE_H
+
+#include "PatternSeeker.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace PatterSeekerNS {
+
+// Handing the data from the thread that reads it to the threads that parse it.
+// SharedBuffer owns the bytes and counts its references, so the views of SharedSeeker and RecordBatch
+// keep their buffer alive as long as they live, whichever thread drops the last one.
+// SpscRing and MpmcRing are bounded lock-free queues to pass them without a mutex.
+
+// A reference-counted immutable buffer. Copying it only increments the counter.
+class SharedBuffer
+{
+private:
+    struct Control
+    {
+        std::atomic<size_t> refs{1};
+        void (*destroy)(Control*) = nullptr;
+        char* data = nullptr;
+        size_t size = 0;
+    };
+
+    // the bytes are allocated right after the control block
+    struct Inline : Control
+    {
+        static void free(Control* control)
+        {
+            static_cast<Inline*>(control)->~Inline();
+            ::operator delete(control);
+        }
+    };
+
+    struct Owned : Control
+    {
+        std::string str;
+
+        static void free(Control* control)
+        {
+            delete static_cast<Owned*>(control);
+        }
+    };
+
+    Control* m_control = nullptr;
+
+    explicit SharedBuffer(Control* control)
+        : m_control(control)
+    {}
+
+    void release()
+    {
+        if (m_control && m_control->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            m_control->destroy(m_control);
+        m_control = nullptr;
+    }
+
+public:
+    SharedBuffer() = default;
+
+    // Allocates `size` bytes to be filled through writableData() before the buffer is shared
+    static SharedBuffer allocate(size_t size)
+    {
+        void* memory = ::operator new(sizeof(Inline) + size);
+        auto* control = new (memory) Inline;
+        control->destroy = &Inline::free;
+        control->data = reinterpret_cast<char*>(control + 1);
+        control->size = size;
+        return SharedBuffer(control);
+    }
+
+    static SharedBuffer copy(std::string_view data)
+    {
+        auto res = allocate(data.size());
+        if (!data.empty())
+            std::memcpy(res.writableData(), data.data(), data.size());
+        return res;
+    }
+
+    // Takes the string without copying its bytes
+    static SharedBuffer adopt(std::string&& data)
+    {
+        auto* control = new Owned;
+        control->str = std::move(data);
+        control->destroy = &Owned::free;
+        control->data = control->str.data();
+        control->size = control->str.size();
+        return SharedBuffer(control);
+    }
+
+    SharedBuffer(const SharedBuffer& other)
+        : m_control(other.m_control)
+    {
+        if (m_control)
+            m_control->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SharedBuffer(SharedBuffer&& other) noexcept
+        : m_control(std::exchange(other.m_control, nullptr))
+    {}
+
+    SharedBuffer& operator=(const SharedBuffer& other)
+    {
+        if (this != &other)
+        {
+            SharedBuffer copy(other);
+            std::swap(m_control, copy.m_control);
+        }
+        return *this;
+    }
+
+    SharedBuffer& operator=(SharedBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_control = std::exchange(other.m_control, nullptr);
+        }
+        return *this;
+    }
+
+    ~SharedBuffer()
+    {
+        release();
+    }
+
+    explicit operator bool() const
+    {
+        return m_control != nullptr;
+    }
+
+    const char* data() const
+    {
+        return m_control ? m_control->data : nullptr;
+    }
+
+    size_t size() const
+    {
+        return m_control ? m_control->size : 0;
+    }
+
+    // Only the thread that has allocated the buffer may write it, before it passes any reference on
+    char* writableData()
+    {
+        assert(m_control && useCount() == 1);
+        return m_control->data;
+    }
+
+    // Shortens the buffer to the bytes actually read into it
+    void shrink(size_t size)
+    {
+        assert(m_control && useCount() == 1 && size <= m_control->size);
+        m_control->size = size;
+    }
+
+    size_t useCount() const
+    {
+        return m_control ? m_control->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+    std::string_view view() const
+    {
+        return { data(), size() };
+    }
+
+    // A seeker of the whole buffer, its offsets are relative to the start of the buffer
+    PatternSeeker seeker() const
+    {
+        return PatternSeeker(view());
+    }
+
+    bool contains(const PatternSeeker& ps) const
+    {
+        const auto str = ps.to_string_view();
+        return m_control && str.data() >= data() && str.data() + str.size() <= data() + size();
+    }
+
+    // Returns the [from, from + size) bytes of the buffer
+    PatternSeeker seeker(size_t from, size_t size) const
+    {
+        auto res = seeker();
+        res.skip(from);
+        return res.extract(size);
+    }
+};
+
+// A PatternSeeker with a reference to its buffer, so it can be passed to another thread
+// and the views it returns stay valid while it lives
+class SharedSeeker
+{
+private:
+    SharedBuffer m_buffer;
+    PatternSeeker m_seeker{std::string_view{}};
+
+public:
+    SharedSeeker() = default;
+
+    explicit SharedSeeker(SharedBuffer buffer)
+        : m_buffer(std::move(buffer))
+        , m_seeker(m_buffer.seeker())
+    {}
+
+    // `view` must point into `buffer`
+    SharedSeeker(SharedBuffer buffer, PatternSeeker view)
+        : m_buffer(std::move(buffer))
+        , m_seeker(view)
+    {
+        assert(m_buffer.contains(view));
+    }
+
+    const SharedBuffer& buffer() const
+    {
+        return m_buffer;
+    }
+
+    PatternSeeker& operator*()
+    {
+        return m_seeker;
+    }
+
+    const PatternSeeker& operator*() const
+    {
+        return m_seeker;
+    }
+
+    PatternSeeker* operator->()
+    {
+        return &m_seeker;
+    }
+
+    const PatternSeeker* operator->() const
+    {
+        return &m_seeker;
+    }
+};
+
+// Up to CAPACITY records of one buffer under a single reference, so passing many small records
+// costs one queue operation and one counter update instead of one per record
+class RecordBatch
+{
+public:
+    static constexpr size_t CAPACITY = 64;
+
+private:
+    struct Record
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    SharedBuffer m_buffer;
+    size_t m_size = 0;
+    std::array<Record, CAPACITY> m_records{};
+
+public:
+    RecordBatch() = default;
+
+    explicit RecordBatch(SharedBuffer buffer)
+        : m_buffer(std::move(buffer))
+    {}
+
+    RecordBatch(const RecordBatch&) = default;
+    RecordBatch& operator=(const RecordBatch&) = default;
+
+    // Only the added records are copied, and the moved-from batch is empty
+    RecordBatch(RecordBatch&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    RecordBatch& operator=(RecordBatch&& other) noexcept
+    {
+        if (this != &other)
+        {
+            m_buffer = std::move(other.m_buffer);
+            m_size = std::exchange(other.m_size, 0);
+            std::copy_n(other.m_records.begin(), m_size, m_records.begin());
+        }
+        return *this;
+    }
+
+    // Adds a record of the buffer, returns false if the batch is full
+    bool add(const PatternSeeker& record)
+    {
+        assert(m_buffer.contains(record));
+        if (m_size == CAPACITY)
+            return false;
+        m_records[m_size++] = { static_cast<size_t>(record.to_string_view().data() - m_buffer.data()), record.size() };
+        return true;
+    }
+
+    const SharedBuffer& buffer() const
+    {
+        return m_buffer;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    bool full() const
+    {
+        return m_size == CAPACITY;
+    }
+
+    // The record `i`, its offsets are relative to the start of the buffer
+    PatternSeeker operator[](size_t i) const
+    {
+        assert(i < m_size);
+        return m_buffer.seeker(m_records[i].offset, m_records[i].size);
+    }
+
+    // Calls `f(PatternSeeker)` for every record
+    template <typename F>
+    void forEach(F&& f) const
+    {
+        for (size_t i = 0; i < m_size; ++i)
+            f((*this)[i]);
+    }
+
+    // Drops the records and the reference, the batch can be reused for another buffer
+    void reset(SharedBuffer buffer = {})
+    {
+        m_buffer = std::move(buffer);
+        m_size = 0;
+    }
+};
+
+namespace detail {
+
+inline constexpr size_t CACHE_LINE = 64;
+
+// Spins for a while and then gives the core away, for the blocking push() and pop() of the rings
+class Backoff
+{
+private:
+    unsigned m_spins = 0;
+
+public:
+    void wait()
+    {
+        if (m_spins < 64)
+        {
+            ++m_spins;
+#if defined(PATTERN_SEEKER_X86)
+            _mm_pause();
+#endif
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+};
+
+inline size_t ringCapacity(size_t capacity)
+{
+    return std::bit_ceil(std::max<size_t>(capacity, 2));
+}
+
+}
+
+// A bounded queue for one producer thread and one consumer thread.
+// Each side owns its index and keeps a copy of the other one, so it reads the shared index
+// only when the copy says the ring is full or empty. The capacity is rounded up to a power of two.
+// A failed tryPush doesn't move from its argument. After close(), pop() drains the ring and then returns false.
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>);
+
+private:
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    alignas(detail::CACHE_LINE) std::atomic<size_t> m_head{0};
+    // the consumer's copy of m_tail
+    size_t m_tailCache = 0;
+
+    alignas(detail::CACHE_LINE) std::atomic<size_t> m_tail{0};
+    // the producer's copy of m_head
+    size_t m_headCache = 0;
+
+    alignas(detail::CACHE_LINE) std::atomic<bool> m_closed{false};
+
+    // Returns how many slots the producer can fill
+    size_t freeSlots(size_t tail)
+    {
+        if (tail - m_headCache > m_mask)
+            m_headCache = m_head.load(std::memory_order_acquire);
+        return m_mask + 1 - (tail - m_headCache);
+    }
+
+    // Returns how many slots the consumer can take
+    size_t usedSlots(size_t head)
+    {
+        if (head == m_tailCache)
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+        return m_tailCache - head;
+    }
+
+public:
+    explicit SpscRing(size_t capacity)
+        : m_mask(detail::ringCapacity(capacity) - 1)
+        , m_slots(std::make_unique<T[]>(m_mask + 1))
+    {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    bool tryPush(T&& value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (freeSlots(tail) == 0)
+            return false;
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves as many of `values` as fit in one publication, returns their number
+    size_t tryPush(std::span<T> values)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t count = std::min(values.size(), freeSlots(tail));
+        for (size_t i = 0; i < count; ++i)
+            m_slots[(tail + i) & m_mask] = std::move(values[i]);
+        if (count)
+            m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool tryPop(T& out)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (usedSlots(head) == 0)
+            return false;
+        // moving out leaves an empty value in the slot, so it doesn't hold a buffer
+        out = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Takes up to out.size() values at once, returns their number
+    size_t tryPop(std::span<T> out)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t count = std::min(out.size(), usedSlots(head));
+        for (size_t i = 0; i < count; ++i)
+            out[i] = std::move(m_slots[(head + i) & m_mask]);
+        if (count)
+            m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Waits for a free slot
+    void push(T&& value)
+    {
+        for (detail::Backoff backoff; !tryPush(std::move(value));)
+            backoff.wait();
+    }
+
+    // Waits for a value, returns false when the ring is closed and empty
+    bool pop(T& out)
+    {
+        for (detail::Backoff backoff;; backoff.wait())
+        {
+            if (tryPop(out))
+                return true;
+            if (m_closed.load(std::memory_order_acquire))
+                return tryPop(out);
+        }
+    }
+
+    // Called by the producer after its last push
+    void close()
+    {
+        m_closed.store(true, std::memory_order_release);
+    }
+};
+
+// A bounded queue for any number of producers and consumers (Vyukov's bounded MPMC queue).
+// Every slot has a sequence number that tells whose turn it is, so a producer and a consumer
+// only contend on the index they move and never wait for each other inside a call.
+// The capacity is rounded up to a power of two. After close(), pop() drains the ring and then returns false.
+template <typename T>
+class MpmcRing
+{
+    static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>);
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(detail::CACHE_LINE) std::atomic<size_t> m_tail{0};
+    alignas(detail::CACHE_LINE) std::atomic<size_t> m_head{0};
+    alignas(detail::CACHE_LINE) std::atomic<size_t> m_producers;
+
+public:
+    // `producers` is the number of close() calls after which pop() stops waiting
+    explicit MpmcRing(size_t capacity, size_t producers = 1)
+        : m_mask(detail::ringCapacity(capacity) - 1)
+        , m_slots(std::make_unique<Slot[]>(m_mask + 1))
+        , m_producers(producers)
+    {
+        for (size_t i = 0; i <= m_mask; ++i)
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    bool tryPush(T&& value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &m_slots[tail & m_mask];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - tail);
+            if (diff == 0)
+            {
+                if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // the slot still holds the value of the previous lap
+                return false;
+            }
+            else
+            {
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &m_slots[head & m_mask];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (head + 1));
+            if (diff == 0)
+            {
+                if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // nothing is published in the slot yet
+                return false;
+            }
+            else
+            {
+                head = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(slot->value);
+        slot->sequence.store(head + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waits for a free slot
+    void push(T&& value)
+    {
+        for (detail::Backoff backoff; !tryPush(std::move(value));)
+            backoff.wait();
+    }
+
+    // Waits for a value, returns false when all the producers have closed and the ring is empty
+    bool pop(T& out)
+    {
+        for (detail::Backoff backoff;; backoff.wait())
+        {
+            if (tryPop(out))
+                return true;
+            if (m_producers.load(std::memory_order_acquire) == 0)
+                return tryPop(out);
+        }
+    }
+
+    // Called by every producer after its last push
+    void close()
+    {
+        m_producers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+};
+
+}
+
+#endif
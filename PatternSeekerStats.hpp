@@ -0,0 +1,283 @@
+#ifndef PATTERN_SEEKER_STATS_H
+#define PATTERN_SEEKER_STATS_H
+
+// Counters of the PatternSeeker operations. They are collected only when PATTERN_SEEKER_WITH_STATS
+// is defined for the whole program (the CMake option of the same name does it), otherwise
+// the hooks in PatternSeeker.hpp are empty and this header isn't included.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace PatterSeekerNS {
+
+enum class StatsOperation
+{
+    to,
+    extract,
+    to_any_of,
+    json_prop,
+    xml_tag,
+    xml_attr,
+    take_number,
+    count,
+};
+
+inline constexpr size_t STATS_OPERATION_COUNT = static_cast<size_t>(StatsOperation::count);
+
+// Reading the clock costs more than most of the operations, so only one call in this many is timed
+inline constexpr uint64_t STATS_TIMING_INTERVAL = 16;
+
+constexpr std::string_view operationName(StatsOperation operation)
+{
+    constexpr std::string_view NAMES[STATS_OPERATION_COUNT] = {
+        "to", "extract", "to_any_of", "json_prop", "xml_tag", "xml_attr", "take_number" };
+    return NAMES[static_cast<size_t>(operation)];
+}
+
+struct OperationStats
+{
+    uint64_t calls = 0;
+    // the calls that didn't find anything or failed to parse
+    uint64_t failures = 0;
+    // the bytes up to the end of the match, or all the visible bytes on failure
+    uint64_t scannedBytes = 0;
+    // the calls that were timed and their total time
+    uint64_t timedCalls = 0;
+    uint64_t timedNanoseconds = 0;
+
+    // Returns the time of all the calls estimated from the timed ones
+    double seconds() const
+    {
+        return timedCalls ? double(timedNanoseconds) * double(calls) / double(timedCalls) * 1e-9 : 0.0;
+    }
+
+    OperationStats& operator+=(const OperationStats& other)
+    {
+        calls += other.calls;
+        failures += other.failures;
+        scannedBytes += other.scannedBytes;
+        timedCalls += other.timedCalls;
+        timedNanoseconds += other.timedNanoseconds;
+        return *this;
+    }
+
+    OperationStats& operator-=(const OperationStats& other)
+    {
+        calls -= other.calls;
+        failures -= other.failures;
+        scannedBytes -= other.scannedBytes;
+        timedCalls -= other.timedCalls;
+        timedNanoseconds -= other.timedNanoseconds;
+        return *this;
+    }
+};
+
+// The sums of the counters of all the threads, also of the finished ones.
+// The counters are never reset, the difference of two snapshots gives the stats of a period.
+struct StatsSnapshot
+{
+    std::array<OperationStats, STATS_OPERATION_COUNT> operations{};
+
+    const OperationStats& operator[](StatsOperation operation) const
+    {
+        return operations[static_cast<size_t>(operation)];
+    }
+
+    StatsSnapshot operator-(const StatsSnapshot& since) const
+    {
+        StatsSnapshot res = *this;
+        for (size_t i = 0; i < STATS_OPERATION_COUNT; ++i)
+            res.operations[i] -= since.operations[i];
+        return res;
+    }
+};
+
+namespace detail
+{
+
+struct ThreadStats;
+
+struct StatsRegistry
+{
+    std::mutex mutex;
+    std::vector<const ThreadStats*> threads;
+    // the counters of the threads that have finished
+    StatsSnapshot finished;
+};
+
+inline StatsRegistry& statsRegistry()
+{
+    // never destroyed, so the threads that finish after main() can still unregister
+    static StatsRegistry* registry = new StatsRegistry;
+    return *registry;
+}
+
+// The counters of one thread. Only the owner writes them, so the updates are plain loads and stores
+// without a lock prefix, and the atomics only let the snapshots read them at any time.
+struct ThreadStats
+{
+    struct Counters
+    {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> scannedBytes{0};
+        std::atomic<uint64_t> timedCalls{0};
+        std::atomic<uint64_t> timedNanoseconds{0};
+    };
+
+    std::array<Counters, STATS_OPERATION_COUNT> counters;
+    // the operations being counted on the thread, the ones called by another operation aren't counted
+    unsigned depth = 0;
+
+    ThreadStats()
+    {
+        auto& registry = statsRegistry();
+        std::lock_guard lock(registry.mutex);
+        registry.threads.push_back(this);
+    }
+
+    ~ThreadStats()
+    {
+        auto& registry = statsRegistry();
+        std::lock_guard lock(registry.mutex);
+        addTo(registry.finished);
+        std::erase(registry.threads, this);
+    }
+
+    ThreadStats(const ThreadStats&) = delete;
+    ThreadStats& operator=(const ThreadStats&) = delete;
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void addTo(StatsSnapshot& snapshot) const
+    {
+        for (size_t i = 0; i < STATS_OPERATION_COUNT; ++i)
+        {
+            snapshot.operations[i] += { counters[i].calls.load(std::memory_order_relaxed),
+                                        counters[i].failures.load(std::memory_order_relaxed),
+                                        counters[i].scannedBytes.load(std::memory_order_relaxed),
+                                        counters[i].timedCalls.load(std::memory_order_relaxed),
+                                        counters[i].timedNanoseconds.load(std::memory_order_relaxed) };
+        }
+    }
+};
+
+inline ThreadStats& threadStats()
+{
+    thread_local ThreadStats stats;
+    return stats;
+}
+
+// Counts one call of an operation when it goes out of scope.
+// The operation reports whether it has found anything and how much it has scanned before returning.
+// The operations inside another one are part of it, so only the outermost scope of a thread counts.
+class StatsScope
+{
+private:
+    ThreadStats& m_thread;
+    ThreadStats::Counters& m_counters;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_scannedBytes = 0;
+    bool m_outermost;
+    bool m_timed;
+    bool m_failed = false;
+
+public:
+    explicit StatsScope(StatsOperation operation)
+        : m_thread(threadStats())
+        , m_counters(m_thread.counters[static_cast<size_t>(operation)])
+        , m_outermost(m_thread.depth++ == 0)
+        , m_timed(m_outermost && m_counters.calls.load(std::memory_order_relaxed) % STATS_TIMING_INTERVAL == 0)
+    {
+        if (m_timed)
+            m_start = std::chrono::steady_clock::now();
+    }
+
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+    ~StatsScope()
+    {
+        --m_thread.depth;
+        if (!m_outermost)
+            return;
+        if (m_timed)
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - m_start;
+            ThreadStats::add(m_counters.timedCalls, 1);
+            ThreadStats::add(m_counters.timedNanoseconds,
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+        ThreadStats::add(m_counters.calls, 1);
+        ThreadStats::add(m_counters.failures, m_failed);
+        ThreadStats::add(m_counters.scannedBytes, m_scannedBytes);
+    }
+
+    void result(bool found, size_t scannedBytes)
+    {
+        m_failed = !found;
+        m_scannedBytes = scannedBytes;
+    }
+};
+
+}
+
+// Returns the sums of the counters of all the threads
+inline StatsSnapshot statsSnapshot()
+{
+    StatsSnapshot snapshot;
+    auto& registry = detail::statsRegistry();
+    std::lock_guard lock(registry.mutex);
+    snapshot = registry.finished;
+    for (const auto* thread : registry.threads)
+        thread->addTo(snapshot);
+    return snapshot;
+}
+
+// Writes the snapshot in the Prometheus text format, one family per field:
+// `pattern_seeker_calls_total{operation="to"} 42`
+// The counters only grow; the time of all the calls estimated from the timed ones may go down, so it is a gauge.
+inline void writePrometheus(std::ostream& out, const StatsSnapshot& snapshot, std::string_view prefix = "pattern_seeker")
+{
+    auto family = [&](std::string_view name, std::string_view type, std::string_view help, auto value) {
+        out << "# HELP " << prefix << '_' << name << ' ' << help << '\n';
+        out << "# TYPE " << prefix << '_' << name << ' ' << type << '\n';
+        for (size_t i = 0; i < STATS_OPERATION_COUNT; ++i)
+        {
+            out << prefix << '_' << name << "{operation=\"" << operationName(static_cast<StatsOperation>(i)) << "\"} ";
+            value(snapshot.operations[i]);
+            out << '\n';
+        }
+    };
+
+    family("calls_total", "counter", "Calls of the operation.", [&](const OperationStats& s) { out << s.calls; });
+    family("failures_total", "counter", "Calls that found nothing.", [&](const OperationStats& s) { out << s.failures; });
+    family("scanned_bytes_total", "counter", "Bytes scanned by the operation.", [&](const OperationStats& s) { out << s.scannedBytes; });
+    family("timed_calls_total", "counter", "Calls whose time was measured.", [&](const OperationStats& s) { out << s.timedCalls; });
+    family("timed_seconds_total", "counter", "Time spent in the timed calls.",
+           [&](const OperationStats& s) { out << double(s.timedNanoseconds) * 1e-9; });
+    family("estimated_seconds", "gauge", "Time spent in all the calls, estimated from the timed ones.",
+           [&](const OperationStats& s) { out << s.seconds(); });
+}
+
+inline std::string prometheusText(const StatsSnapshot& snapshot = statsSnapshot())
+{
+    std::ostringstream out;
+    writePrometheus(out, snapshot);
+    return out.str();
+}
+
+}
+
+#endif
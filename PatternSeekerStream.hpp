@@ -0,0 +1,387 @@
+#ifndef PATTERN_SEEKER_STREAM_H
+#define PATTERN_SEEKER_STREAM_H
+
+#include "PatternSeeker.hpp"
+
+#include <span>
+#include <vector>
+#include <memory_resource>
+
+namespace PatterSeekerNS {
+
+enum class StreamStatus
+{
+    found,
+    // the pattern may still come with the next chunk
+    need_more_data,
+    // the stream is finished and the pattern isn't there
+    not_found,
+};
+
+struct StreamResult
+{
+    StreamStatus status = StreamStatus::not_found;
+    // A view of the buffered data, valid until the next append() or commit()
+    PatternSeeker value{std::string_view{}};
+
+    explicit operator bool() const
+    {
+        return status == StreamStatus::found;
+    }
+};
+
+// StreamSeeker parses data that comes in chunks, for example from socket reads,
+// so a record may be split between several chunks.
+// The chunks are appended to an internal buffer that keeps only the data after the last commit():
+// when the space runs out, the retained bytes are moved to the front as in a ring buffer,
+// so the whole stream is never copied into one string.
+// Searches cross the chunk boundaries. If a pattern isn't buffered yet, they return
+// StreamStatus::need_more_data and the same call after the next append() continues
+// from where the previous one stopped instead of scanning the buffered bytes again.
+// After finish() a missing pattern is StreamStatus::not_found.
+class StreamSeeker
+{
+private:
+    static constexpr uint64_t NPOS = std::numeric_limits<uint64_t>::max();
+
+    enum Operation
+    {
+        no_operation,
+        to_operation,
+        extract_operation,
+        extract_to_operation,
+        xml_tag_operation,
+    };
+
+    std::pmr::vector<char> m_buffer;
+    // the retained data is [m_begin, m_end) of the buffer
+    size_t m_begin = 0;
+    size_t m_end = 0;
+    // The stream positions of the first retained byte and of the cursor
+    uint64_t m_base = 0;
+    uint64_t m_cursor = 0;
+    bool m_finished = false;
+
+    // The search that needed more data, it is resumed by the same call at the same cursor
+    Operation m_operation = no_operation;
+    std::pmr::string m_first;
+    std::pmr::string m_second;
+    uint64_t m_resumeCursor = 0;
+    uint64_t m_firstPos = NPOS;
+    // the stream position where the data ended during the last attempt
+    uint64_t m_scanned = 0;
+    // the elements open after the tags counted by getXmlTag(), 0 before the end of its start tag
+    size_t m_depth = 0;
+
+    uint64_t dataEnd() const
+    {
+        return m_base + (m_end - m_begin);
+    }
+
+    std::string_view retained() const
+    {
+        return std::string_view(m_buffer.data() + m_begin, m_end - m_begin);
+    }
+
+    // Returns [begin, end) of the stream as a view whose original pointer is the first retained byte
+    PatternSeeker view(uint64_t begin, uint64_t end) const
+    {
+        PatternSeeker result{retained()};
+        result.skip(static_cast<size_t>(begin - m_base));
+        return result.extract(static_cast<size_t>(end - begin));
+    }
+
+    // Finds `needle` starting with the stream position `from`.
+    // The bytes before `scanned` are known not to contain it, except for a possible start of it at the very end.
+    uint64_t findFrom(std::string_view needle, uint64_t from, uint64_t scanned) const
+    {
+        const uint64_t overlap = needle.empty() ? 0 : needle.size() - 1;
+        if (scanned > from + overlap)
+            from = scanned - overlap;
+
+        const size_t pos = detail::find(retained(), needle, static_cast<size_t>(from - m_base));
+        return pos == std::string_view::npos ? NPOS : m_base + pos;
+    }
+
+    // Finds `first` after the cursor and `second` after `first`, resuming the previous attempt
+    // of the same operation. Returns the stream positions of both.
+    StreamStatus findPair(Operation operation, std::string_view first, std::string_view second,
+                          uint64_t& firstPos, uint64_t& secondPos)
+    {
+        if (m_operation != operation || m_resumeCursor != m_cursor || m_first != first || m_second != second)
+        {
+            m_operation = operation;
+            m_first.assign(first);
+            m_second.assign(second);
+            m_resumeCursor = m_cursor;
+            m_firstPos = NPOS;
+            m_scanned = m_cursor;
+        }
+
+        if (m_firstPos == NPOS)
+        {
+            m_firstPos = first.empty() ? m_cursor : findFrom(first, m_cursor, m_scanned);
+            if (m_firstPos == NPOS)
+                return missing();
+            // the second pattern is searched after the first one from scratch
+            m_scanned = m_firstPos + first.size();
+        }
+
+        secondPos = findFrom(second, m_firstPos + first.size(), m_scanned);
+        if (secondPos == NPOS)
+            return missing();
+
+        firstPos = m_firstPos;
+        m_operation = no_operation;
+        return StreamStatus::found;
+    }
+
+    StreamStatus missing()
+    {
+        return missing(dataEnd());
+    }
+
+    // The bytes before `scanned` won't be scanned again
+    StreamStatus missing(uint64_t scanned)
+    {
+        m_scanned = scanned;
+        if (!m_finished)
+            return StreamStatus::need_more_data;
+        m_operation = no_operation;
+        return StreamStatus::not_found;
+    }
+
+    // Makes room for `size` bytes after the retained data
+    void reserve(size_t size)
+    {
+        if (m_buffer.size() - m_end >= size)
+            return;
+
+        // the retained bytes are moved only if that frees at least as much as they take
+        const size_t retainedSize = m_end - m_begin;
+        if (m_begin >= retainedSize)
+        {
+            // the buffer is still unallocated when nothing is retained at its start
+            if (retainedSize != 0 && m_begin != 0)
+                std::memmove(m_buffer.data(), m_buffer.data() + m_begin, retainedSize);
+            m_begin = 0;
+            m_end = retainedSize;
+        }
+
+        if (m_buffer.size() - m_end < size)
+            m_buffer.resize(std::max(m_buffer.size() * 2, m_end + size));
+    }
+
+public:
+    // The buffer is allocated from `resource`, for example an Arena of the connection
+    explicit StreamSeeker(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_buffer(resource)
+        , m_first(resource)
+        , m_second(resource)
+    {}
+
+    explicit StreamSeeker(size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : StreamSeeker(resource)
+    {
+        m_buffer.resize(capacity);
+    }
+
+    // Copies the next chunk of the stream to the buffer.
+    // Views returned before are invalidated.
+    void append(std::string_view chunk)
+    {
+        if (chunk.empty())
+            return;
+        auto space = prepare(chunk.size());
+        std::memcpy(space.data(), chunk.data(), chunk.size());
+        written(chunk.size());
+    }
+
+    // Returns the space for at least `size` bytes to read to directly, for example with recv().
+    // Then written() tells how many of them were filled. Views returned before are invalidated.
+    std::span<char> prepare(size_t size)
+    {
+        reserve(size);
+        return std::span<char>(m_buffer.data() + m_end, m_buffer.size() - m_end);
+    }
+
+    void written(size_t size)
+    {
+        m_end += size;
+    }
+
+    // There will be no more data, so the searches stop waiting for it
+    void finish()
+    {
+        m_finished = true;
+    }
+
+    bool isFinished() const
+    {
+        return m_finished;
+    }
+
+    // Returns the size of the buffered data after the cursor
+    size_t size() const
+    {
+        return static_cast<size_t>(dataEnd() - m_cursor);
+    }
+
+    // Returns the buffered data after the cursor.
+    // Its original pointer is the first retained byte, so its getOffset() is the one of the stream.
+    PatternSeeker seeker() const
+    {
+        return view(m_cursor, dataEnd());
+    }
+
+    // Returns the position of the cursor in the retained data, for commit(offset)
+    size_t getOffset() const
+    {
+        return static_cast<size_t>(m_cursor - m_base);
+    }
+
+    // Returns the position of the cursor from the beginning of the stream
+    uint64_t getStreamPosition() const
+    {
+        return m_cursor;
+    }
+
+    // Forgets the first `offset` retained bytes. The cursor is never passed,
+    // so `offset` is at most getOffset(). Views returned before are invalidated.
+    void commit(size_t offset)
+    {
+        offset = std::min(offset, getOffset());
+        m_begin += offset;
+        m_base += offset;
+        if (m_begin == m_end)
+            m_begin = m_end = 0;
+    }
+
+    // Forgets all the data before the cursor
+    void commit()
+    {
+        commit(getOffset());
+    }
+
+    // Move the pointer and skip `n` buffered elements
+    void skip(size_t n)
+    {
+        m_cursor += std::min<uint64_t>(n, size());
+    }
+
+    // Find the `expected` string and move the pointer
+    StreamStatus to(std::string_view expected, MoveMode mode=none)
+    {
+        uint64_t start, pos;
+        const StreamStatus status = findPair(to_operation, {}, expected, start, pos);
+        if (status != StreamStatus::found)
+            return status;
+
+        if (mode == move_before)
+            m_cursor = pos;
+        else if (mode == move_after)
+            m_cursor = pos + expected.size();
+        return status;
+    }
+
+    // Extract data `from` and `to` the desired strings.
+    StreamResult extract(std::string_view from, std::string_view to, MoveMode mode=none)
+    {
+        uint64_t fromPos, toPos;
+        const StreamStatus status = findPair(extract_operation, from, to, fromPos, toPos);
+        if (status != StreamStatus::found)
+            return { status };
+
+        StreamResult result{ status, view(fromPos + from.size(), toPos) };
+        if (mode == move_before)
+            m_cursor = fromPos;
+        else if (mode == move_after)
+            m_cursor = toPos + to.size();
+        return result;
+    }
+
+    // Extract data from current position and `to` the desired strings.
+    StreamResult extract(std::string_view to, MoveMode mode=none)
+    {
+        uint64_t start, toPos;
+        const StreamStatus status = findPair(extract_to_operation, {}, to, start, toPos);
+        if (status != StreamStatus::found)
+            return { status };
+
+        StreamResult result{ status, view(m_cursor, toPos) };
+        if (mode == move_before)
+            m_cursor = toPos;
+        else if (mode == move_after)
+            m_cursor = toPos + to.size();
+        return result;
+    }
+
+    // Returns the entire tag like PatternSeeker::getXmlTag: only the whole name matches
+    // and the nested tags of the same name are counted
+    StreamResult getXmlTag(std::string_view prop, MoveMode mode=none)
+    {
+        if (m_operation != xml_tag_operation || m_resumeCursor != m_cursor || m_first != prop)
+        {
+            m_operation = xml_tag_operation;
+            m_first.assign(prop);
+            m_second.clear();
+            m_resumeCursor = m_cursor;
+            m_firstPos = NPOS;
+            m_scanned = m_cursor;
+            m_depth = 0;
+        }
+
+        const std::string_view data = retained();
+        if (m_firstPos == NPOS)
+        {
+            // the start tag is searched after the data scanned before, except for a tag cut at its end
+            const uint64_t overlap = prop.size() + 2;
+            const uint64_t from = m_scanned > m_cursor + overlap ? m_scanned - overlap : m_cursor;
+            bool closing = false;
+            size_t start = detail::findXmlTag(data, prop, static_cast<size_t>(from - m_base), closing);
+            while (start != std::string_view::npos && closing)
+                start = detail::findXmlTag(data, prop, start + 1, closing);
+            if (start == std::string_view::npos)
+                return { missing() };
+            m_firstPos = m_base + start;
+        }
+
+        size_t end = std::string_view::npos;
+        if (m_depth == 0)
+        {
+            // the start tag may be cut at the end of the data
+            end = detail::xmlTagEnd(data, static_cast<size_t>(m_firstPos - m_base));
+            if (end == std::string_view::npos)
+                return { missing(m_firstPos) };
+            if (!detail::xmlSelfClosing(data, end))
+            {
+                m_depth = 1;
+                m_scanned = m_base + end;
+                end = std::string_view::npos;
+            }
+        }
+
+        // the nesting is counted on from the tags counted during the previous attempts
+        if (end == std::string_view::npos)
+        {
+            size_t pos = static_cast<size_t>(m_scanned - m_base);
+            end = detail::xmlElementEndFrom(data, pos, m_depth, prop);
+            if (end == std::string_view::npos)
+                return { missing(m_base + pos) };
+        }
+
+        const uint64_t startPos = m_firstPos;
+        const uint64_t endPos = m_base + end;
+        m_operation = no_operation;
+        StreamResult result{ StreamStatus::found, view(startPos, endPos) };
+        if (mode == move_before)
+            m_cursor = startPos;
+        else if (mode == move_after)
+            m_cursor = endPos;
+        return result;
+    }
+};
+
+}
+
+#endif
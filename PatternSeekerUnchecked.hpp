@@ -0,0 +1,299 @@
+#ifndef PATTERN_SEEKER_UNCHECKED_H
+#define PATTERN_SEEKER_UNCHECKED_H
+
+#include "PatternSeeker.hpp"
+
+#include <cassert>
+
+namespace PatterSeekerNS {
+
+// UncheckedSeeker is a PatternSeeker for the input that is known to be valid, for long extraction chains:
+// `UncheckedSeeker ps(line); ps.to<move_after>("id="); auto id = ps.take<uint64_t>(); ... if (ps.failed()) ...`
+// The move mode is a template argument, so there is no switch per call, and the view is a pair of pointers
+// that is never clamped: skip(n) and extract(n) only assert that `n` fits.
+// A failure doesn't return an empty seeker to continue with. It sets a sticky flag instead: the pointer stays
+// where the failed call was made, every later call returns at once without scanning, and their results
+// are empty and failed too. So a chain is checked once at its end, and getOffset() tells where it stopped.
+class UncheckedSeeker
+{
+private:
+    const char* m_begin;
+    const char* m_end;
+    const char* m_originalPointer;
+    bool m_failed = false;
+
+    UncheckedSeeker(const char* begin, const char* end, const char* originalPointer, bool failed = false)
+        : m_begin(begin)
+        , m_end(end)
+        , m_originalPointer(originalPointer)
+        , m_failed(failed)
+    {}
+
+    std::string_view view() const
+    {
+        return { m_begin, static_cast<size_t>(m_end - m_begin) };
+    }
+
+    // Marks the seeker as failed and returns the empty failed result
+    UncheckedSeeker fail()
+    {
+        m_failed = true;
+        return { m_begin, m_begin, m_originalPointer, true };
+    }
+
+    // The views of the results aren't checked again, they are inside the view by construction
+    UncheckedSeeker sub(size_t from, size_t to) const
+    {
+        return { m_begin + from, m_begin + to, m_originalPointer };
+    }
+
+    template <MoveMode Mode>
+    void move(size_t before, size_t after)
+    {
+        if constexpr (Mode == move_before)
+            m_begin += before;
+        else if constexpr (Mode == move_after)
+            m_begin += after;
+    }
+
+    template <MoveMode Mode, typename Pattern>
+    bool toImpl(const Pattern& expected)
+    {
+        if (m_failed)
+            return false;
+        PATTERN_SEEKER_STATS(to);
+        const size_t pos = expected.find(view());
+        PATTERN_SEEKER_STATS_RESULT(pos != std::string_view::npos, pos != std::string_view::npos ? pos + expected.size() : size());
+        if (pos == std::string_view::npos)
+        {
+            m_failed = true;
+            return false;
+        }
+        move<Mode>(pos, pos + expected.size());
+        return true;
+    }
+
+    template <MoveMode Mode, typename From, typename To>
+    UncheckedSeeker extractImpl(const From& from, const To& to)
+    {
+        if (m_failed)
+            return fail();
+        PATTERN_SEEKER_STATS(extract);
+        const auto str = view();
+        const size_t fromPos = from.find(str);
+        const size_t start = fromPos + from.size();
+        const size_t end = fromPos == std::string_view::npos ? fromPos : to.find(str, start);
+        PATTERN_SEEKER_STATS_RESULT(end != std::string_view::npos, end != std::string_view::npos ? end + to.size() : size());
+        if (end == std::string_view::npos)
+            return fail();
+
+        const auto res = sub(start, end);
+        move<Mode>(fromPos, end + to.size());
+        return res;
+    }
+
+    template <MoveMode Mode, typename To>
+    UncheckedSeeker extractImpl(const To& to)
+    {
+        if (m_failed)
+            return fail();
+        PATTERN_SEEKER_STATS(extract);
+        const size_t end = to.find(view());
+        PATTERN_SEEKER_STATS_RESULT(end != std::string_view::npos, end != std::string_view::npos ? end + to.size() : size());
+        if (end == std::string_view::npos)
+            return fail();
+
+        const auto res = sub(0, end);
+        move<Mode>(end, end + to.size());
+        return res;
+    }
+
+public:
+    explicit UncheckedSeeker(std::string_view str)
+        : UncheckedSeeker(str.data(), str.data() + str.size(), str.data())
+    {}
+
+    // Keeps the offsets of `ps`; an empty failed result of PatternSeeker is just empty here
+    explicit UncheckedSeeker(const PatternSeeker& ps)
+        : UncheckedSeeker(ps.m_str.data(), ps.m_str.data() + ps.m_str.size(), ps.m_originalPointer)
+    {}
+
+    // Whether any call has failed since the construction or the last clearError()
+    bool failed() const
+    {
+        return m_failed;
+    }
+
+    bool ok() const
+    {
+        return !m_failed;
+    }
+
+    void clearError()
+    {
+        m_failed = false;
+    }
+
+    // Returns a checked seeker of the same view, an empty one if the seeker has failed
+    PatternSeeker seeker() const
+    {
+        if (m_failed)
+            return {};
+        return PatternSeeker(view(), m_originalPointer);
+    }
+
+    size_t size() const
+    {
+        return m_end - m_begin;
+    }
+
+    bool isEmpty() const
+    {
+        return m_begin == m_end;
+    }
+
+    bool isNotEmpty() const
+    {
+        return m_begin != m_end;
+    }
+
+    std::string_view to_string_view() const
+    {
+        return view();
+    }
+
+    std::string to_string() const
+    {
+        return std::string(view());
+    }
+
+    // After a failure, the offset of the call that has failed
+    size_t getOffset() const
+    {
+        return m_begin - m_originalPointer;
+    }
+
+    bool startsWith(std::string_view expected) const
+    {
+        return !m_failed && view().starts_with(expected);
+    }
+
+    // Moves after `expected` if the view starts with it, fails otherwise
+    bool expect(std::string_view expected)
+    {
+        if (!startsWith(expected))
+        {
+            m_failed = true;
+            return false;
+        }
+        m_begin += expected.size();
+        return true;
+    }
+
+    // to avoid implicit convertion
+    void skip(char n) = delete;
+
+    // `n` must not be greater than size()
+    void skip(size_t n)
+    {
+        if (m_failed)
+            return;
+        assert(n <= size());
+        m_begin += n;
+    }
+
+    void skipWhiteSpaces()
+    {
+        static constexpr CharClass SPACES = CharClass::spaces();
+        while (!m_failed && m_begin != m_end && SPACES.contains(*m_begin))
+            ++m_begin;
+    }
+
+    template <MoveMode Mode = none>
+    bool to(std::string_view expected)
+    {
+        return toImpl<Mode>(detail::RuntimePattern{expected});
+    }
+
+    template <MoveMode Mode = none, FixedString Str>
+    bool to(pattern<Str> expected)
+    {
+        return toImpl<Mode>(expected);
+    }
+
+    // Extracts data between `from` and `to`. move_before moves the pointer before `from`, move_after after `to`.
+    template <MoveMode Mode = none>
+    UncheckedSeeker extract(std::string_view from, std::string_view to)
+    {
+        return extractImpl<Mode>(detail::RuntimePattern{from}, detail::RuntimePattern{to});
+    }
+
+    template <MoveMode Mode = none, FixedString From, FixedString To>
+    UncheckedSeeker extract(pattern<From> from, pattern<To> to)
+    {
+        return extractImpl<Mode>(from, to);
+    }
+
+    // Extracts data up to `to`. move_before moves the pointer before `to`, move_after after it.
+    template <MoveMode Mode = none>
+    UncheckedSeeker extract(std::string_view to)
+    {
+        return extractImpl<Mode>(detail::RuntimePattern{to});
+    }
+
+    template <MoveMode Mode = none, FixedString To>
+    UncheckedSeeker extract(pattern<To> to)
+    {
+        return extractImpl<Mode>(to);
+    }
+
+    // Extracts `n` elements, `n` must not be greater than size(). move_after moves the pointer after them.
+    template <MoveMode Mode = none>
+    UncheckedSeeker extract(size_t n)
+    {
+        if (m_failed)
+            return fail();
+        assert(n <= size());
+        const auto res = sub(0, n);
+        move<Mode>(0, n);
+        return res;
+    }
+
+    // Parses a number and moves the pointer after it. Returns 0 and fails if there is no number
+    // or it is out of range.
+    template <typename T>
+    T take()
+    {
+        static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "take() parses numbers only");
+
+        if (m_failed)
+            return T{};
+        PATTERN_SEEKER_STATS(take_number);
+        T value{};
+        bool valid = false;
+        const char* end = detail::parseNumber(m_begin, m_end, value, valid);
+        PATTERN_SEEKER_STATS_RESULT(end != m_begin && valid, end - m_begin);
+        if (end == m_begin || !valid)
+        {
+            m_failed = true;
+            return T{};
+        }
+        m_begin = end;
+        return value;
+    }
+
+    // Returns the Json value of the property like PatternSeeker::getJsonProp, fails if there is none
+    UncheckedSeeker getJsonProp(std::string_view prop)
+    {
+        if (m_failed)
+            return fail();
+        const auto res = seeker().getJsonProp(prop);
+        if (res.m_str.data() == PatternSeeker::EMPTY_STR)
+            return fail();
+        return UncheckedSeeker(res);
+    }
+};
+
+}
+
+#endif
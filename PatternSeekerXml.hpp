@@ -0,0 +1,307 @@
+#ifndef PATTERN_SEEKER_XML_H
+#define PATTERN_SEEKER_XML_H
+
+#include "PatternSeeker.hpp"
+
+namespace PatterSeekerNS {
+
+enum class XmlEventType
+{
+    start_tag,
+    // an attribute of the last start tag, the attributes come right after it
+    attribute,
+    text,
+    cdata,
+    end_tag,
+    // the data is over
+    end,
+    // a tag isn't closed or its name is empty
+    error,
+};
+
+// An event of XmlTokenizer. The views point into the data, their offsets are relative to its original pointer.
+struct XmlEvent
+{
+    XmlEventType type = XmlEventType::end;
+    // the name of a tag or an attribute
+    PatternSeeker name{std::string_view{}};
+    // the value of an attribute without quotes, a text, the contents of CDATA
+    // or the raw attributes of a start tag
+    PatternSeeker value{std::string_view{}};
+    // the value has `&` entities, they aren't decoded
+    bool hasEntities = false;
+
+    explicit operator bool() const
+    {
+        return type != XmlEventType::end && type != XmlEventType::error;
+    }
+};
+
+// XmlTokenizer reads XML in one forward pass and returns its events one by one, like a pull SAX parser:
+// `for (XmlTokenizer xml(ps); auto event = xml.next();) if (event.type == XmlEventType::start_tag) ...`
+// Nothing is copied or allocated, the events are views of the data.
+// A self-closing tag gives a start tag and an end tag. Comments, processing instructions
+// and declarations are skipped. Whitespace between tags isn't reported as text.
+// `<`, `>`, `&` and the quotes of each 64-byte block are classified once and the events are cut
+// from the masks, so extracting many tags from a large document is one pass over it instead of one per tag.
+// The tokenizer doesn't check that the tags are balanced, depth() just counts them.
+class XmlTokenizer
+{
+private:
+    // the indices of the structural chars in the masks
+    enum Structural { lt, gt, amp, dquote, squote, structural_count };
+    static constexpr char STRUCTURAL[structural_count] = { '<', '>', '&', '"', '\'' };
+    static constexpr CharClass NAME_END = CharClass::spaces() | CharClass("=/>");
+
+    PatternSeeker m_source;
+    std::string_view m_str;
+    size_t m_pos = 0;
+    // the masks of the block at m_block
+    size_t m_block = std::string_view::npos;
+    uint64_t m_masks[structural_count] = {};
+    // the attributes of the last start tag that aren't returned yet
+    size_t m_attributes = 0;
+    size_t m_attributesEnd = 0;
+    // the name of the self-closing tag whose end tag comes next
+    PatternSeeker m_selfClosing{std::string_view{}};
+    size_t m_depth = 0;
+    bool m_failed = false;
+
+    static constexpr unsigned bit(Structural c)
+    {
+        return 1u << c;
+    }
+
+    PatternSeeker view(size_t from, size_t to) const
+    {
+        auto res = m_source;
+        res.skip(from);
+        return res.extract(to - from);
+    }
+
+    // Returns the position of the first of the structural chars `which` at or after `pos`, or npos
+    size_t findNext(size_t pos, unsigned which)
+    {
+        while (pos < m_str.size())
+        {
+            const size_t block = pos & ~size_t(63);
+            if (block != m_block)
+            {
+                m_block = block;
+                const size_t size = std::min<size_t>(64, m_str.size() - block);
+                if (size == 64)
+                {
+                    detail::kernels().classify(m_str.data() + block, 1, STRUCTURAL, structural_count, m_masks);
+                }
+                else
+                {
+                    alignas(64) char tail[64] = {};
+                    std::memcpy(tail, m_str.data() + block, size);
+                    detail::kernels().classify(tail, 1, STRUCTURAL, structural_count, m_masks);
+                    for (auto& mask : m_masks)
+                        mask &= (1ull << size) - 1;
+                }
+            }
+
+            uint64_t mask = 0;
+            for (size_t c = 0; c < structural_count; ++c)
+                mask |= which & (1u << c) ? m_masks[c] : 0;
+            mask &= ~0ull << (pos - block);
+            if (mask)
+                return block + std::countr_zero(mask);
+            pos = block + 64;
+        }
+        return std::string_view::npos;
+    }
+
+    // Returns the position after the `>` of the tag at `pos` ignoring the ones inside quotes, or npos
+    size_t tagEnd(size_t pos)
+    {
+        while ((pos = findNext(pos, bit(gt) | bit(dquote) | bit(squote))) != std::string_view::npos)
+        {
+            if (m_str[pos] == '>')
+                return pos + 1;
+            pos = findNext(pos + 1, bit(m_str[pos] == '"' ? dquote : squote));
+            if (pos == std::string_view::npos)
+                break;
+            ++pos;
+        }
+        return std::string_view::npos;
+    }
+
+    size_t nameEnd(size_t pos) const
+    {
+        while (pos < m_str.size() && !NAME_END.contains(m_str[pos]))
+            ++pos;
+        return pos;
+    }
+
+    size_t skipSpaces(size_t pos, size_t end) const
+    {
+        while (pos < end && CharClass::spaces().contains(m_str[pos]))
+            ++pos;
+        return pos;
+    }
+
+    XmlEvent fail()
+    {
+        m_failed = true;
+        m_attributes = m_attributesEnd;
+        return { XmlEventType::error };
+    }
+
+    // Returns the next attribute of the last start tag
+    XmlEvent nextAttribute()
+    {
+        XmlEvent event{ XmlEventType::attribute };
+        size_t pos = m_attributes;
+        const size_t nameEndPos = std::min(nameEnd(pos), m_attributesEnd);
+        event.name = view(pos, nameEndPos);
+        pos = skipSpaces(nameEndPos, m_attributesEnd);
+        if (event.name.isEmpty() || pos == m_attributesEnd || m_str[pos] != '=')
+            return fail();
+
+        pos = skipSpaces(pos + 1, m_attributesEnd);
+        if (pos == m_attributesEnd || (m_str[pos] != '"' && m_str[pos] != '\''))
+            return fail();
+
+        const Structural quote = m_str[pos] == '"' ? dquote : squote;
+        size_t end = findNext(pos + 1, bit(quote) | bit(amp));
+        event.hasEntities = end < m_attributesEnd && m_str[end] == '&';
+        if (event.hasEntities)
+            end = findNext(end, bit(quote));
+        // a quote in a name pairs with another one, so the value may not be closed inside the tag
+        if (end >= m_attributesEnd)
+            return fail();
+        event.value = view(pos + 1, end);
+        m_attributes = skipSpaces(end + 1, m_attributesEnd);
+        return event;
+    }
+
+    // Returns the text before the next `<` and whether it has `&`
+    XmlEvent text()
+    {
+        XmlEvent event{ XmlEventType::text };
+        size_t end = findNext(m_pos, bit(lt) | bit(amp));
+        if (end != std::string_view::npos && m_str[end] == '&')
+        {
+            event.hasEntities = true;
+            end = findNext(end, bit(lt));
+        }
+        end = std::min(end, m_str.size());
+        event.value = view(m_pos, end);
+        m_pos = end;
+        return event;
+    }
+
+    // Returns the contents of the CDATA section that ends before `end`
+    XmlEvent cdata(size_t end)
+    {
+        constexpr std::string_view OPEN = "<![CDATA[";
+        constexpr std::string_view CLOSE = "]]>";
+        XmlEvent event{ XmlEventType::cdata };
+        event.value = view(m_pos + OPEN.size(), end - CLOSE.size());
+        m_pos = end;
+        return event;
+    }
+
+    // Reads the start or end tag at the current `<`
+    XmlEvent tag()
+    {
+        const size_t end = tagEnd(m_pos);
+        if (end == std::string_view::npos)
+            return fail();
+
+        const bool closing = m_str[m_pos + 1] == '/';
+        const size_t nameStart = m_pos + (closing ? 2 : 1);
+        const size_t nameEndPos = nameEnd(nameStart);
+        XmlEvent event{ closing ? XmlEventType::end_tag : XmlEventType::start_tag };
+        event.name = view(nameStart, nameEndPos);
+        if (event.name.isEmpty())
+            return fail();
+
+        if (!closing)
+        {
+            const bool selfClosing = detail::xmlSelfClosing(m_str, end);
+            // the attributes are between the name and `>` or `/>`
+            m_attributesEnd = end - (selfClosing ? 2 : 1);
+            m_attributes = skipSpaces(nameEndPos, m_attributesEnd);
+            event.value = view(m_attributes, m_attributesEnd);
+            if (selfClosing)
+                m_selfClosing = event.name;
+            else
+                ++m_depth;
+        }
+        else
+        {
+            m_depth -= m_depth > 0;
+        }
+
+        m_pos = end;
+        return event;
+    }
+
+public:
+    explicit XmlTokenizer(PatternSeeker data)
+        : m_source(data)
+        , m_str(data.to_string_view())
+    {}
+
+    // Returns the next event, XmlEventType::end after the last one
+    XmlEvent next()
+    {
+        if (m_failed)
+            return { XmlEventType::error };
+
+        if (m_attributes < m_attributesEnd)
+            return nextAttribute();
+
+        if (m_selfClosing.isNotEmpty())
+        {
+            XmlEvent event{ XmlEventType::end_tag, m_selfClosing };
+            m_selfClosing = PatternSeeker{std::string_view{}};
+            return event;
+        }
+
+        while (m_pos < m_str.size())
+        {
+            if (m_str[m_pos] != '<')
+            {
+                XmlEvent event = text();
+                // whitespace between the tags isn't text
+                auto rest = event.value;
+                rest.skipWhiteSpaces();
+                if (rest.isNotEmpty())
+                    return event;
+                continue;
+            }
+
+            const size_t markup = detail::xmlMarkupEnd(m_str, m_pos);
+            if (markup == std::string_view::npos)
+                return fail();
+            if (markup == m_pos)
+                return tag();
+            if (m_str.substr(m_pos).starts_with("<![CDATA["))
+                return cdata(markup);
+            // a comment, a processing instruction or a declaration
+            m_pos = markup;
+        }
+        return { XmlEventType::end };
+    }
+
+    // Returns the number of the start tags that aren't closed yet
+    size_t depth() const
+    {
+        return m_depth;
+    }
+
+    // Returns the data after the last event
+    PatternSeeker rest() const
+    {
+        return view(m_pos, m_str.size());
+    }
+};
+
+}
+
+#endif
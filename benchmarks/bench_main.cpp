@@ -0,0 +1,1258 @@
+#include "../PatternSeeker.hpp"
+#include "../PatternSeekerBatch.hpp"
+#include "../PatternSeekerXml.hpp"
+#include "../PatternSeekerCache.hpp"
+#include "../PatternSeekerPipeline.hpp"
+#include "../PatternSeekerUnchecked.hpp"
+#include "../PatternSeekerChain.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PatterSeekerNS;
+
+// ============================================================================
+// Allocation counter
+// ============================================================================
+
+static std::atomic<size_t> g_allocations{0};
+
+// GCC can't see that the replaced operator new below is malloc-based
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+// std::pmr::new_delete_resource() allocates with the aligned forms
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* ptr = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align))
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+// Reports the number of heap allocations made per iteration
+class AllocationScope
+{
+public:
+    explicit AllocationScope(benchmark::State& state)
+        : m_state(state)
+        , m_start(g_allocations.load(std::memory_order_relaxed))
+    {}
+
+    ~AllocationScope()
+    {
+        const auto total = g_allocations.load(std::memory_order_relaxed) - m_start;
+        m_state.counters["allocs/iter"] = benchmark::Counter(
+            static_cast<double>(total), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& m_state;
+    size_t m_start;
+};
+
+// ============================================================================
+// Inputs
+// ============================================================================
+
+static const std::string JSON = R"({"id": 1, "level": "info", "service": "ingest",)"
+                                R"( "message": "request accepted", "request_correlation_id": 918273645})";
+
+static const std::string XML = R"(<event><service>ingest</service><message>request accepted</message>)"
+                               R"(<request_correlation_id value="918273645">918273645</request_correlation_id></event>)";
+
+static const std::string SHORT_KEY = "id";
+static const std::string LONG_KEY = "request_correlation_id";
+
+// The way the lookups worked before: the quoted key and the tags are built on every call.
+static bool concatJsonLookup(PatternSeeker ps, const std::string& prop)
+{
+    return ps.to("\"" + prop + "\"", move_after);
+}
+
+static bool concatXmlLookup(PatternSeeker ps, const std::string& prop)
+{
+    const auto startTag = "<" + prop;
+    const auto endTag = "</" + prop + ">";
+    return ps.to(startTag, move_after) && ps.to(endTag);
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+static void BM_GetJsonProp(benchmark::State& state, const std::string& key)
+{
+    const PatternSeeker ps(JSON);
+    AllocationScope allocs(state);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getJsonProp(key));
+    }
+    state.SetBytesProcessed(state.iterations() * JSON.size());
+}
+
+static void BM_ConcatJsonLookup(benchmark::State& state, const std::string& key)
+{
+    const PatternSeeker ps(JSON);
+    AllocationScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(concatJsonLookup(ps, key));
+    }
+    state.SetBytesProcessed(state.iterations() * JSON.size());
+}
+
+static void BM_GetXmlTag(benchmark::State& state, const std::string& key)
+{
+    const PatternSeeker ps(XML);
+    AllocationScope allocs(state);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getXmlTag(key));
+    }
+    state.SetBytesProcessed(state.iterations() * XML.size());
+}
+
+static void BM_GetXmlTagBody(benchmark::State& state, const std::string& key)
+{
+    const PatternSeeker ps(XML);
+    AllocationScope allocs(state);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getXmlTagBody(key));
+    }
+    state.SetBytesProcessed(state.iterations() * XML.size());
+}
+
+static void BM_ConcatXmlLookup(benchmark::State& state, const std::string& key)
+{
+    const PatternSeeker ps(XML);
+    AllocationScope allocs(state);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(concatXmlLookup(ps, key));
+    }
+    state.SetBytesProcessed(state.iterations() * XML.size());
+}
+
+static void BM_GetXmlAttr(benchmark::State& state)
+{
+    const PatternSeeker ps(XML);
+    AllocationScope allocs(state);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getXmlAttr("value"));
+    }
+    state.SetBytesProcessed(state.iterations() * XML.size());
+}
+
+static void BM_ToRuntime(benchmark::State& state)
+{
+    const PatternSeeker ps(JSON);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.to("\"request_correlation_id\":", move_after));
+    }
+    state.SetBytesProcessed(state.iterations() * JSON.size());
+}
+
+static void BM_ToPattern(benchmark::State& state)
+{
+    const PatternSeeker ps(JSON);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.to(pattern<"\"request_correlation_id\":">{}, move_after));
+    }
+    state.SetBytesProcessed(state.iterations() * JSON.size());
+}
+
+static void BM_ToShortPattern(benchmark::State& state)
+{
+    const PatternSeeker ps(JSON);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.to(pattern<"\"message\"">{}, move_after));
+    }
+    state.SetBytesProcessed(state.iterations() * JSON.size());
+}
+
+static void BM_ToShortRuntime(benchmark::State& state)
+{
+    const PatternSeeker ps(JSON);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.to("\"message\"", move_after));
+    }
+    state.SetBytesProcessed(state.iterations() * JSON.size());
+}
+
+// Searches for a key of state.range(1) bytes at the end of a state.range(0) bytes payload
+static void BM_SearchBackend(benchmark::State& state, SearchBackend backend)
+{
+    if (!setSearchBackend(backend))
+    {
+        state.SkipWithError("backend is not supported");
+        return;
+    }
+
+    std::string payload;
+    while (payload.size() < static_cast<size_t>(state.range(0)))
+        payload += R"({"level": "info", "service": "ingest", "message": "request accepted"}, )";
+    // JSON keys start with a quote, which is the most frequent byte of the payload
+    const auto keySize = static_cast<size_t>(state.range(1));
+    std::string key(keySize, 'k');
+    key.front() = '"';
+    key[keySize - 2] = '"';
+    key.back() = ':';
+    payload += key;
+
+    const PatternSeeker ps(payload);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.to(key, move_after));
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+    setSearchBackend(SearchBackend::scalar);
+}
+
+static void searchBackendArgs(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t size : { 4 << 10, 64 << 10 })
+    {
+        for (int64_t key : { 6, 12, 20 })
+            bench->Args({ size, key });
+    }
+}
+
+// A log of about `size` bytes that ends with its checksum
+static std::string makeTrailedLog(size_t size)
+{
+    std::string log;
+    while (log.size() < size)
+        log += "2024-05-01T10:00:00Z level=info service=api path=/api/v1/items status=200 bytes=512\n";
+    return log + "crc=9f3a11c0\n";
+}
+
+// A `k=v;k=v` line with `count` pairs
+static std::string makePairs(size_t count)
+{
+    std::string line;
+    for (size_t i = 0; i < count; ++i)
+        line += "key" + std::to_string(i) + "=value" + std::to_string(i * 31) + ";";
+    return line;
+}
+
+static void BM_FieldsExtractUntilOneOf(benchmark::State& state)
+{
+    const std::string line = makePairs(state.range(0));
+    for (auto _ : state)
+    {
+        PatternSeeker ps(line);
+        while (ps.isNotEmpty())
+            benchmark::DoNotOptimize(ps.extractUntilOneOf(";,", move_after));
+    }
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+static void BM_FieldsRange(benchmark::State& state)
+{
+    const std::string line = makePairs(state.range(0));
+    const PatternSeeker ps(line);
+    for (auto _ : state)
+    {
+        for (auto field : ps.fields(";,"))
+            benchmark::DoNotOptimize(field);
+    }
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+static void BM_FieldsSplitInto(benchmark::State& state)
+{
+    const std::string line = makePairs(state.range(0));
+    const PatternSeeker ps(line);
+    std::vector<std::string_view> out(state.range(0) + 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ps.splitInto(out, ";,"));
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+// The last column, found by chaining extracts and by column()
+static void BM_LastColumnChain(benchmark::State& state)
+{
+    const std::string line = makePairs(state.range(0));
+    for (auto _ : state)
+    {
+        PatternSeeker ps(line);
+        for (int64_t i = 0; i < state.range(0); ++i)
+            ps.extractUntilOneOf(";,", move_after);
+        benchmark::DoNotOptimize(ps);
+    }
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+static void BM_LastColumn(benchmark::State& state)
+{
+    const std::string line = makePairs(state.range(0));
+    const PatternSeeker ps(line);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ps.column(state.range(0), ";,"));
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+// Russian text with ASCII punctuation and digits, about a half of the bytes are multibyte
+static std::string makeUtf8Text(size_t size)
+{
+    std::string text;
+    for (size_t i = 0; text.size() < size; ++i)
+        text += "Привет, мир! Строка " + std::to_string(i) + " 😀\n";
+    return text;
+}
+
+static void BM_ValidateUtf8Scalar(benchmark::State& state)
+{
+    const std::string text = makeUtf8Text(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(detail::validateUtf8Scalar(text.data(), text.size()));
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_ValidateUtf8(benchmark::State& state)
+{
+    const std::string text = makeUtf8Text(state.range(0));
+    const PatternSeeker ps(text);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ps.isValidUtf8());
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_SkipChars(benchmark::State& state)
+{
+    const std::string text = makeUtf8Text(state.range(0));
+    for (auto _ : state)
+    {
+        PatternSeeker ps(text);
+        ps.skipChars(text.size() / 2);
+        benchmark::DoNotOptimize(ps);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// The same number of characters of ASCII text marked as such, skipChars() is just skip()
+static void BM_SkipCharsAscii(benchmark::State& state)
+{
+    const std::string text(state.range(0), 'a');
+    PatternSeeker marked(text);
+    marked.markAscii();
+    for (auto _ : state)
+    {
+        PatternSeeker ps = marked;
+        ps.skipChars(text.size() / 2);
+        benchmark::DoNotOptimize(ps);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_TrailerForward(benchmark::State& state)
+{
+    const std::string log = makeTrailedLog(state.range(0));
+    const PatternSeeker ps(log);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.extract("crc=", "\n"));
+    }
+    state.SetBytesProcessed(state.iterations() * log.size());
+}
+
+static void BM_TrailerReverse(benchmark::State& state)
+{
+    const std::string log = makeTrailedLog(state.range(0));
+    const PatternSeeker ps(log);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.rextract("crc=", "\n"));
+    }
+    state.SetBytesProcessed(state.iterations() * log.size());
+}
+
+// Headers of about `size` bytes with the searched one at the end, in another case
+static std::string makeHeaders(size_t size)
+{
+    std::string headers;
+    while (headers.size() < size)
+        headers += "X-Forwarded-For: 10.0.0.1\r\nAccept-Encoding: gzip, deflate\r\nCache-Control: no-cache\r\n";
+    return headers + "CONTENT-TYPE: application/json\r\n\r\n";
+}
+
+// What the callers do without ignore_case: lower-case a copy and search it
+static void BM_IgnoreCaseLowerCopy(benchmark::State& state)
+{
+    const std::string headers = makeHeaders(state.range(0));
+    std::string copy;
+    for (auto _ : state)
+    {
+        copy.resize(headers.size());
+        std::transform(headers.begin(), headers.end(), copy.begin(),
+                       [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        PatternSeeker ps(copy);
+        benchmark::DoNotOptimize(ps.extract("content-type: ", "\r\n"));
+    }
+    state.SetBytesProcessed(state.iterations() * headers.size());
+}
+
+static void BM_IgnoreCase(benchmark::State& state)
+{
+    const std::string headers = makeHeaders(state.range(0));
+    const PatternSeeker ps(headers);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.extract(ignore_case("content-type: "), ignore_case("\r\n")));
+    }
+    state.SetBytesProcessed(state.iterations() * headers.size());
+}
+
+// A nested JSON array of about `size` bytes
+static std::string makeJsonArray(size_t size)
+{
+    std::string array = "{\"items\": [";
+    for (size_t i = 0; array.size() < size; ++i)
+        array += R"({"id": )" + std::to_string(i) + R"(, "tags": ["a", "b"], "meta": {"ok": true}}, )";
+    array += "{}]}";
+    return array;
+}
+
+// The byte-at-a-time loop extract(char, char) used before
+static std::string_view byteLoopBrackets(std::string_view str, char start, char end)
+{
+    const size_t startIndex = str.find(start);
+    if (startIndex == std::string_view::npos)
+        return {};
+    int depth = 1;
+    size_t i = startIndex + 1;
+    while (i < str.size())
+    {
+        const char ch = str[i++];
+        if (ch == start)
+            ++depth;
+        else if (ch == end && --depth == 0)
+            return str.substr(startIndex, i - startIndex);
+    }
+    return {};
+}
+
+static void BM_ExtractBracketsByteLoop(benchmark::State& state)
+{
+    const std::string json = makeJsonArray(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(byteLoopBrackets(json, '[', ']'));
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+static void BM_ExtractBrackets(benchmark::State& state)
+{
+    const std::string json = makeJsonArray(static_cast<size_t>(state.range(0)));
+    const PatternSeeker ps(json);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.extract('[', ']'));
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+static void BM_ExtractQuoteAware(benchmark::State& state)
+{
+    const std::string json = makeJsonArray(static_cast<size_t>(state.range(0)));
+    const PatternSeeker ps(json);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.extractQuoteAware('[', ']'));
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+static const std::string NUMBERS = "918273645 18446744073709 42 7 1234567890123456789 ";
+
+// The walk over an array before jsonArrayElements: extract the array, then the objects one by one
+static void BM_JsonArrayByHand(benchmark::State& state)
+{
+    const std::string json = makeJsonArray(static_cast<size_t>(state.range(0)));
+    const PatternSeeker ps(json);
+    for (auto _ : state)
+    {
+        auto array = ps;
+        array = array.extract('[', ']');
+        size_t count = 0;
+        while (array.extract('{', '}', move_after).isNotEmpty())
+            ++count;
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+static void BM_JsonArrayElements(benchmark::State& state)
+{
+    const std::string json = makeJsonArray(static_cast<size_t>(state.range(0)));
+    PatternSeeker ps(json);
+    ps.to("[", move_before);
+    for (auto _ : state)
+    {
+        size_t count = 0;
+        for (auto element : ps.jsonArrayElements())
+        {
+            benchmark::DoNotOptimize(element);
+            ++count;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+// A log of `size` bytes where one of the `count` keywords comes only at the end
+static std::string makeKeywordLog(size_t size, size_t count)
+{
+    std::string log;
+    while (log.size() < size)
+        log += "ts=1700000000 host=web-01 msg=\"request served\" path=/api/v1/items\n";
+    log += "keyword" + std::to_string(count - 1);
+    return log;
+}
+
+static std::vector<std::string> makeKeywords(size_t count)
+{
+    std::vector<std::string> keywords;
+    for (size_t i = 0; i < count; ++i)
+        keywords.push_back("keyword" + std::to_string(i));
+    return keywords;
+}
+
+// The way to find the first of several patterns before toAnyOf: one search per pattern
+static void BM_ToEachOf(benchmark::State& state)
+{
+    const auto keywords = makeKeywords(static_cast<size_t>(state.range(0)));
+    const std::string log = makeKeywordLog(64 << 10, keywords.size());
+    const PatternSeeker ps(log);
+    for (auto _ : state)
+    {
+        size_t best = std::string_view::npos;
+        for (const auto& keyword : keywords)
+        {
+            auto copy = ps;
+            if (copy.to(keyword, move_before))
+                best = std::min(best, copy.getOffset());
+        }
+        benchmark::DoNotOptimize(best);
+    }
+    state.SetBytesProcessed(state.iterations() * log.size());
+}
+
+static void BM_ToAnyOf(benchmark::State& state)
+{
+    const MultiPattern keywords(makeKeywords(static_cast<size_t>(state.range(0))));
+    const std::string log = makeKeywordLog(64 << 10, keywords.count());
+    const PatternSeeker ps(log);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.toAnyOf(keywords));
+    }
+    state.SetBytesProcessed(state.iterations() * log.size());
+}
+
+static void BM_Strtoull(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        const char* p = NUMBERS.c_str();
+        char* end = nullptr;
+        for (int i = 0; i < 5; ++i, p = end)
+            benchmark::DoNotOptimize(std::strtoull(p, &end, 10));
+    }
+    state.SetBytesProcessed(state.iterations() * NUMBERS.size());
+}
+
+static void BM_TakeUInt64(benchmark::State& state)
+{
+    const PatternSeeker ps(NUMBERS);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        for (int i = 0; i < 5; ++i)
+            benchmark::DoNotOptimize(copy.takeUInt64());
+    }
+    state.SetBytesProcessed(state.iterations() * NUMBERS.size());
+}
+
+static void BM_TakeDouble(benchmark::State& state)
+{
+    const PatternSeeker ps("0.75 -12.5e3 3.14159265358979 1e-7 42 ");
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        for (int i = 0; i < 5; ++i)
+            benchmark::DoNotOptimize(copy.takeDouble());
+    }
+}
+
+static const std::string RECORD = R"({"ts": 1700000000, "host": "web-01", "level": "info", "service": "ingest",)"
+                                 R"( "method": "GET", "path": "/api/v1/items", "status": 200, "bytes": 5120,)"
+                                 R"( "latency_ms": 12.5, "user": "alice", "region": "eu-west-1"})";
+
+static void BM_GetJsonPropTenTimes(benchmark::State& state)
+{
+    const PatternSeeker ps(RECORD);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        for (auto key : { "ts", "host", "level", "service", "method", "path", "status", "bytes", "latency_ms", "region" })
+            benchmark::DoNotOptimize(copy.getJsonProp(key));
+    }
+    state.SetBytesProcessed(state.iterations() * RECORD.size());
+}
+
+// A request handler that indexes every request anew, with the heap and with an arena reset per request
+static void BM_JsonIndexPerRequest(benchmark::State& state)
+{
+    const PatternSeeker ps(RECORD);
+    AllocationScope allocations(state);
+    for (auto _ : state)
+    {
+        const PatternSeeker::JsonIndex index(ps);
+        benchmark::DoNotOptimize(index.getJsonProp("status"));
+    }
+}
+
+static void BM_JsonIndexPerRequestArena(benchmark::State& state)
+{
+    const PatternSeeker ps(RECORD);
+    Arena arena;
+    AllocationScope allocations(state);
+    for (auto _ : state)
+    {
+        arena.reset();
+        const PatternSeeker::JsonIndex index(ps, &arena);
+        benchmark::DoNotOptimize(index.getJsonProp("status"));
+    }
+}
+
+static void BM_GetJsonProps(benchmark::State& state)
+{
+    const PatternSeeker ps(RECORD);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getJsonProps(
+            { "ts", "host", "level", "service", "method", "path", "status", "bytes", "latency_ms", "region" }));
+    }
+    state.SetBytesProcessed(state.iterations() * RECORD.size());
+}
+
+// The typed fields of RECORD, by hand and with a schema
+static void BM_TypedJsonChain(benchmark::State& state)
+{
+    const PatternSeeker ps(RECORD);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getJsonProp("ts").takeUInt64(0));
+        benchmark::DoNotOptimize(copy.getJsonProp("host").to_string_view());
+        benchmark::DoNotOptimize(copy.getJsonProp("level").to_string_view());
+        benchmark::DoNotOptimize(copy.getJsonProp("path").to_string_view());
+        benchmark::DoNotOptimize(copy.getJsonProp("status").takeUInt32(0));
+        benchmark::DoNotOptimize(copy.getJsonProp("bytes").takeUInt64(0));
+        benchmark::DoNotOptimize(copy.getJsonProp("latency_ms").takeDouble(0));
+        benchmark::DoNotOptimize(copy.getJsonProp("region").to_string_view());
+    }
+    state.SetBytesProcessed(state.iterations() * RECORD.size());
+}
+
+static void BM_TypedJsonSchema(benchmark::State& state)
+{
+    using Record = schema<field<"ts", uint64_t>, field<"host", std::string_view>, field<"level", std::string_view>,
+                          field<"path", std::string_view>, field<"status", uint32_t>, field<"bytes", uint64_t>,
+                          field<"latency_ms", double>, field<"region", std::string_view>>;
+    const PatternSeeker ps(RECORD);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Record::parseJson(ps));
+    state.SetBytesProcessed(state.iterations() * RECORD.size());
+}
+
+// A SOAP response with `fields` distinct tags in its body repeated to about 16 KB
+static std::string makeSoap(size_t fields)
+{
+    std::string soap = R"(<?xml version="1.0"?><soap:Envelope xmlns:soap="urn:soap"><soap:Body><Response>)";
+    for (size_t i = 0; soap.size() < (16 << 10); ++i)
+        soap += "<field" + std::to_string(i % fields) + " type=\"string\">value number " + std::to_string(i)
+                + "</field" + std::to_string(i % fields) + ">";
+    return soap + "</Response></soap:Body></soap:Envelope>";
+}
+
+// The last occurrence of each of the tags, each one found by its own search
+static void BM_XmlTagBodyPerTag(benchmark::State& state)
+{
+    const size_t fields = state.range(0);
+    const std::string soap = makeSoap(fields);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < fields; ++i)
+        names.push_back("field" + std::to_string(i));
+    for (auto _ : state)
+    {
+        for (const auto& name : names)
+        {
+            PatternSeeker ps(soap);
+            PatternSeeker last{std::string_view{}};
+            for (auto body = ps.getXmlTagBody(name, move_after); body.isNotEmpty(); body = ps.getXmlTagBody(name, move_after))
+                last = body;
+            benchmark::DoNotOptimize(last);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * soap.size());
+}
+
+static void BM_XmlTokenizer(benchmark::State& state)
+{
+    const std::string soap = makeSoap(state.range(0));
+    std::vector<PatternSeeker> last(state.range(0), PatternSeeker{std::string_view{}});
+    for (auto _ : state)
+    {
+        XmlTokenizer xml{PatternSeeker(soap)};
+        size_t field = 0;
+        while (auto event = xml.next())
+        {
+            if (event.type == XmlEventType::start_tag && event.name.startsWith("field"))
+            {
+                event.name.skip(size_t(5));
+                field = event.name.takeUInt64(0);
+            }
+            else if (event.type == XmlEventType::text)
+                last[field] = event.value;
+        }
+        benchmark::DoNotOptimize(last.data());
+    }
+    state.SetBytesProcessed(state.iterations() * soap.size());
+}
+
+// A message of about 1 KB whose routing fields come after the payload
+static std::string makeRoutedMessage(size_t copy)
+{
+    std::string message = "{\"payload\": {";
+    for (size_t i = 0; i < 24; ++i)
+        message += "\"field" + std::to_string(i) + "\": \"value " + std::to_string(i * 31 + copy) + "\", ";
+    return message + "\"seq\": " + std::to_string(copy) + "}, \"type\": \"order\", \"tenant\": \"acme\", \"region\": \"eu\"}";
+}
+
+// Each of the rules looks up the same routing fields, as independent rules do
+template <typename Seeker>
+static size_t runRules(Seeker& message, size_t rules)
+{
+    size_t matched = 0;
+    for (size_t rule = 0; rule < rules; ++rule)
+    {
+        matched += message.getJsonProp("type").size() == 5;
+        matched += message.getJsonProp("tenant").size() == 4;
+        matched += message.getJsonProp("region").size() == 2;
+    }
+    return matched;
+}
+
+static void BM_RoutingRules(benchmark::State& state)
+{
+    const std::string messages[] = { makeRoutedMessage(0), makeRoutedMessage(1) };
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        PatternSeeker message(messages[i++ & 1]);
+        benchmark::DoNotOptimize(runRules(message, state.range(0)));
+    }
+    state.SetBytesProcessed(state.iterations() * messages[0].size());
+}
+
+// One cache is reused, each new message clears it
+static void BM_RoutingRulesCached(benchmark::State& state)
+{
+    const std::string messages[] = { makeRoutedMessage(0), makeRoutedMessage(1) };
+    CachedSeeker message{PatternSeeker(messages[0])};
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        message.reset(PatternSeeker(messages[i++ & 1]));
+        benchmark::DoNotOptimize(runRules(message, state.range(0)));
+    }
+    state.SetBytesProcessed(state.iterations() * messages[0].size());
+}
+
+// ============================================================================
+// Hand-off between a reading thread and a parsing thread
+// ============================================================================
+
+static constexpr size_t HANDOFF_MESSAGES = 1 << 16;
+
+// One buffer of small JSON messages, one per line
+static SharedBuffer makeMessages()
+{
+    std::string lines;
+    for (size_t i = 0; i < HANDOFF_MESSAGES; ++i)
+        lines += R"({"id": )" + std::to_string(i) + R"(, "type": "click"})" + "\n";
+    return SharedBuffer::adopt(std::move(lines));
+}
+
+// Runs `consume` on another thread while `produce` hands the messages to it
+// `prepare` runs before every iteration, untimed, since a closed ring can't be reopened
+template <typename Produce, typename Consume, typename Prepare = void (*)()>
+static void runHandoff(benchmark::State& state, Produce produce, Consume consume, Prepare prepare = [] {})
+{
+    const SharedBuffer buffer = makeMessages();
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        prepare();
+        state.ResumeTiming();
+        uint64_t sum = 0;
+        std::thread consumer([&] { sum = consume(); });
+        produce(buffer);
+        consumer.join();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * HANDOFF_MESSAGES);
+}
+
+// The mutex-guarded deque the lock-free rings replace
+static void BM_HandoffMutexDeque(benchmark::State& state)
+{
+    std::mutex mutex;
+    std::deque<SharedSeeker> queue;
+    bool closed = false;
+    runHandoff(state,
+        [&](const SharedBuffer& buffer) {
+            for (auto rest = buffer.seeker(); rest.isNotEmpty();)
+            {
+                SharedSeeker message(buffer, rest.extract("\n", move_after));
+                std::lock_guard lock(mutex);
+                queue.push_back(std::move(message));
+            }
+            std::lock_guard lock(mutex);
+            closed = true;
+        },
+        [&] {
+            uint64_t sum = 0;
+            while (true)
+            {
+                SharedSeeker message;
+                {
+                    std::lock_guard lock(mutex);
+                    if (queue.empty())
+                    {
+                        if (closed)
+                            break;
+                        continue;
+                    }
+                    message = std::move(queue.front());
+                    queue.pop_front();
+                }
+                sum += message->getJsonProp("id").takeUInt64(0);
+            }
+            closed = false;
+            return sum;
+        });
+}
+
+template <typename Ring>
+static void handoffMessages(benchmark::State& state)
+{
+    std::unique_ptr<Ring> ring;
+    runHandoff(state,
+        [&](const SharedBuffer& buffer) {
+            for (auto rest = buffer.seeker(); rest.isNotEmpty();)
+                ring->push(SharedSeeker(buffer, rest.extract("\n", move_after)));
+            ring->close();
+        },
+        [&] {
+            uint64_t sum = 0;
+            for (SharedSeeker message; ring->pop(message);)
+                sum += message->getJsonProp("id").takeUInt64(0);
+            return sum;
+        },
+        [&] { ring = std::make_unique<Ring>(1024); });
+}
+
+static void BM_HandoffSpscRing(benchmark::State& state)
+{
+    handoffMessages<SpscRing<SharedSeeker>>(state);
+}
+
+static void BM_HandoffMpmcRing(benchmark::State& state)
+{
+    handoffMessages<MpmcRing<SharedSeeker>>(state);
+}
+
+// The messages of one buffer go in batches under one reference
+static void BM_HandoffSpscBatches(benchmark::State& state)
+{
+    std::unique_ptr<SpscRing<RecordBatch>> ring;
+    runHandoff(state,
+        [&](const SharedBuffer& buffer) {
+            RecordBatch batch(buffer);
+            for (auto rest = buffer.seeker(); rest.isNotEmpty();)
+            {
+                const auto line = rest.extract("\n", move_after);
+                if (!batch.add(line))
+                {
+                    ring->push(std::move(batch));
+                    batch.reset(buffer);
+                    batch.add(line);
+                }
+            }
+            ring->push(std::move(batch));
+            ring->close();
+        },
+        [&] {
+            uint64_t sum = 0;
+            for (RecordBatch batch; ring->pop(batch);)
+                batch.forEach([&](PatternSeeker message) { sum += message.getJsonProp("id").takeUInt64(0); });
+            return sum;
+        },
+        [&] { ring = std::make_unique<SpscRing<RecordBatch>>(64); });
+}
+
+// `count` log lines of about 200 bytes
+static std::vector<std::string> makeLogLines(size_t count)
+{
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < count; ++i)
+        lines.push_back("2024-05-01T10:00:00Z host=web-" + std::to_string(i % 32) + " level=info service=api user=u"
+                        + std::to_string(i * 7919 % 100000) + " method=GET path=/api/v1/items/" + std::to_string(i)
+                        + " status=200 bytes=" + std::to_string(i * 131 % 65536) + " latency_ms=" + std::to_string(i % 900)
+                        + " region=eu-west-1 trace=" + std::string(24, 'a' + i % 26));
+    return lines;
+}
+
+// A chain of extractions over one log line, the usual shape of a hand-written parser
+static void BM_ExtractionChainChecked(benchmark::State& state)
+{
+    const auto lines = makeLogLines(256);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        PatternSeeker ps(lines[i++ & 255]);
+        ps.to("host=", move_after);
+        auto host = ps.extract(" ", move_after);
+        ps.to("user=u", move_after);
+        const auto user = ps.takeUInt64(0);
+        auto path = ps.extract("path=", " ", move_after);
+        ps.to("status=", move_after);
+        const auto status = ps.takeUInt64(0);
+        ps.to("bytes=", move_after);
+        const auto bytes = ps.takeUInt64(0);
+        benchmark::DoNotOptimize(host.size() + user + path.size() + status + bytes);
+    }
+}
+
+static void BM_ExtractionChainUnchecked(benchmark::State& state)
+{
+    const auto lines = makeLogLines(256);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        UncheckedSeeker ps(lines[i++ & 255]);
+        ps.to<move_after>("host=");
+        auto host = ps.extract<move_after>(" ");
+        ps.to<move_after>("user=u");
+        const auto user = ps.take<uint64_t>();
+        auto path = ps.extract<move_after>("path=", " ");
+        ps.to<move_after>("status=");
+        const auto status = ps.take<uint64_t>();
+        ps.to<move_after>("bytes=");
+        const auto bytes = ps.take<uint64_t>();
+        benchmark::DoNotOptimize(host.size() + user + path.size() + status + bytes + ps.failed());
+    }
+}
+
+// Log lines, about 30% of them of another service without the fields of the chains below
+static std::vector<std::string> makeMixedLines()
+{
+    auto lines = makeLogLines(256);
+    for (size_t i = 0; i < lines.size(); i += 3)
+        lines[i] = "2024-05-01T10:00:00Z kernel: eth0 link up, " + std::string(160, 'x') + " " + std::to_string(i);
+    return lines;
+}
+
+// A failed step returns an empty seeker, and the rest of the chain still runs on the cursor
+static void BM_FailingChainPlain(benchmark::State& state)
+{
+    const auto lines = makeMixedLines();
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        PatternSeeker ps(lines[i++ & 255]);
+        ps.to("host=", move_after);
+        auto host = ps.extract(" ", move_after);
+        auto path = ps.extract("path=", " ", move_after);
+        ps.to("status=", move_after);
+        const auto status = ps.takeUInt64(0);
+        ps.to("bytes=", move_after);
+        const auto bytes = ps.takeUInt64(0);
+        benchmark::DoNotOptimize(host.size() + path.size() + status + bytes);
+    }
+}
+
+static void BM_FailingChainSeekChain(benchmark::State& state)
+{
+    const auto lines = makeMixedLines();
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        PatternSeeker host{std::string_view{}}, path{std::string_view{}};
+        uint64_t status = 0, bytes = 0;
+        SeekChain chain(PatternSeeker(lines[i++ & 255]));
+        chain.to("host=", move_after).extract(" ", host, move_after).extract("path=", " ", path, move_after)
+             .to("status=", move_after).take(status).to("bytes=", move_after).take(bytes);
+        benchmark::DoNotOptimize(host.size() + path.size() + status + bytes + chain.failedOffset());
+    }
+}
+
+// The records of a batch come from different buffers, so they are read in a random order
+static std::vector<std::string_view> shuffledRecords(const std::vector<std::string>& lines)
+{
+    std::vector<std::string_view> records(lines.begin(), lines.end());
+    std::shuffle(records.begin(), records.end(), std::mt19937(1));
+    return records;
+}
+
+static void BM_BatchByHand(benchmark::State& state)
+{
+    const auto lines = makeLogLines(state.range(0));
+    const auto records = shuffledRecords(lines);
+    std::vector<std::string_view> users(lines.size());
+    std::vector<uint64_t> bytes(lines.size());
+    std::vector<uint64_t> latencies(lines.size());
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            PatternSeeker ps(records[i]);
+            if (ps.to("user=", move_after))
+                users[i] = ps.extract(" ", move_after).to_string_view();
+            if (ps.to("bytes=", move_after))
+                bytes[i] = ps.takeUInt64(0);
+            if (ps.to("latency_ms=", move_after))
+                latencies[i] = ps.takeUInt64(0);
+        }
+        benchmark::DoNotOptimize(users.data());
+        benchmark::DoNotOptimize(bytes.data());
+        benchmark::DoNotOptimize(latencies.data());
+    }
+    state.SetItemsProcessed(state.iterations() * lines.size());
+}
+
+static void BM_BatchExecutor(benchmark::State& state)
+{
+    const auto lines = makeLogLines(state.range(0));
+    const auto records = shuffledRecords(lines);
+    ExtractionPlan plan;
+    plan.to("user=").extract(" ").to("bytes=").takeUInt64().to("latency_ms=").takeUInt64();
+    // the second argument is how many bytes of each record are prefetched
+    const BatchExecutor executor(plan, 16, state.range(1));
+    BatchResult result;
+    for (auto _ : state)
+    {
+        executor.run(records, result);
+        benchmark::DoNotOptimize(result.valid().data());
+    }
+    state.SetItemsProcessed(state.iterations() * lines.size());
+}
+
+// {"k0": {"id": 0, "name": "item 0", "tags": ["a", "b"]}, "k1": ...} of about `size` bytes
+static std::string makeJsonObject(size_t size)
+{
+    std::string json = "{";
+    for (size_t i = 0; json.size() < size; ++i)
+        json += "\"k" + std::to_string(i) + "\": {\"id\": " + std::to_string(i) + R"(, "name": "item", "tags": ["a", "b"]}, )";
+    json += "\"last\": {\"id\": 42}}";
+    return json;
+}
+
+static void BM_JsonIndexBuild(benchmark::State& state)
+{
+    const std::string json = makeJsonObject(static_cast<size_t>(state.range(0)));
+    const PatternSeeker ps(json);
+    PatternSeeker::JsonIndex index;
+    AllocationScope allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index.build(ps));
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+static void BM_GetJsonPropNested(benchmark::State& state)
+{
+    const std::string json = makeJsonObject(static_cast<size_t>(state.range(0)));
+    const PatternSeeker ps(json);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(copy.getJsonProp("last").getJsonProp("id"));
+    }
+}
+
+static void BM_JsonPathNested(benchmark::State& state)
+{
+    const std::string json = makeJsonObject(static_cast<size_t>(state.range(0)));
+    const PatternSeeker ps(json);
+    const auto path = JsonPath::compile("$.last.id");
+    for (auto _ : state)
+        benchmark::DoNotOptimize(path.find(ps));
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+static void BM_JsonIndexNested(benchmark::State& state)
+{
+    const std::string json = makeJsonObject(static_cast<size_t>(state.range(0)));
+    const PatternSeeker::JsonIndex index{PatternSeeker(json)};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index.root().getJsonProp("last").getJsonProp("id").seeker());
+}
+
+static void BM_JsonIndexGetJsonProp(benchmark::State& state)
+{
+    const std::string json = makeJsonObject(static_cast<size_t>(state.range(0)));
+    const PatternSeeker::JsonIndex index{PatternSeeker(json)};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index.getJsonProp("last"));
+}
+
+BENCHMARK(BM_JsonIndexBuild)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_GetJsonPropNested)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_JsonPathNested)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_JsonIndexNested)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_JsonIndexGetJsonProp)->Arg(4 << 10)->Arg(1 << 20);
+
+BENCHMARK(BM_GetJsonPropTenTimes);
+BENCHMARK(BM_GetJsonProps);
+BENCHMARK(BM_TypedJsonChain);
+BENCHMARK(BM_TypedJsonSchema);
+
+BENCHMARK(BM_XmlTagBodyPerTag)->Arg(1)->Arg(16)->Arg(64);
+BENCHMARK(BM_XmlTokenizer)->Arg(1)->Arg(16)->Arg(64);
+
+BENCHMARK(BM_RoutingRules)->Arg(1)->Arg(10);
+BENCHMARK(BM_RoutingRulesCached)->Arg(1)->Arg(10);
+BENCHMARK(BM_JsonIndexPerRequest);
+BENCHMARK(BM_JsonIndexPerRequestArena);
+
+BENCHMARK(BM_HandoffMutexDeque)->UseRealTime();
+BENCHMARK(BM_HandoffSpscRing)->UseRealTime();
+BENCHMARK(BM_HandoffMpmcRing)->UseRealTime();
+BENCHMARK(BM_HandoffSpscBatches)->UseRealTime();
+
+BENCHMARK(BM_BatchByHand)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(BM_BatchExecutor)->Args({1 << 10, 256})->Args({1 << 16, 0})->Args({1 << 16, 256});
+
+BENCHMARK(BM_JsonArrayByHand)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_JsonArrayElements)->Arg(4 << 10)->Arg(1 << 20);
+
+BENCHMARK(BM_ToEachOf)->Arg(3)->Arg(8)->Arg(64);
+BENCHMARK(BM_ToAnyOf)->Arg(3)->Arg(8)->Arg(64);
+
+BENCHMARK(BM_Strtoull);
+BENCHMARK(BM_TakeUInt64);
+BENCHMARK(BM_TakeDouble);
+
+BENCHMARK(BM_ExtractionChainChecked);
+BENCHMARK(BM_ExtractionChainUnchecked);
+
+BENCHMARK(BM_FailingChainPlain);
+BENCHMARK(BM_FailingChainSeekChain);
+
+BENCHMARK(BM_IgnoreCaseLowerCopy)->Arg(1 << 10)->Arg(64 << 10);
+BENCHMARK(BM_IgnoreCase)->Arg(1 << 10)->Arg(64 << 10);
+
+BENCHMARK(BM_FieldsExtractUntilOneOf)->Arg(16)->Arg(1024);
+BENCHMARK(BM_FieldsRange)->Arg(16)->Arg(1024);
+BENCHMARK(BM_FieldsSplitInto)->Arg(16)->Arg(1024);
+BENCHMARK(BM_LastColumnChain)->Arg(16)->Arg(1024);
+BENCHMARK(BM_LastColumn)->Arg(16)->Arg(1024);
+
+BENCHMARK(BM_ValidateUtf8Scalar)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_ValidateUtf8)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_SkipChars)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_SkipCharsAscii)->Arg(4 << 10)->Arg(1 << 20);
+
+BENCHMARK(BM_TrailerForward)->Arg(4 << 10)->Arg(1 << 20);
+BENCHMARK(BM_TrailerReverse)->Arg(4 << 10)->Arg(1 << 20);
+
+BENCHMARK(BM_ExtractBracketsByteLoop)->Arg(1 << 10)->Arg(100 << 10);
+BENCHMARK(BM_ExtractBrackets)->Arg(1 << 10)->Arg(100 << 10);
+BENCHMARK(BM_ExtractQuoteAware)->Arg(1 << 10)->Arg(100 << 10);
+
+BENCHMARK_CAPTURE(BM_SearchBackend, scalar, SearchBackend::scalar)->Apply(searchBackendArgs);
+BENCHMARK_CAPTURE(BM_SearchBackend, sse2, SearchBackend::sse2)->Apply(searchBackendArgs);
+BENCHMARK_CAPTURE(BM_SearchBackend, avx2, SearchBackend::avx2)->Apply(searchBackendArgs);
+BENCHMARK_CAPTURE(BM_SearchBackend, avx512, SearchBackend::avx512)->Apply(searchBackendArgs);
+BENCHMARK_CAPTURE(BM_SearchBackend, neon, SearchBackend::neon)->Apply(searchBackendArgs);
+
+BENCHMARK_CAPTURE(BM_GetJsonProp, short_key, SHORT_KEY);
+BENCHMARK_CAPTURE(BM_GetJsonProp, long_key, LONG_KEY);
+BENCHMARK_CAPTURE(BM_ConcatJsonLookup, short_key, SHORT_KEY);
+BENCHMARK_CAPTURE(BM_ConcatJsonLookup, long_key, LONG_KEY);
+BENCHMARK_CAPTURE(BM_GetXmlTag, long_key, LONG_KEY);
+BENCHMARK_CAPTURE(BM_GetXmlTagBody, long_key, LONG_KEY);
+BENCHMARK_CAPTURE(BM_ConcatXmlLookup, long_key, LONG_KEY);
+BENCHMARK(BM_GetXmlAttr);
+BENCHMARK(BM_ToRuntime);
+BENCHMARK(BM_ToPattern);
+BENCHMARK(BM_ToShortRuntime);
+BENCHMARK(BM_ToShortPattern);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,344 @@
+#include "../PatternSeeker.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <regex>
+#include <string>
+#include <utility>
+
+#if defined(PATTERN_SEEKER_BENCH_JSONCPP)
+#include <json/json.h>
+#endif
+
+using namespace PatterSeekerNS;
+
+// Every operation over the same matrix of inputs: payloads from 64B to 10MB
+// with the searched key at the front, in the middle or absent.
+// The bytes/sec of a benchmark is the payload size, wherever the key is.
+
+// ============================================================================
+// Payloads
+// ============================================================================
+
+enum KeyPosition
+{
+    key_front,
+    key_middle,
+    key_absent,
+};
+
+static const std::string KEY = "needle_key";
+
+// The filler text shares prefixes with the key, so a search can't skip it too easily.
+static std::string makePayload(size_t size, KeyPosition position, const std::string& filler, const std::string& needle,
+                               const std::string& open, const std::string& close)
+{
+    std::string body;
+    if (position == key_front)
+        body += needle;
+    while (body.size() + open.size() + close.size() + needle.size() < size)
+    {
+        if (position == key_middle && body.size() + needle.size() >= size / 2)
+        {
+            body += needle;
+            position = key_front;
+            continue;
+        }
+        body += filler;
+    }
+    // tiny payloads are smaller than the filler, the key is added anyway
+    if (position == key_middle)
+        body += needle;
+    return open + body + close;
+}
+
+// {"needle_key": 12345, "needle_xx": "lorem ipsum", ...}
+static const std::string& jsonPayload(size_t size, KeyPosition position)
+{
+    static std::map<std::pair<size_t, int>, std::string> cache;
+    auto& payload = cache[{ size, position }];
+    if (payload.empty())
+        payload = makePayload(size, position, R"("needle_xx": "lorem { ipsum } dolor", )",
+                              R"("needle_key": 12345, )", "{", R"("end": 0})");
+    return payload;
+}
+
+// <root><needle_xx>lorem</needle_xx>...<needle_key value="12345">12345</needle_key>...</root>
+static const std::string& xmlPayload(size_t size, KeyPosition position)
+{
+    static std::map<std::pair<size_t, int>, std::string> cache;
+    auto& payload = cache[{ size, position }];
+    if (payload.empty())
+        payload = makePayload(size, position, R"(<needle_xx kind="filler">lorem ipsum dolor</needle_xx>)",
+                              R"(<needle_key value="12345">12345</needle_key>)", "<root>", "</root>");
+    return payload;
+}
+
+// Plain text with `[needle_key]` as the searched delimiter
+static const std::string& textPayload(size_t size, KeyPosition position)
+{
+    static std::map<std::pair<size_t, int>, std::string> cache;
+    auto& payload = cache[{ size, position }];
+    if (payload.empty())
+        payload = makePayload(size, position, "needle lorem, ipsum; (dolor) sit amet ", "[needle_key]", "", "");
+    return payload;
+}
+
+static size_t payloadSize(const benchmark::State& state)
+{
+    return static_cast<size_t>(state.range(0));
+}
+
+static KeyPosition keyPosition(const benchmark::State& state)
+{
+    return static_cast<KeyPosition>(state.range(1));
+}
+
+static const size_t PAYLOAD_SIZES[] = { 64, 4 << 10, 256 << 10, 10 << 20 };
+
+static void payloadArgs(benchmark::internal::Benchmark* bench, size_t maxSize)
+{
+    bench->ArgNames({ "bytes", "key" });
+    for (size_t size : PAYLOAD_SIZES)
+    {
+        if (size > maxSize)
+            break;
+        for (int position : { key_front, key_middle, key_absent })
+            bench->Args({ static_cast<int64_t>(size), position });
+    }
+}
+
+// For the operations that read the whole payload anyway
+static void sizeArgs(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({ "bytes", "key" });
+    for (size_t size : PAYLOAD_SIZES)
+        bench->Args({ static_cast<int64_t>(size), key_absent });
+}
+
+static void allPayloads(benchmark::internal::Benchmark* bench)
+{
+    payloadArgs(bench, size_t(10) << 20);
+}
+
+// std::regex is slow enough for the largest payload to take minutes
+static void regexPayloads(benchmark::internal::Benchmark* bench)
+{
+    payloadArgs(bench, size_t(256) << 10);
+}
+
+static void runOnPayload(benchmark::State& state, const std::string& payload, auto&& operation)
+{
+    const PatternSeeker ps(payload);
+    for (auto _ : state)
+    {
+        auto copy = ps;
+        benchmark::DoNotOptimize(operation(copy));
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+// ============================================================================
+// Navigation and extraction
+// ============================================================================
+
+static void BM_Payload_To(benchmark::State& state)
+{
+    runOnPayload(state, textPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.to("[needle_key]", move_after); });
+}
+
+static void BM_Payload_ExtractFromTo(benchmark::State& state)
+{
+    runOnPayload(state, textPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.extract("[needle", "key]"); });
+}
+
+static void BM_Payload_ExtractTo(benchmark::State& state)
+{
+    runOnPayload(state, textPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.extract("[needle_key]"); });
+}
+
+static void BM_Payload_ExtractUntilOneOf(benchmark::State& state)
+{
+    runOnPayload(state, textPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.extractUntilOneOf("[]"); });
+}
+
+// The whole Json object
+static void BM_Payload_ExtractBrackets(benchmark::State& state)
+{
+    runOnPayload(state, jsonPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.extract('{', '}'); });
+}
+
+static void BM_Payload_ExtractQuoteAware(benchmark::State& state)
+{
+    runOnPayload(state, jsonPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.extractQuoteAware('{', '}'); });
+}
+
+static void BM_Payload_ExtractSize(benchmark::State& state)
+{
+    const size_t size = payloadSize(state);
+    runOnPayload(state, textPayload(size, keyPosition(state)),
+                 [size](PatternSeeker& ps) { return ps.extract(size / 2, move_after); });
+}
+
+static void BM_Payload_SkipWhiteSpaces(benchmark::State& state)
+{
+    // the key position is where the whitespaces end
+    static std::map<std::pair<size_t, int>, std::string> cache;
+    const size_t size = payloadSize(state);
+    auto& payload = cache[{ size, keyPosition(state) }];
+    if (payload.empty())
+    {
+        const size_t spaces = keyPosition(state) == key_front ? 0 : keyPosition(state) == key_middle ? size / 2 : size;
+        payload = std::string(spaces, ' ');
+        for (size_t i = 0; i < spaces; i += 7)
+            payload[i] = "\t\n\r "[i % 4];
+        payload.resize(size, 'x');
+    }
+    runOnPayload(state, payload, [](PatternSeeker& ps) {
+        ps.skipWhiteSpaces();
+        return ps.size();
+    });
+}
+
+// ============================================================================
+// Numbers
+// ============================================================================
+
+static const std::string& numbersPayload(size_t size, bool negative)
+{
+    static std::map<std::pair<size_t, bool>, std::string> cache;
+    auto& payload = cache[{ size, negative }];
+    for (uint64_t i = 1; payload.size() < size; i = i * 31 + 7)
+    {
+        if (negative && i % 2)
+            payload += '-';
+        payload += std::to_string(i % 10000000000000ull);
+        payload += ' ';
+    }
+    return payload;
+}
+
+static void BM_Payload_TakeUInt64(benchmark::State& state)
+{
+    const std::string& payload = numbersPayload(payloadSize(state), false);
+    runOnPayload(state, payload, [](PatternSeeker& ps) {
+        uint64_t sum = 0;
+        while (auto value = ps.takeUInt64())
+            sum += *value;
+        return sum;
+    });
+}
+
+static void BM_Payload_TakeInt64(benchmark::State& state)
+{
+    const std::string& payload = numbersPayload(payloadSize(state), true);
+    runOnPayload(state, payload, [](PatternSeeker& ps) {
+        int64_t sum = 0;
+        while (auto value = ps.takeInt64())
+            sum += *value;
+        return sum;
+    });
+}
+
+// ============================================================================
+// Json and XML
+// ============================================================================
+
+static void BM_Payload_GetJsonProp(benchmark::State& state)
+{
+    runOnPayload(state, jsonPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.getJsonProp(KEY); });
+}
+
+static void BM_Payload_GetXmlTag(benchmark::State& state)
+{
+    runOnPayload(state, xmlPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.getXmlTag(KEY); });
+}
+
+static void BM_Payload_GetXmlTagBody(benchmark::State& state)
+{
+    runOnPayload(state, xmlPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.getXmlTagBody(KEY); });
+}
+
+static void BM_Payload_GetXmlAttr(benchmark::State& state)
+{
+    runOnPayload(state, xmlPayload(payloadSize(state), keyPosition(state)),
+                 [](PatternSeeker& ps) { return ps.getXmlAttr("value"); });
+}
+
+// ============================================================================
+// References
+// ============================================================================
+
+// The same lookup as getJsonProp with std::regex
+static void BM_Payload_RegexJsonProp(benchmark::State& state)
+{
+    const std::string& payload = jsonPayload(payloadSize(state), keyPosition(state));
+    const std::regex regex(R"re("needle_key"\s*:\s*([^,}\s]+))re");
+    for (auto _ : state)
+    {
+        std::smatch match;
+        benchmark::DoNotOptimize(std::regex_search(payload, match, regex));
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+// The same lookup as getXmlTagBody with std::regex
+static void BM_Payload_RegexXmlTagBody(benchmark::State& state)
+{
+    const std::string& payload = xmlPayload(payloadSize(state), keyPosition(state));
+    const std::regex regex(R"re(<needle_key[^>]*>([^<]*)</needle_key>)re");
+    for (auto _ : state)
+    {
+        std::smatch match;
+        benchmark::DoNotOptimize(std::regex_search(payload, match, regex));
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+#if defined(PATTERN_SEEKER_BENCH_JSONCPP)
+
+// A full Json parser has to read the whole document, wherever the key is
+static void BM_Payload_JsonCppLookup(benchmark::State& state)
+{
+    const std::string& payload = jsonPayload(payloadSize(state), keyPosition(state));
+    Json::CharReaderBuilder builder;
+    const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    for (auto _ : state)
+    {
+        Json::Value root;
+        reader->parse(payload.data(), payload.data() + payload.size(), &root, nullptr);
+        benchmark::DoNotOptimize(root.get(KEY, Json::Value()).asInt64());
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+}
+
+BENCHMARK(BM_Payload_JsonCppLookup)->Apply(allPayloads);
+
+#endif
+
+BENCHMARK(BM_Payload_To)->Apply(allPayloads);
+BENCHMARK(BM_Payload_ExtractFromTo)->Apply(allPayloads);
+BENCHMARK(BM_Payload_ExtractTo)->Apply(allPayloads);
+BENCHMARK(BM_Payload_ExtractUntilOneOf)->Apply(allPayloads);
+BENCHMARK(BM_Payload_ExtractBrackets)->Apply(sizeArgs);
+BENCHMARK(BM_Payload_ExtractQuoteAware)->Apply(sizeArgs);
+BENCHMARK(BM_Payload_ExtractSize)->Apply(sizeArgs);
+BENCHMARK(BM_Payload_SkipWhiteSpaces)->Apply(allPayloads);
+BENCHMARK(BM_Payload_TakeUInt64)->Apply(sizeArgs);
+BENCHMARK(BM_Payload_TakeInt64)->Apply(sizeArgs);
+BENCHMARK(BM_Payload_GetJsonProp)->Apply(allPayloads);
+BENCHMARK(BM_Payload_GetXmlTag)->Apply(allPayloads);
+BENCHMARK(BM_Payload_GetXmlTagBody)->Apply(allPayloads);
+BENCHMARK(BM_Payload_GetXmlAttr)->Apply(allPayloads);
+BENCHMARK(BM_Payload_RegexJsonProp)->Apply(regexPayloads);
+BENCHMARK(BM_Payload_RegexXmlTagBody)->Apply(regexPayloads);
@@ -0,0 +1,200 @@
+#ifndef PATTERN_SEEKER_FUZZ_COMMON_H
+#define PATTERN_SEEKER_FUZZ_COMMON_H
+
+#include "../PatternSeeker.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+// The helpers of the differential fuzz targets. Every target runs the scalar reference and the other engines
+// on the same input and aborts on the first result that differs, so libFuzzer reports the input as a crash.
+// With PATTERN_SEEKER_FUZZ_PERF=<file> in the environment, the targets also time every engine on every input
+// and append `target<TAB>engine<TAB>bytes<TAB>ns/byte` lines to the file.
+namespace PatterSeekerNS::fuzz {
+
+// The input is split into short patterns and the data: each pattern is prefixed by its size byte
+class FuzzInput
+{
+private:
+    std::string_view m_data;
+
+public:
+    FuzzInput(const uint8_t* data, size_t size)
+        : m_data(reinterpret_cast<const char*>(data), size)
+    {}
+
+    // Takes a piece of up to `maxSize` bytes
+    std::string_view take(size_t maxSize)
+    {
+        if (m_data.empty())
+            return {};
+        const size_t size = std::min<size_t>(static_cast<uint8_t>(m_data[0]) % (maxSize + 1), m_data.size() - 1);
+        const auto piece = m_data.substr(1, size);
+        m_data.remove_prefix(size + 1);
+        return piece;
+    }
+
+    // Takes a byte for the choices of the target
+    uint8_t byte()
+    {
+        if (m_data.empty())
+            return 0;
+        const auto result = static_cast<uint8_t>(m_data[0]);
+        m_data.remove_prefix(1);
+        return result;
+    }
+
+    std::string_view rest() const
+    {
+        return m_data;
+    }
+};
+
+// A result of an engine that can be compared with the reference: whether it is found,
+// its offset and size, and the offset of the cursor after the call
+struct Outcome
+{
+    bool found = false;
+    size_t offset = 0;
+    size_t size = 0;
+    size_t cursor = 0;
+
+    bool operator==(const Outcome&) const = default;
+};
+
+// Failed results point to the empty string of PatternSeeker, and so does a default one
+inline bool found(const PatternSeeker& result)
+{
+    return result.to_string_view().data() != PatternSeeker(std::string_view{}).to_string_view().data();
+}
+
+inline Outcome outcome(PatternSeeker result, PatternSeeker cursor)
+{
+    if (!found(result))
+        return { false, 0, 0, cursor.getOffset() };
+    return { true, result.getOffset(), result.size(), cursor.getOffset() };
+}
+
+inline Outcome outcome(bool result, PatternSeeker cursor)
+{
+    return { result, 0, 0, cursor.getOffset() };
+}
+
+[[noreturn]] inline void fail(const char* target, const char* engine, const Outcome& expected, const Outcome& actual)
+{
+    std::fprintf(stderr, "%s: %s differs from the reference: found %d offset %zu size %zu cursor %zu, expected %d %zu %zu %zu\n",
+        target, engine, actual.found, actual.offset, actual.size, actual.cursor,
+        expected.found, expected.offset, expected.size, expected.cursor);
+    std::abort();
+}
+
+inline void check(const char* target, const char* engine, const Outcome& expected, const Outcome& actual)
+{
+    if (!(expected == actual))
+        fail(target, engine, expected, actual);
+}
+
+inline void check(const char* target, const char* engine, size_t expected, size_t actual)
+{
+    if (expected != actual)
+    {
+        std::fprintf(stderr, "%s: %s differs from the reference: %zu, expected %zu\n", target, engine, actual, expected);
+        std::abort();
+    }
+}
+
+inline const char* backendName(SearchBackend backend)
+{
+    switch (backend)
+    {
+    case SearchBackend::scalar:
+        return "scalar";
+    case SearchBackend::sse2:
+        return "sse2";
+    case SearchBackend::avx2:
+        return "avx2";
+    case SearchBackend::avx512:
+        return "avx512";
+    case SearchBackend::neon:
+        return "neon";
+    }
+    return "unknown";
+}
+
+// Calls `run(name)` with every backend the CPU supports forced in turn, the scalar one first,
+// and restores the backend in use
+template <typename Run>
+void forEachBackend(Run&& run)
+{
+    const SearchBackend current = activeSearchBackend();
+    for (const auto backend : { SearchBackend::scalar, SearchBackend::sse2, SearchBackend::avx2,
+                                SearchBackend::avx512, SearchBackend::neon })
+    {
+        if (setSearchBackend(backend))
+            run(backendName(backend));
+    }
+    setSearchBackend(current);
+}
+
+// Appends the timings of the perf mode. The calls are repeated for a few microseconds
+// and the best of the rounds is kept, so a short input is measured too.
+class PerfRecorder
+{
+private:
+    std::FILE* m_file = nullptr;
+
+    PerfRecorder()
+    {
+        if (const char* path = std::getenv("PATTERN_SEEKER_FUZZ_PERF"))
+            m_file = std::fopen(path, "a");
+    }
+
+public:
+    static PerfRecorder& instance()
+    {
+        static PerfRecorder recorder;
+        return recorder;
+    }
+
+    bool enabled() const
+    {
+        return m_file != nullptr;
+    }
+
+    template <typename Call>
+    void measure(const char* target, const char* engine, size_t bytes, Call&& call)
+    {
+        if (!m_file)
+            return;
+
+        using Clock = std::chrono::steady_clock;
+        constexpr int ROUNDS = 5;
+        constexpr auto ROUND_TIME = std::chrono::microseconds(20);
+        double best = 0;
+        for (int round = 0; round < ROUNDS; ++round)
+        {
+            size_t calls = 0;
+            const auto start = Clock::now();
+            auto now = start;
+            do
+            {
+                call();
+                ++calls;
+                now = Clock::now();
+            } while (now - start < ROUND_TIME);
+            const double ns = std::chrono::duration<double, std::nano>(now - start).count() / calls;
+            if (round == 0 || ns < best)
+                best = ns;
+        }
+        std::fprintf(m_file, "%s\t%s\t%zu\t%.4f\n", target, engine, bytes, best / std::max<size_t>(bytes, 1));
+        std::fflush(m_file);
+    }
+};
+
+}
+
+#endif
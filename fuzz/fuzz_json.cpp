@@ -0,0 +1,234 @@
+#include "fuzz_common.hpp"
+#include "../PatternSeekerCache.hpp"
+#include "../PatternSeekerUnchecked.hpp"
+
+// Differential target of getJsonProp(): the results of every search backend, of CachedSeeker and UncheckedSeeker
+// and of the schemas are compared with the scalar getJsonProp(), and the structural index with getJsonProp()
+// and with the Json paths where they are meant to agree.
+using namespace PatterSeekerNS;
+using namespace PatterSeekerNS::fuzz;
+
+namespace {
+
+constexpr const char* TARGET = "json";
+
+using Record = schema<field<"id", PatternSeeker>, field<"name", PatternSeeker>, field<"items", PatternSeeker>>;
+
+Outcome propOutcome(PatternSeeker ps, std::string_view name)
+{
+    return outcome(ps.getJsonProp(name), ps);
+}
+
+// A strict check of the Json grammar, without escapes in the strings
+class JsonValidator
+{
+private:
+    std::string_view m_text;
+    size_t m_pos = 0;
+    int m_depth = 0;
+
+    void skipSpaces()
+    {
+        while (m_pos < m_text.size() && std::string_view(" \t\r\n").find(m_text[m_pos]) != std::string_view::npos)
+            ++m_pos;
+    }
+
+    bool expect(char c)
+    {
+        skipSpaces();
+        if (m_pos == m_text.size() || m_text[m_pos] != c)
+            return false;
+        ++m_pos;
+        return true;
+    }
+
+    bool digits()
+    {
+        const size_t start = m_pos;
+        while (m_pos < m_text.size() && m_text[m_pos] >= '0' && m_text[m_pos] <= '9')
+            ++m_pos;
+        return m_pos != start;
+    }
+
+    bool string()
+    {
+        if (!expect('"'))
+            return false;
+        const size_t close = m_text.find('"', m_pos);
+        if (close == std::string_view::npos)
+            return false;
+        m_pos = close + 1;
+        return true;
+    }
+
+    bool number()
+    {
+        if (m_text[m_pos] == '-')
+            ++m_pos;
+        if (!digits())
+            return false;
+        if (m_pos < m_text.size() && m_text[m_pos] == '.' && (++m_pos, !digits()))
+            return false;
+        if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E'))
+        {
+            ++m_pos;
+            if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-'))
+                ++m_pos;
+            return digits();
+        }
+        return true;
+    }
+
+    bool value()
+    {
+        skipSpaces();
+        if (m_pos == m_text.size() || ++m_depth > 64)
+            return false;
+        bool valid = false;
+        const std::string_view rest = m_text.substr(m_pos);
+        if (rest[0] == '{')
+            valid = members('}', true);
+        else if (rest[0] == '[')
+            valid = members(']', false);
+        else if (rest[0] == '"')
+            valid = string();
+        else if (rest.starts_with("true") || rest.starts_with("null"))
+            valid = (m_pos += 4, true);
+        else if (rest.starts_with("false"))
+            valid = (m_pos += 5, true);
+        else
+            valid = number();
+        --m_depth;
+        return valid;
+    }
+
+    bool members(char close, bool object)
+    {
+        ++m_pos;
+        if (expect(close))
+            return true;
+        do
+        {
+            if (object && !(string() && expect(':')))
+                return false;
+            if (!value())
+                return false;
+        } while (expect(','));
+        return expect(close);
+    }
+
+public:
+    static bool valid(std::string_view text)
+    {
+        JsonValidator validator;
+        validator.m_text = text;
+        if (!validator.value())
+            return false;
+        validator.skipSpaces();
+        return validator.m_pos == text.size();
+    }
+};
+
+// getJsonProp() looks for the first `"name"` in the text, the index only at the names, quote-aware.
+// They find the same value in a valid document when the first `"name"` is a member name, that is a whole string
+// followed by a colon, and the value is read the same way: there are no escapes, the strings have no brackets inside,
+// and a scalar ends where getJsonProp() ends it.
+bool indexAgrees(std::string_view text, std::string_view name)
+{
+    if (name.find('"') != std::string_view::npos || text.find('\\') != std::string_view::npos)
+        return false;
+
+    bool inString = false;
+    for (const char c : text)
+    {
+        if (c == '"')
+            inString = !inString;
+        else if (inString && (c == '{' || c == '}' || c == '[' || c == ']'))
+            return false;
+        else if (!inString && (c == '\t' || c == '\v' || c == '\f'))
+            return false;
+    }
+
+    std::string quoted(1, '"');
+    quoted.append(name).push_back('"');
+    const size_t pos = text.find(quoted);
+    if (pos == std::string_view::npos || std::count(text.begin(), text.begin() + pos, '"') % 2 != 0)
+        return false;
+    PatternSeeker after(text.substr(pos + quoted.size()));
+    after.skipWhiteSpaces();
+    return after.startsWith(":");
+}
+
+void checkIndex(PatternSeeker ps, std::string_view text, std::string_view name)
+{
+    // the engines may read an invalid document in different ways
+    PatternSeeker::JsonIndex index;
+    if (!index.build(ps) || !JsonValidator::valid(text))
+        return;
+
+    if (indexAgrees(text, name))
+        check(TARGET, "JsonIndex::getJsonProp", propOutcome(ps, name), outcome(index.getJsonProp(name), ps));
+
+    // both the index and the paths look at the direct members only
+    if (name.find('"') != std::string_view::npos)
+        return;
+    const auto path = JsonPath::compile("$[\"" + std::string(name) + "\"]");
+    const auto expected = path.find(ps);
+    const auto member = index.root().getJsonProp(name).seeker();
+    check(TARGET, "JsonIndex::Value::getJsonProp", outcome(expected, ps), outcome(member, ps));
+}
+
+void checkSchema(PatternSeeker ps)
+{
+    auto copy = ps;
+    const auto [id, name, items] = copy.getJsonProps({ "id", "name", "items" });
+    const auto record = Record::parseJson(ps);
+    check(TARGET, "schema id", outcome(id, ps), record.has<"id">() ? outcome(record.get<"id">(), ps) : Outcome{ false, 0, 0, 0 });
+    check(TARGET, "schema name", outcome(name, ps), record.has<"name">() ? outcome(record.get<"name">(), ps) : Outcome{ false, 0, 0, 0 });
+    check(TARGET, "schema items", outcome(items, ps), record.has<"items">() ? outcome(record.get<"items">(), ps) : Outcome{ false, 0, 0, 0 });
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput input(data, size);
+    input.byte();
+    const std::string_view name = input.take(12);
+    const std::string text(input.rest());
+    const PatternSeeker ps(text);
+
+    Outcome reference;
+    forEachBackend([&](const char* backend) {
+        const Outcome result = propOutcome(ps, name);
+        if (std::string_view(backend) == "scalar")
+            reference = result;
+        check(TARGET, backend, reference, result);
+        checkSchema(ps);
+
+        PerfRecorder::instance().measure(TARGET, backend, text.size(), [&] {
+            auto copy = ps;
+            return found(copy.getJsonProp(name));
+        });
+    });
+
+    CachedSeeker cached(ps);
+    check(TARGET, "CachedSeeker", reference, outcome(cached.getJsonProp(name), ps));
+    check(TARGET, "CachedSeeker hit", reference, outcome(cached.getJsonProp(name), ps));
+
+    UncheckedSeeker unchecked(ps);
+    const auto value = unchecked.getJsonProp(name);
+    check(TARGET, "UncheckedSeeker", reference,
+        value.failed() ? Outcome{ false, 0, 0, 0 } : Outcome{ true, value.getOffset(), value.size(), 0 });
+
+    checkIndex(ps, text, name);
+
+    PerfRecorder::instance().measure(TARGET, "JsonIndex", text.size(), [&] {
+        const PatternSeeker::JsonIndex index(ps);
+        return found(index.getJsonProp(name));
+    });
+    PerfRecorder::instance().measure(TARGET, "schema", text.size(), [&] {
+        return Record::parseJson(ps).complete();
+    });
+    return 0;
+}
@@ -0,0 +1,158 @@
+// The driver of the fuzz targets for the compilers without libFuzzer.
+// `target file_or_dir...` runs the inputs of a corpus, `-runs=N [-seed=S] [-max_len=L]` runs N random inputs more:
+// mutations of the corpus inputs if there are any, otherwise strings of the bytes the parsers care about.
+// The flags have the same names as in libFuzzer. The input that fails a check is written to `crash-input`.
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#define PATTERN_SEEKER_FUZZ_POSIX
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+std::string readFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+const std::string* g_input = nullptr;
+
+// only the calls that are safe in a signal handler
+void saveInput(int signal)
+{
+#if defined(PATTERN_SEEKER_FUZZ_POSIX)
+    const int file = open("crash-input", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file >= 0 && g_input)
+    {
+        [[maybe_unused]] const auto written = write(file, g_input->data(), g_input->size());
+        close(file);
+    }
+#endif
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void run(const std::string& data)
+{
+    g_input = &data;
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+// mostly the structural bytes of Json and XML, some letters of the names and the other bytes rarely
+char randomByte(std::mt19937_64& rng)
+{
+    static constexpr std::string_view ALPHABET = "{}[]<>/=:;, \"'\\\r\n\tidaItemIDx!?-0123456789";
+    return rng() % 16 == 0 ? static_cast<char>(rng()) : ALPHABET[rng() % ALPHABET.size()];
+}
+
+// Replaces, inserts, erases or copies a few bytes
+void mutate(std::string& data, std::mt19937_64& rng, size_t maxSize)
+{
+    const size_t mutations = 1 + rng() % 4;
+    for (size_t i = 0; i < mutations; ++i)
+    {
+        const size_t pos = data.empty() ? 0 : rng() % data.size();
+        switch (rng() % 4)
+        {
+        case 0:
+            if (!data.empty())
+                data[pos] = randomByte(rng);
+            break;
+        case 1:
+            data.insert(data.begin() + pos, randomByte(rng));
+            break;
+        case 2:
+            if (!data.empty())
+                data.erase(pos, 1 + rng() % 8);
+            break;
+        default:
+            data.insert(pos, data.substr(rng() % (data.size() + 1), rng() % 16));
+            break;
+        }
+    }
+    if (data.size() > maxSize)
+        data.resize(maxSize);
+}
+
+void runRandom(const std::vector<std::string>& corpus, size_t runs, uint64_t seed, size_t maxSize)
+{
+    std::mt19937_64 rng(seed);
+    std::string data;
+    for (size_t i = 0; i < runs; ++i)
+    {
+        if (!corpus.empty())
+        {
+            data = corpus[rng() % corpus.size()];
+            mutate(data, rng, maxSize);
+            run(data);
+            continue;
+        }
+
+        data.resize(rng() % (maxSize + 1));
+        for (auto& c : data)
+            c = randomByte(rng);
+        // the first bytes are the choices and the pattern sizes, so they are kept small
+        for (size_t j = 0; j < std::min<size_t>(data.size(), 3); ++j)
+            data[j] = static_cast<char>(rng() % 8);
+        run(data);
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::signal(SIGABRT, saveInput);
+    size_t runs = 0;
+    uint64_t seed = 1;
+    size_t maxSize = 4096;
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("-runs="))
+            runs = std::strtoull(argv[i] + 6, nullptr, 10);
+        else if (arg.starts_with("-seed="))
+            seed = std::strtoull(argv[i] + 6, nullptr, 10);
+        else if (arg.starts_with("-max_len="))
+            maxSize = std::strtoull(argv[i] + 9, nullptr, 10);
+        else if (!arg.starts_with("-"))
+            inputs.emplace_back(arg);
+    }
+
+    std::vector<std::string> corpus;
+    for (const auto& input : inputs)
+    {
+        if (std::filesystem::is_directory(input))
+        {
+            for (const auto& entry : std::filesystem::directory_iterator(input))
+                if (entry.is_regular_file())
+                    corpus.push_back(readFile(entry.path()));
+        }
+        else
+        {
+            corpus.push_back(readFile(input));
+        }
+    }
+
+    for (const auto& data : corpus)
+        run(data);
+    runRandom(corpus, runs, seed, maxSize);
+    std::printf("Done: %zu inputs and %zu random runs\n", corpus.size(), runs);
+    return 0;
+}
@@ -0,0 +1,261 @@
+#include "fuzz_common.hpp"
+#include "../PatternSeekerCache.hpp"
+#include "../PatternSeekerUnchecked.hpp"
+#include "../PatternSeekerChain.hpp"
+
+#include <cctype>
+#include <vector>
+
+// Differential target of to() and extract(): the results of every search backend, of the compile-time patterns,
+// of UncheckedSeeker, CachedSeeker and SeekChain and of the case-insensitive search are compared
+// with the scalar backend, and the scalar backend with std::string_view::find.
+using namespace PatterSeekerNS;
+using namespace PatterSeekerNS::fuzz;
+
+namespace {
+
+constexpr const char* TARGET = "search";
+constexpr MoveMode MODES[] = { none, move_before, move_after };
+constexpr size_t OPERATIONS = 6;
+
+using Outcomes = std::array<Outcome, OPERATIONS * std::size(MODES)>;
+
+// The calls of PatternSeeker compared between the backends
+Outcomes searchOutcomes(PatternSeeker ps, std::string_view from, std::string_view to)
+{
+    Outcomes result;
+    size_t i = 0;
+    for (const auto mode : MODES)
+    {
+        auto copy = ps;
+        const bool moved = copy.to(from, mode);
+        result[i++] = outcome(moved, copy);
+        copy = ps;
+        result[i++] = outcome(copy.extract(from, to, mode), copy);
+        copy = ps;
+        result[i++] = outcome(copy.extract(to, mode), copy);
+        copy = ps;
+        const bool movedBack = copy.rto(from, mode);
+        result[i++] = outcome(movedBack, copy);
+        copy = ps;
+        result[i++] = outcome(copy.rextract(from, to, mode), copy);
+        copy = ps;
+        result[i++] = outcome(copy.extractUntilOneOf(to, mode), copy);
+    }
+    return result;
+}
+
+size_t moved(size_t before, size_t after, MoveMode mode)
+{
+    return mode == move_before ? before : mode == move_after ? after : 0;
+}
+
+// The meaning of to() and extract() written with std::string_view::find
+void checkReference(std::string_view data, std::string_view from, std::string_view to, const Outcomes& outcomes)
+{
+    constexpr size_t npos = std::string_view::npos;
+    for (size_t m = 0; m < std::size(MODES); ++m)
+    {
+        const MoveMode mode = MODES[m];
+        const Outcome* actual = &outcomes[m * OPERATIONS];
+
+        const size_t pos = data.find(from);
+        check(TARGET, "scalar to()", pos == npos ? Outcome{} : Outcome{ true, 0, 0, moved(pos, pos + from.size(), mode) }, actual[0]);
+
+        const size_t start = pos == npos ? npos : pos + from.size();
+        const size_t end = pos == npos ? npos : data.find(to, start);
+        check(TARGET, "scalar extract(from, to)",
+            end == npos ? Outcome{} : Outcome{ true, start, end - start, moved(pos, end + to.size(), mode) }, actual[1]);
+
+        const size_t before = data.find(to);
+        check(TARGET, "scalar extract(to)",
+            before == npos ? Outcome{} : Outcome{ true, 0, before, moved(before, before + to.size(), mode) }, actual[2]);
+
+        const size_t last = data.rfind(from);
+        check(TARGET, "scalar rto()", last == npos ? Outcome{} : Outcome{ true, 0, 0, moved(last, last + from.size(), mode) }, actual[3]);
+    }
+}
+
+std::string lower(std::string_view str)
+{
+    std::string result(str);
+    for (auto& c : result)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return result;
+}
+
+// The case-insensitive search is the search on the lower-cased copies
+void checkIgnoreCase(PatternSeeker ps, std::string_view data, std::string_view from, std::string_view to)
+{
+    const std::string lowerData = lower(data);
+    const std::string lowerFrom = lower(from);
+    const std::string lowerTo = lower(to);
+    const PatternSeeker lowered(lowerData);
+    for (const auto mode : MODES)
+    {
+        auto expected = lowered;
+        auto actual = ps;
+        const bool expectedMoved = expected.to(lowerFrom, mode);
+        const bool actualMoved = actual.to(ignore_case(from), mode);
+        check(TARGET, "to(ignore_case)", outcome(expectedMoved, expected), outcome(actualMoved, actual));
+
+        expected = lowered;
+        actual = ps;
+        const auto expectedBetween = outcome(expected.extract(lowerFrom, lowerTo, mode), expected);
+        check(TARGET, "extract(ignore_case, ignore_case)", expectedBetween,
+            outcome(actual.extract(ignore_case(from), ignore_case(to), mode), actual));
+
+        expected = lowered;
+        actual = ps;
+        const auto expectedBefore = outcome(expected.extract(lowerTo, mode), expected);
+        check(TARGET, "extract(ignore_case)", expectedBefore, outcome(actual.extract(ignore_case(to), mode), actual));
+    }
+}
+
+// The compile-time patterns are fixed, so they are checked with the same strings searched at run time
+template <FixedString From, FixedString To>
+void checkPatterns(PatternSeeker ps)
+{
+    constexpr auto from = pattern<From>::str;
+    constexpr auto to = pattern<To>::str;
+    for (const auto mode : MODES)
+    {
+        auto expected = ps;
+        auto actual = ps;
+        const bool expectedMoved = expected.to(from, mode);
+        const bool actualMoved = actual.to(pattern<From>{}, mode);
+        check(TARGET, "to(pattern)", outcome(expectedMoved, expected), outcome(actualMoved, actual));
+
+        expected = ps;
+        actual = ps;
+        const auto expectedBetween = outcome(expected.extract(from, to, mode), expected);
+        check(TARGET, "extract(pattern, pattern)", expectedBetween, outcome(actual.extract(pattern<From>{}, pattern<To>{}, mode), actual));
+    }
+}
+
+void checkUnchecked(PatternSeeker ps, std::string_view from, std::string_view to)
+{
+    const auto unchecked = [](const UncheckedSeeker& result, const UncheckedSeeker& cursor) {
+        if (result.failed())
+            return Outcome{ false, 0, 0, cursor.getOffset() };
+        return Outcome{ true, result.getOffset(), result.size(), cursor.getOffset() };
+    };
+
+    auto expected = ps;
+    UncheckedSeeker actual(ps);
+    const bool expectedMoved = expected.to(from, move_after);
+    const bool actualMoved = actual.to<move_after>(from);
+    check(TARGET, "UncheckedSeeker::to", outcome(expectedMoved, expected), Outcome{ actualMoved, 0, 0, actual.getOffset() });
+    if (!expectedMoved)
+        return;
+
+    const auto expectedBetween = outcome(expected.extract(from, to, move_after), expected);
+    const auto between = actual.extract<move_after>(from, to);
+    check(TARGET, "UncheckedSeeker::extract(from, to)", expectedBetween, unchecked(between, actual));
+    if (!expectedBetween.found)
+        return;
+
+    const auto expectedBefore = outcome(expected.extract(to, move_before), expected);
+    const auto before = actual.extract<move_before>(to);
+    check(TARGET, "UncheckedSeeker::extract(to)", expectedBefore, unchecked(before, actual));
+}
+
+void checkCached(PatternSeeker ps, std::string_view from, std::string_view to)
+{
+    CachedSeeker cached(ps);
+    // the second round is answered from the cache
+    for (int round = 0; round < 2; ++round)
+    {
+        cached.reset(ps);
+        auto expected = ps;
+        const bool expectedMoved = expected.to(from, move_before);
+        const bool actualMoved = cached.to(from, move_before);
+        check(TARGET, "CachedSeeker::to", outcome(expectedMoved, expected), outcome(actualMoved, cached.seeker()));
+
+        const auto expectedBetween = outcome(expected.extract(from, to, move_after), expected);
+        check(TARGET, "CachedSeeker::extract(from, to)", expectedBetween, outcome(cached.extract(from, to, move_after), cached.seeker()));
+
+        const auto expectedBefore = outcome(expected.extract(to, move_after), expected);
+        check(TARGET, "CachedSeeker::extract(to)", expectedBefore, outcome(cached.extract(to, move_after), cached.seeker()));
+    }
+}
+
+void checkChain(PatternSeeker ps, std::string_view from, std::string_view to)
+{
+    auto expected = ps;
+    PatternSeeker between{ std::string_view{} };
+    PatternSeeker before{ std::string_view{} };
+    const size_t expectedStep = !expected.to(from, move_after) ? 0
+        : !found(between = expected.extract(from, to, move_after)) ? 1
+        : !found(before = expected.extract(to, move_before)) ? 2 : SeekChain::NO_STEP;
+
+    PatternSeeker chainBetween{ std::string_view{} };
+    PatternSeeker chainBefore{ std::string_view{} };
+    SeekChain chain(ps);
+    chain.to(from, move_after).extract(from, to, chainBetween, move_after).extract(to, chainBefore, move_before);
+    check(TARGET, "SeekChain step", expectedStep, chain.failedStep());
+    check(TARGET, "SeekChain cursor", outcome(true, expected), outcome(true, chain.seeker()));
+    if (expectedStep == SeekChain::NO_STEP)
+    {
+        check(TARGET, "SeekChain extract(from, to)", outcome(between, between), outcome(chainBetween, chainBetween));
+        check(TARGET, "SeekChain extract(to)", outcome(before, before), outcome(chainBefore, chainBefore));
+    }
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput input(data, size);
+    const uint8_t choice = input.byte();
+    const std::string_view from = input.take(8);
+    const std::string_view to = input.take(8);
+    // a copy, so reading past the end of the data is caught by the sanitizers
+    const std::string text(input.rest());
+    const PatternSeeker ps(text);
+
+    Outcomes reference;
+    forEachBackend([&](const char* backend) {
+        const Outcomes outcomes = searchOutcomes(ps, from, to);
+        if (std::string_view(backend) == "scalar")
+        {
+            reference = outcomes;
+            checkReference(text, from, to, reference);
+        }
+        for (size_t i = 0; i < outcomes.size(); ++i)
+            check(TARGET, backend, reference[i], outcomes[i]);
+
+        checkIgnoreCase(ps, text, from, to);
+        switch (choice % 3)
+        {
+        case 0:
+            checkPatterns<"id=", ";">(ps);
+            break;
+        case 1:
+            checkPatterns<"\r\n", "\r\n\r\n">(ps);
+            break;
+        default:
+            checkPatterns<"<item>", "</item>">(ps);
+            break;
+        }
+
+        PerfRecorder::instance().measure(TARGET, backend, text.size(), [&] {
+            auto copy = ps;
+            return found(copy.extract(from, to, move_after));
+        });
+    });
+
+    checkUnchecked(ps, from, to);
+    checkCached(ps, from, to);
+    checkChain(ps, from, to);
+
+    PerfRecorder::instance().measure(TARGET, "string_view::find", text.size(), [&] {
+        const size_t pos = std::string_view(text).find(from);
+        return pos != std::string_view::npos && std::string_view(text).find(to, pos + from.size()) != std::string_view::npos;
+    });
+    PerfRecorder::instance().measure(TARGET, "UncheckedSeeker", text.size(), [&] {
+        UncheckedSeeker copy(ps);
+        return copy.extract<move_after>(from, to).ok();
+    });
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "fuzz_common.hpp"
+#include "../PatternSeekerCache.hpp"
+
+#include <algorithm>
+
+// Differential target of getXmlTag(): the results of every search backend, of CachedSeeker,
+// and of the case-insensitive names are compared with the scalar getXmlTag().
+using namespace PatterSeekerNS;
+using namespace PatterSeekerNS::fuzz;
+
+namespace {
+
+constexpr const char* TARGET = "xml";
+constexpr MoveMode MODES[] = { none, move_before, move_after };
+
+using Outcomes = std::array<Outcome, 2 * std::size(MODES) + 1>;
+
+Outcomes tagOutcomes(PatternSeeker ps, std::string_view name)
+{
+    Outcomes result;
+    size_t i = 0;
+    for (const auto mode : MODES)
+    {
+        auto copy = ps;
+        result[i++] = outcome(copy.getXmlTag(name, mode), copy);
+        copy = ps;
+        result[i++] = outcome(copy.getXmlTagBody(name, mode), copy);
+    }
+    result[i] = outcome(ps.getXmlAttr(name), ps);
+    return result;
+}
+
+constexpr std::string_view CDATA = "<![CDATA[";
+
+// The capitals of `CDATA` are the syntax, not a name
+bool hasUpper(std::string_view str)
+{
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        if (str.substr(i).starts_with(CDATA))
+            i += CDATA.size() - 1;
+        else if (str[i] >= 'A' && str[i] <= 'Z')
+            return true;
+    }
+    return false;
+}
+
+void lower(std::string& str)
+{
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        if (std::string_view(str).substr(i).starts_with(CDATA))
+            i += CDATA.size() - 1;
+        else if (str[i] >= 'A' && str[i] <= 'Z')
+            str[i] = static_cast<char>(str[i] + 32);
+    }
+}
+
+void checkIgnoreCase(PatternSeeker ps, std::string_view text, std::string_view name, const Outcomes& reference)
+{
+    // the names of a text without capitals match in either case the same way as they do exactly
+    if (hasUpper(text) || hasUpper(name))
+        return;
+    std::string upper(name);
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](char c) { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 32) : c; });
+    size_t i = 0;
+    for (const auto mode : MODES)
+    {
+        auto copy = ps;
+        check(TARGET, "getXmlTag(ignore_case)", reference[i++], outcome(copy.getXmlTag(ignore_case(upper), mode), copy));
+        copy = ps;
+        check(TARGET, "getXmlTagBody(ignore_case)", reference[i++], outcome(copy.getXmlTagBody(ignore_case(upper), mode), copy));
+    }
+}
+
+void checkCached(PatternSeeker ps, std::string_view name, const Outcomes& reference)
+{
+    CachedSeeker cached(ps);
+    // the second round is answered from the cache
+    for (int round = 0; round < 2; ++round)
+    {
+        size_t i = 0;
+        for (const auto mode : MODES)
+        {
+            cached.reset(ps);
+            check(TARGET, "CachedSeeker::getXmlTag", reference[i++], outcome(cached.getXmlTag(name, mode), cached.seeker()));
+            cached.reset(ps);
+            check(TARGET, "CachedSeeker::getXmlTagBody", reference[i++], outcome(cached.getXmlTagBody(name, mode), cached.seeker()));
+        }
+        cached.reset(ps);
+        check(TARGET, "CachedSeeker::getXmlAttr", reference[i], outcome(cached.getXmlAttr(name), ps));
+    }
+}
+
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    FuzzInput input(data, size);
+    const uint8_t choice = input.byte();
+    std::string name(input.take(12));
+    std::string text(input.rest());
+    // the case-insensitive names are compared only where there are no capitals, so they are removed from some inputs
+    if (choice % 2)
+    {
+        lower(name);
+        lower(text);
+    }
+    const PatternSeeker ps(text);
+
+    Outcomes reference;
+    forEachBackend([&](const char* backend) {
+        const Outcomes outcomes = tagOutcomes(ps, name);
+        if (std::string_view(backend) == "scalar")
+            reference = outcomes;
+        for (size_t i = 0; i < outcomes.size(); ++i)
+            check(TARGET, backend, reference[i], outcomes[i]);
+        checkIgnoreCase(ps, text, name, reference);
+
+        PerfRecorder::instance().measure(TARGET, backend, text.size(), [&] {
+            auto copy = ps;
+            return found(copy.getXmlTag(name));
+        });
+    });
+
+    checkCached(ps, name, reference);
+
+    return 0;
+}
@@ -1,8 +1,25 @@
 #include "../PatternSeeker.hpp"
+#include "../PatternSeekerStream.hpp"
+#include "../PatternSeekerMapped.hpp"
+#include "../PatternSeekerParallel.hpp"
+#include "../PatternSeekerBatch.hpp"
+#include "../PatternSeekerXml.hpp"
+#include "../PatternSeekerCache.hpp"
+#include "../PatternSeekerPipeline.hpp"
+#include "../PatternSeekerUnchecked.hpp"
+#include "../PatternSeekerChain.hpp"
 
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <fstream>
+#include <cstdio>
+#include <ranges>
+#include <vector>
+#include <memory_resource>
 
 using namespace PatterSeekerNS;
 
@@ -68,6 +85,324 @@ void test_extract() {
     std::cout << "  ✓ Extract passed" << std::endl;
 }
 
+void test_reverse_search() {
+    std::cout << "Testing reverse search..." << std::endl;
+    
+    PatternSeeker ps("a=1;b=2;a=3;crc=ff\n");
+    assert(ps.rto("a=", move_after));
+    assert(ps.to_string() == "3;crc=ff\n");
+    
+    PatternSeeker ps2("a=1;b=2;a=3;crc=ff\n");
+    assert(ps2.rextract("a=", ";").to_string() == "3");
+    assert(ps2.rextract("crc=", "\n", move_before).to_string() == "ff");
+    assert(ps2.to_string() == "crc=ff\n");
+    assert(!ps2.rto("b="));
+    assert(ps2.rextract("b=", ";").isEmpty());
+    assert(ps2.to_string() == "crc=ff\n");
+    
+    // `from` is searched before the last `to` only
+    PatternSeeker ps3("<a>1</a><a>2</a>tail");
+    assert(ps3.rextract("<a>", "</a>", move_after).to_string() == "2");
+    assert(ps3.to_string() == "tail");
+    
+    PatternSeeker ps4("path/to/file.txt");
+    auto name = ps4.rextract("/", move_before);
+    assert(name.to_string() == "file.txt");
+    assert(name.getOffset() == 8);
+    assert(ps4.to_string() == "/file.txt");
+    assert(ps4.rextract("/", move_after).to_string() == "file.txt");
+    assert(ps4.isEmpty());
+    
+    PatternSeeker line("GET /index.html HTTP/1.1 \r\n");
+    assert(line.endsWith("\r\n"));
+    assert(line.expectBack("\r\n"));
+    assert(!line.expectBack("\r\n"));
+    line.skipWhiteSpacesBack();
+    assert(line.endsWith("1.1"));
+    line.skipBack(size_t(9));
+    assert(line.to_string() == "GET /index.html");
+    
+    std::cout << "  ✓ Reverse search passed" << std::endl;
+}
+
+void test_unchecked_seeker() {
+    std::cout << "Testing unchecked seeker..." << std::endl;
+    
+    const std::string line = "ts=1700000000 host=web-3 path=/api/items?id=42 status=200 took=1.5ms";
+    UncheckedSeeker ps(line);
+    ps.to<move_after>("ts=");
+    const auto ts = ps.take<uint64_t>();
+    const auto host = ps.extract<move_after>("host=", " ");
+    const auto path = ps.extract<move_after>("path=", " ");
+    ps.expect("status=");
+    const auto status = ps.take<int>();
+    const auto took = ps.extract<move_after>(pattern<"took=">{}, pattern<"ms">{});
+    assert(ps.ok() && ps.isEmpty());
+    assert(ts == 1700000000 && status == 200);
+    assert(host.to_string() == "web-3" && host.ok());
+    assert(path.getOffset() == 30);
+    assert(took.to_string() == "1.5");
+    
+    // The same chain on a checked seeker gives the same views
+    PatternSeeker checked(line);
+    checked.to("host=", move_after);
+    auto checkedHost = checked.extract(" ", move_before);
+    assert(checkedHost.to_string_view().data() == host.to_string_view().data());
+    auto nested = UncheckedSeeker(checked);
+    assert(nested.getOffset() == checked.getOffset());
+    assert(nested.extract<move_after>("?id=", " ").take<uint64_t>() == 42);
+    assert(nested.seeker().startsWith("status="));
+    
+    // The first failure sticks, the pointer stays where it happened
+    UncheckedSeeker bad(line);
+    bad.to<move_after>("path=");
+    assert(!bad.to<move_after>("user="));
+    assert(bad.failed() && bad.getOffset() == 30);
+    auto missing = bad.extract<move_after>("status=", " ");
+    assert(missing.failed() && missing.isEmpty());
+    assert(bad.take<uint64_t>() == 0);
+    bad.skip(size_t(1000));
+    bad.skipWhiteSpaces();
+    assert(bad.getOffset() == 30);
+    assert(bad.seeker().isEmpty());
+    assert(bad.getJsonProp("id").failed());
+    bad.clearError();
+    assert(bad.extract<none>(size_t(4)).to_string() == "/api");
+    
+    UncheckedSeeker number("abc");
+    assert(number.take<double>() == 0.0 && number.failed());
+    
+    UncheckedSeeker json("{\"user\": {\"id\": 7}}");
+    assert(json.getJsonProp("user").getJsonProp("id").take<int>() == 7);
+    assert(json.ok());
+    
+    std::cout << "  ✓ Unchecked seeker passed" << std::endl;
+}
+
+void test_seek_chain() {
+    std::cout << "Testing seek chain..." << std::endl;
+    
+    const std::string line = "user=alice id=42 tags={\"a\": [1]} status=200";
+    PatternSeeker user{std::string_view{}}, tags{std::string_view{}};
+    uint64_t id = 0;
+    int status = 0;
+    SeekChain chain(PatternSeeker{line});
+    chain.to("user=", move_after).extract(" ", user, move_after)
+         .expect("id=").take(id).skipWhiteSpaces()
+         .to(pattern<"tags=">{}, move_after).extract('{', '}', tags, move_after)
+         .to("status=", move_after).take(status);
+    assert(chain.ok() && chain.failedStep() == SeekChain::NO_STEP);
+    assert(user.to_string() == "alice" && id == 42 && status == 200);
+    assert(tags.getJsonProp("a").to_string() == "[1]");
+    assert(chain.seeker().isEmpty());
+    
+    // The first failure stops the chain, the cursor and the offset are the ones before the failed step
+    PatternSeeker host{std::string_view{}};
+    bool customRun = false;
+    SeekChain bad(PatternSeeker{line});
+    bad.to("id=", move_after).take(id).expect(" status=").extract(" ", host)
+       .then([&](PatternSeeker&) { customRun = true; return true; });
+    assert(!bad && bad.failedStep() == 2 && bad.failedOffset() == 16);
+    assert(!customRun);
+    assert(bad.seeker().startsWith(" tags="));
+    assert(host.isEmpty());
+    
+    // A number that doesn't parse doesn't move the cursor either
+    SeekChain number(PatternSeeker{std::string_view("id=x1")});
+    number.expect("id=").take(id);
+    assert(number.failedStep() == 1 && number.failedOffset() == 3);
+    assert(number.seeker().to_string() == "x1");
+    
+    SeekChain shortSkip(PatternSeeker{std::string_view("abc")});
+    assert(!shortSkip.skip(size_t(2)).skip(size_t(2)) && shortSkip.failedOffset() == 2);
+    
+    PatternSeeker name{std::string_view{}}, attr{std::string_view{}};
+    SeekChain xml(PatternSeeker{std::string_view("{\"doc\": \"<a><b id=\\\"7\\\">x</b></a>\"}")});
+    xml.getJsonProp("doc", name).then([&](PatternSeeker& ps) { ps = name; return true; })
+       .getXmlTag("b", name).getXmlAttr("missing", attr);
+    assert(xml.failedStep() == 3 && attr.isEmpty());
+    
+    std::cout << "  ✓ Seek chain passed" << std::endl;
+}
+
+void test_ignore_case() {
+    std::cout << "Testing case-insensitive search..." << std::endl;
+    
+    const std::string request = "GET / HTTP/1.1\r\nHost: example.com\r\nCONTENT-TYPE: text/html\r\nx-id: 7\r\n\r\n";
+    PatternSeeker ps(request);
+    assert(!ps.to("content-type:"));
+    assert(ps.extract(ignore_case("Content-Type: "), ignore_case("\r\n")).to_string() == "text/html");
+    assert(ps.to(ignore_case("X-ID:"), move_after));
+    ps.skipWhiteSpaces();
+    assert(ps.takeUInt64(0) == 7);
+    
+    PatternSeeker line("Host: example.com");
+    assert(line.startsWith(ignore_case("HOST:")));
+    assert(!line.startsWith(ignore_case("HOST:x")));
+    assert(line.expect(ignore_case("host: ")));
+    assert(line.extract(ignore_case(".COM")).to_string() == "example");
+    assert(!line.expect(ignore_case("@")));
+    
+    // Only the ASCII letters fold
+    PatternSeeker symbols("[x] `a` {b}");
+    assert(!symbols.to(ignore_case("{X}")));
+    assert(!symbols.to(ignore_case("@A@")));
+    assert(symbols.to(ignore_case("`A`"), move_before) && symbols.getOffset() == 4);
+    
+    PatternSeeker xml("<Doc><ITEM id=\"1\"><item>x</item></Item><Items/></Doc>");
+    assert(xml.getXmlTag("item").to_string() == "<item>x</item>");
+    assert(xml.getXmlTag(ignore_case("Item")).to_string() == "<ITEM id=\"1\"><item>x</item></Item>");
+    assert(xml.getXmlTagBody(ignore_case("doc"), move_after).to_string().starts_with("<ITEM"));
+    assert(xml.isEmpty());
+    
+    std::cout << "  ✓ Case-insensitive search passed" << std::endl;
+}
+
+void test_fields() {
+    std::cout << "Testing delimiter-separated fields..." << std::endl;
+    
+    PatternSeeker pairs("a=1;b=22;;c=333;");
+    std::vector<std::string> names;
+    for (auto field : pairs.fields(";"))
+        names.push_back(field.to_string());
+    assert((names == std::vector<std::string>{ "a=1", "b=22", "", "c=333", "" }));
+    assert(std::ranges::distance(PatternSeeker("").fields(";")) == 1);
+    assert(pairs.column(1, ";").to_string() == "b=22");
+    assert(pairs.column(4, ";").isEmpty() && pairs.column(4, ";").getOffset() == 16);
+    assert(pairs.column(5, ";").isEmpty());
+    
+    std::string_view out[3];
+    assert(PatternSeeker("x\ty\tz\tw").splitInto(out, "\t") == 3 && out[2] == "z");
+    assert(PatternSeeker("x,y").splitInto(out, ",;") == 2 && out[0] == "x" && out[1] == "y");
+    
+    // Delimiters inside quotes don't split, doubled quotes stay as they are
+    PatternSeeker csv("1,\"a,b\",\"say \"\"hi, there\"\"\",x");
+    assert(csv.column(1, ",", true).to_string() == "a,b");
+    assert(csv.column(2, ",", true).to_string() == "say \"\"hi, there\"\"");
+    assert(csv.column(3, ",", true).to_string() == "x");
+    assert(csv.column(4, ",").to_string() == " there\"\"\"");
+    
+    // Compare with a naive split over the block boundaries, with more delims than the kernels take
+    std::mt19937 rng(13);
+    const std::string alphabet = "ab,;|\t\"";
+    for (int iteration = 0; iteration < 300; ++iteration)
+    {
+        std::string line(rng() % 300, 'a');
+        for (auto& c : line)
+            c = alphabet[rng() % alphabet.size()];
+        const bool quoted = iteration % 2;
+        const std::string_view delims = iteration % 3 == 0 ? ",;|\t!#$%&" : ",;";
+        
+        std::vector<std::string> expected(1);
+        bool inQuotes = false;
+        for (const char c : line)
+        {
+            inQuotes ^= quoted && c == '"';
+            if (!inQuotes && delims.find(c) != std::string_view::npos && !(quoted && c == '"'))
+                expected.emplace_back();
+            else
+                expected.back() += c;
+        }
+        for (auto& field : expected)
+            if (quoted && field.size() >= 2 && field.front() == '"' && field.back() == '"')
+                field = field.substr(1, field.size() - 2);
+        
+        PatternSeeker ps(line);
+        std::vector<std::string> actual;
+        for (auto field : ps.fields(delims, quoted))
+            actual.push_back(field.to_string());
+        assert(actual == expected);
+        
+        std::vector<std::string_view> split(expected.size() + 1);
+        assert(ps.splitInto(split, delims, quoted) == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            assert(split[i] == expected[i]);
+            assert(ps.column(i, delims, quoted).to_string() == expected[i]);
+        }
+        assert(ps.column(expected.size(), delims, quoted).isEmpty());
+    }
+    
+    std::cout << "  ✓ Delimiter-separated fields passed" << std::endl;
+}
+
+void test_utf8() {
+    std::cout << "Testing UTF-8 operations..." << std::endl;
+    
+    PatternSeeker text("Привет, мир! 😀 ok");
+    assert(text.isValidUtf8() && !text.isAscii());
+    assert(text.extractChars(6).to_string() == "Привет");
+    text.skipChars(8);
+    assert(text.extractChars(3, move_after).to_string() == "мир");
+    text.skipChars(2);
+    assert(text.extractChars(1).to_string() == "😀");
+    assert(text.extractChars(100).to_string() == "😀 ok");
+    text.skipChars(100);
+    assert(text.isEmpty());
+    
+    PatternSeeker ascii("plain text");
+    assert(!ascii.isMarkedAscii() && ascii.markAscii() && ascii.isMarkedAscii());
+    auto word = ascii.extractChars(5, move_after);
+    assert(word.to_string() == "plain" && word.isMarkedAscii() && ascii.isMarkedAscii());
+    assert(!PatternSeeker("é").markAscii());
+    
+    // Errors at every position of the SIMD blocks, for every backend
+    const std::pair<std::string, bool> cases[] = {
+        { "\xD0\x9F", true }, { "\xE2\x82\xAC", true }, { "\xF0\x9F\x98\x80", true }, { "\xF4\x8F\xBF\xBF", true },
+        { "\xEF\xBF\xBF", true }, { "\xC2\x80", true }, { "\xE0\xA0\x80", true }, { "\xF0\x90\x80\x80", true },
+        { "\x80", false }, { "\xBF", false }, { "\xC0\x80", false }, { "\xC1\xBF", false }, { "\xE0\x80\x80", false },
+        { "\xE0\x9F\xBF", false }, { "\xED\xA0\x80", false }, { "\xED\xBF\xBF", false }, { "\xF0\x80\x80\x80", false },
+        { "\xF0\x8F\xBF\xBF", false }, { "\xF4\x90\x80\x80", false }, { "\xF5\x80\x80\x80", false }, { "\xFF", false },
+        { "\xD0", false }, { "\xE2\x82", false }, { "\xF0\x9F\x98", false }, { "\xD0\x9F\x9F", false },
+        { "\xE2\x82\xAC\xAC", false }, { "\xD0 ", false }, { "\xF8\x88\x80\x80\x80", false },
+    };
+    const auto initial = activeSearchBackend();
+    std::mt19937 rng(17);
+    for (auto backend : { SearchBackend::scalar, SearchBackend::sse2, SearchBackend::avx2,
+                          SearchBackend::avx512, SearchBackend::neon }) {
+        if (!setSearchBackend(backend))
+            continue;
+        for (const auto& [piece, valid] : cases)
+            for (size_t pad = 0; pad < 70; ++pad)
+                for (const char* after : { "", "x", "\xD0\x9F" }) {
+                    std::string data(pad % 2, 'a');
+                    for (size_t i = 0; i < pad / 2; ++i)
+                        data += pad % 4 < 2 ? "ab" : "\xD1\x8F";
+                    data += piece + after;
+                    assert(PatternSeeker(data).isValidUtf8() == valid);
+                }
+        
+        // Random strings of code points with a byte changed sometimes, against the scalar kernel
+        for (int round = 0; round < 2000; ++round) {
+            std::string data;
+            const size_t count = rng() % 100;
+            for (size_t i = 0; i < count; ++i) {
+                const char* points[] = { "a", "\n", "\xD0\xB9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF" };
+                data += points[rng() % std::size(points)];
+            }
+            if (!data.empty() && rng() % 2)
+                data[rng() % data.size()] = static_cast<char>(rng());
+            assert(PatternSeeker(data).isValidUtf8() == detail::validateUtf8Scalar(data.data(), data.size()));
+            
+            // the code points are counted by their first bytes
+            size_t starts = 0;
+            const size_t n = rng() % (count + 2);
+            size_t expected = data.size();
+            for (size_t i = 1; i < data.size(); ++i)
+                if ((static_cast<uint8_t>(data[i]) & 0xC0) != 0x80 && ++starts == n) {
+                    expected = i;
+                    break;
+                }
+            PatternSeeker ps(data);
+            assert(ps.extractChars(n).size() == (n == 0 ? 0 : expected));
+            assert(ps.isAscii() == std::all_of(data.begin(), data.end(), [](char c) { return static_cast<uint8_t>(c) < 0x80; }));
+        }
+    }
+    setSearchBackend(initial);
+    
+    std::cout << "  ✓ UTF-8 operations passed" << std::endl;
+}
+
 void test_extract_brackets() {
     std::cout << "Testing extract with brackets..." << std::endl;
     
@@ -110,6 +445,61 @@ void test_take_int64() {
     std::cout << "  ✓ TakeInt64 passed" << std::endl;
 }
 
+void test_number_parsing() {
+    std::cout << "Testing number parsing..." << std::endl;
+    
+    // The visible part ends in the middle of the number, the parser must not read past it
+    std::string digits = "1234567890123456789";
+    PatternSeeker ps(std::string_view(digits).substr(0, 3));
+    assert(ps.takeUInt64() == 123u);
+    assert(ps.isEmpty());
+    
+    // 8 digits at a time and the scalar tail
+    PatternSeeker big("12345678901234567 18446744073709551615 18446744073709551616,");
+    assert(big.takeUInt64() == 12345678901234567ull);
+    assert(big.takeUInt64() == std::numeric_limits<uint64_t>::max());
+    assert(!big.takeUInt64().has_value());
+    assert(big.to_string() == ",");  // moved past the overflowing number
+    
+    PatternSeeker ints("-9223372036854775808 -9223372036854775809 +42 -");
+    assert(ints.takeInt64() == std::numeric_limits<int64_t>::min());
+    assert(!ints.takeInt64().has_value());
+    assert(ints.takeInt64() == 42);
+    assert(!ints.takeInt64().has_value());
+    assert(ints.to_string() == " -");  // a failure without digits doesn't move the pointer
+    
+    PatternSeeker neg("-5");
+    assert(!neg.takeUInt64().has_value());
+    assert(neg.takeUInt64(7) == 7u);
+    
+    PatternSeeker u32("4294967295 4294967296");
+    assert(u32.takeUInt32() == 4294967295u);
+    assert(!u32.takeUInt32().has_value());
+    
+    PatternSeeker floats("3.25 -1e-3 1e999 x");
+    assert(floats.takeDouble() == 3.25);
+    assert(floats.takeFloat() == -1e-3f);
+    assert(!floats.takeDouble().has_value());
+    assert(floats.takeDouble(0.5) == 0.5);
+    
+    PatternSeeker json(R"({"ratio": 0.75, "count": 300, "small": -12})");
+    assert(json.getJsonProp("ratio").takeDouble() == 0.75);
+    assert(json.getJsonProp("count").take<uint16_t>() == 300);
+    assert(!json.getJsonProp("count").take<uint8_t>().has_value());
+    assert(json.getJsonProp("small").take<int8_t>() == -12);
+    
+    std::mt19937_64 rng(11);
+    for (int i = 0; i < 10000; ++i) {
+        const uint64_t value = rng() >> (rng() % 64);
+        const std::string text = std::to_string(value) + "x";
+        PatternSeeker num(text);
+        assert(num.takeUInt64() == value);
+        assert(num.to_string() == "x");
+    }
+    
+    std::cout << "  ✓ Number parsing passed" << std::endl;
+}
+
 void test_skip_whitespaces() {
     std::cout << "Testing skipWhiteSpaces..." << std::endl;
     
@@ -117,9 +507,79 @@ void test_skip_whitespaces() {
     ps.skipWhiteSpaces();
     assert(ps.to_string() == "Hello");
     
+    // A deep indentation goes through the SIMD kernels
+    const std::string indented = std::string(1000, ' ') + "\r\n\v\f\t{}";
+    PatternSeeker deep(indented);
+    deep.skipWhiteSpaces();
+    assert(deep.to_string() == "{}");
+    PatternSeeker blank(std::string_view("  \n "));
+    blank.skipWhiteSpaces();
+    assert(blank.isEmpty());
+    
     std::cout << "  ✓ SkipWhiteSpaces passed" << std::endl;
 }
 
+void test_char_classes() {
+    std::cout << "Testing char classes..." << std::endl;
+    
+    constexpr auto hex = CharClass::digits() | CharClass("abcdefABCDEF");
+    static_assert(hex.contains('7') && hex.contains('F') && !hex.contains('g'));
+    static_assert(!(~hex).contains('a') && (~hex).contains('\0') && (~hex).contains('\xFF'));
+    static_assert(CharClass::identifier().contains('_') && !CharClass::spaces().contains('_'));
+    
+    PatternSeeker ps(std::string_view("user_42 = 0x1F;"));
+    auto name = ps.takeWhile(CharClass::identifier());
+    assert(name.to_string() == "user_42" && name.getOffset() == 0);
+    assert(ps.skipWhile(CharClass(" =")) == 3);
+    assert(ps.takeWhile(CharClass::digits()).to_string() == "0");
+    assert(ps.takeWhile(CharClass::digits()).isEmpty());
+    assert(ps.extractUntilOneOf(CharClass(";,"), move_after).to_string() == "x1F");
+    assert(ps.isEmpty());
+    
+    PatternSeeker csv(std::string_view("a;b,c"));
+    assert(csv.extractUntilOneOf(",;", move_after).to_string() == "a");
+    assert(csv.extractUntilOneOf(",", move_after).to_string() == "b");
+    assert(csv.extractUntilOneOf(",;").isEmpty());
+    assert(csv.to_string() == "c");
+    
+    // Every backend against std::string_view::find_first_of and find_first_not_of on random data,
+    // with bytes above 0x7F in both the data and the classes
+    std::mt19937 rng(5);
+    for (auto backend : { SearchBackend::scalar, SearchBackend::sse2, SearchBackend::avx2,
+                          SearchBackend::avx512, SearchBackend::neon }) {
+        if (!setSearchBackend(backend))
+            continue;
+        
+        for (int round = 0; round < 2000; ++round) {
+            std::string chars;
+            const size_t count = 1 + rng() % 12;
+            for (size_t i = 0; i < count; ++i)
+                chars += static_cast<char>(rng() % 2 ? "ab \t\x80\xFF"[rng() % 6] : rng() % 256);
+            const CharClass set(chars);
+            
+            std::string data;
+            const size_t size = rng() % 300;
+            for (size_t i = 0; i < size; ++i)
+                data += rng() % 8 ? chars[rng() % chars.size()] : static_cast<char>(rng() % 256);
+            
+            const size_t notIn = std::string_view(data).find_first_not_of(chars);
+            PatternSeeker skipped(data);
+            assert(skipped.skipWhile(set) == (notIn == std::string_view::npos ? data.size() : notIn));
+            
+            const size_t in = std::string_view(data).find_first_of(chars);
+            PatternSeeker extracted(data);
+            auto until = extracted.extractUntilOneOf(set);
+            if (in == std::string_view::npos)
+                assert(until.isEmpty());
+            else
+                assert(until.size() == in);
+        }
+    }
+    setSearchBackend(detail::bestSearchBackend());
+    
+    std::cout << "  ✓ Char classes passed" << std::endl;
+}
+
 void test_json() {
     std::cout << "Testing JSON operations..." << std::endl;
     
@@ -140,6 +600,865 @@ void test_json() {
     std::cout << "  ✓ JSON operations passed" << std::endl;
 }
 
+void test_json_strings() {
+    std::cout << "Testing Json strings..." << std::endl;
+    
+    // The value doesn't end at an escaped quote, but does after an escaped backslash
+    PatternSeeker ps(R"({"quote": "say \"hi\"", "path": "C:\\", "next": 1, "plain": "text"})");
+    auto quote = ps.getJsonProp("quote");
+    assert(quote.to_string() == R"(say \"hi\")");
+    assert(ps.getJsonProp("path").to_string() == R"(C:\\)");
+    assert(ps.getJsonProp("next").to_string() == "1");
+    
+    // No escapes, no copy: the view is the one of the document
+    char buffer[64];
+    auto plain = ps.getJsonProp("plain");
+    auto raw = plain.decodeJsonString(buffer);
+    assert(raw && *raw == "text" && raw->data() == plain.to_string_view().data());
+    
+    auto decoded = quote.decodeJsonString(buffer);
+    assert(decoded && *decoded == "say \"hi\"" && decoded->data() == buffer);
+    
+    PatternSeeker escapes(R"({"s": "a\/b\\c\n\t\b\f\r \u0041\u00e9\u20ac\ud83d\ude00"})");
+    decoded = escapes.getJsonProp("s").decodeJsonString(buffer);
+    assert(decoded && *decoded == "a/b\\c\n\t\b\f\r A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    
+    for (auto invalid : { R"(\x)", R"(\u12)", R"(\u12G4)", R"(\ud83d)", R"(\ud83dx\ude00)", R"(\ude00)", R"(a\)" })
+        assert(!PatternSeeker(std::string_view(invalid)).decodeJsonString(buffer));
+    
+    char small[4];
+    assert(!PatternSeeker(std::string_view(R"(a\nbcd)")).decodeJsonString(small));
+    
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+    auto fromArena = quote.decodeJsonString(arena);
+    assert(fromArena && *fromArena == "say \"hi\"");
+    
+    // Long strings with backslash runs across the 64-byte blocks
+    for (size_t run = 1; run < 6; ++run) {
+        std::string json = "{\"s\": \"" + std::string(60, 'x') + std::string(run, '\\') + "\"" + std::string(70, 'y') + "\", \"t\": 2}";
+        auto value = PatternSeeker(json).getJsonProp("s");
+        const size_t expected = run % 2 ? 60 + run + 1 + 70 : 60 + run;
+        assert(value.size() == expected);
+    }
+    
+    std::cout << "  ✓ Json strings passed" << std::endl;
+}
+
+void test_json_props() {
+    std::cout << "Testing getJsonProps..." << std::endl;
+    
+    PatternSeeker ps(R"({"type": "name", "id": 7, "text": "say \"id\": 1", "user": {"name": "Bob", "tags": [1, 2]}, "score": 0.5})");
+    auto [id, name, tags, score, missing, again] = ps.getJsonProps({"id", "name", "tags", "score", "missing", "id"});
+    assert(id.to_string() == "7");
+    assert(name.to_string() == "Bob");
+    assert(tags.to_string() == "[1, 2]");
+    assert(score.takeDouble() == 0.5);
+    assert(missing.isEmpty());
+    assert(again.to_string() == "7");
+    
+    // The same values as one getJsonProp per property
+    for (auto prop : { "type", "id", "user", "score" }) {
+        auto props = ps.getJsonProps({ std::string_view(prop) });
+        assert(props[0].to_string() == ps.getJsonProp(prop).to_string());
+        assert(props[0].getOffset() == ps.getJsonProp(prop).getOffset());
+    }
+    
+    // Unlike getJsonProp, a string value equal to the name isn't taken for it
+    assert(ps.getJsonProp("name").isEmpty() && name.to_string() == "Bob");
+    
+    std::cout << "  ✓ getJsonProps passed" << std::endl;
+}
+
+void test_json_index() {
+    std::cout << "Testing JsonIndex..." << std::endl;
+    
+    const std::string json = R"({"type": "name", "id": 7, "text": "say \"id\": {1}", "user": {"name": "Bob", "tags": [1, "two", {"x": 3}, []]}, "score": 0.5 , "empty": {}})";
+    PatternSeeker ps(json);
+    PatternSeeker::JsonIndex index(ps);
+    assert(!index.isEmpty());
+    
+    // The same values and offsets as getJsonProp
+    for (auto prop : { "type", "id", "user", "tags", "x", "score", "empty", "missing" }) {
+        auto expected = ps.getJsonProp(prop);
+        auto actual = index.getJsonProp(prop);
+        assert(actual.to_string() == expected.to_string());
+        assert(actual.isEmpty() || actual.getOffset() == expected.getOffset());
+    }
+    // escaped quotes don't end a string, and a string value with the same text isn't a name
+    assert(index.getJsonProp("text").to_string() == R"(say \"id\": {1})");
+    assert(index.getJsonProp("name").to_string() == "Bob");
+    
+    auto root = index.root();
+    assert(root.getJsonProp("type").seeker().to_string() == "name");
+    assert(root.getJsonProp("score").seeker().takeDouble() == 0.5);
+    // nested members aren't direct members
+    assert(root.getJsonProp("name").isEmpty());
+    assert(root.getJsonProp("missing").isEmpty());
+    auto tags = root.getJsonProp("user").getJsonProp("tags");
+    assert(tags.seeker().to_string() == R"([1, "two", {"x": 3}, []])");
+    assert(tags.at(0).seeker().takeUInt64() == 1);
+    assert(tags.at(1).seeker().to_string() == "two");
+    assert(tags.at(2).getJsonProp("x").seeker().to_string() == "3");
+    assert(tags.at(3).seeker().to_string() == "[]");
+    assert(tags.at(3).at(0).isEmpty());
+    assert(tags.at(4).isEmpty());
+    assert(root.getJsonProp("empty").seeker().to_string() == "{}");
+    assert(root.at(0).isEmpty());
+    assert(tags.getJsonProp("x").isEmpty());
+    
+    // Offsets are relative to the original pointer, even for a moved seeker
+    PatternSeeker moved(json);
+    moved.to("\"user\"", move_after);
+    PatternSeeker::JsonIndex nested(moved.extract('{', '}'));
+    assert(nested.getJsonProp("name").getOffset() == json.find("Bob"));
+    assert(nested.offsets().front() == json.find("{\"name\""));
+    
+    // The memory is reused by the next document
+    const auto* data = index.offsets().data();
+    assert(index.build(PatternSeeker(R"([{"a": 1}, {"a": 2}])")));
+    assert(index.offsets().data() == data);
+    assert(index.root().at(1).getJsonProp("a").seeker().to_string() == "2");
+    
+    // Broken documents leave the index empty
+    assert(!index.build(PatternSeeker(R"({"a": [1, 2})")));
+    assert(index.isEmpty());
+    assert(index.root().isEmpty());
+    assert(!index.build(PatternSeeker(R"({"a": "open})")));
+    assert(!index.build(PatternSeeker(R"({"a": 1}})")));
+    
+    // Documents longer than one block
+    std::string big = "{";
+    for (int i = 0; i < 200; ++i)
+        big += "\"k" + std::to_string(i) + "\": {\"v\": \"x\\\\\", \"n\": " + std::to_string(i) + "},";
+    big += "\"last\": true}";
+    PatternSeeker bigSeeker(big);
+    assert(index.build(bigSeeker));
+    assert(index.root().getJsonProp("k150").getJsonProp("n").seeker().to_string() == "150");
+    assert(index.root().getJsonProp("last").seeker().to_string() == "true");
+    assert(index.getJsonProp("k199").to_string() == bigSeeker.getJsonProp("k199").to_string());
+    
+    std::cout << "  ✓ JsonIndex passed" << std::endl;
+}
+
+struct SchemaUser {
+    uint64_t id;
+    std::string_view name;
+    double score;
+};
+
+void test_schema() {
+    std::cout << "Testing record schemas..." << std::endl;
+    
+    using User = schema<field<"id", uint64_t>, field<"name", std::string_view>, field<"score", double>>;
+    PatternSeeker json(std::string_view(R"({"name": "Ann", "meta": {"tag": "x"}, "id": 42, "score": -1.5})"));
+    const auto user = User::parseJson(json);
+    assert(user.complete() && user.found() == 0b111);
+    // as in getJsonProps, nested objects are searched and the first occurrence wins
+    assert(!User::parseJson(PatternSeeker(std::string_view(R"({"meta": {"id": "x"}, "id": 1})"))).has<"id">());
+    assert(user.get<"name">() == "Ann" && user.get<"score">() == -1.5);
+    const auto bound = user.as<SchemaUser>();
+    assert(bound.name == "Ann" && bound.score == -1.5);
+    
+    const auto partial = User::parseJson(PatternSeeker(std::string_view(R"({"id": 7, "title": "id", "name": ""})")));
+    assert(partial.has<"id">() && partial.get<"id">() == 7 && partial.has<"name">() && partial.get<"name">().empty());
+    assert(!partial.complete() && !partial.has<"score">() && partial.get<"score">() == 0.0);
+    
+    // The same values as getJsonProps for many fields, names that differ only in the middle included
+    using Wide = schema<field<"ts", std::string_view>, field<"host", std::string_view>, field<"level", PatternSeeker>,
+                        field<"status", uint32_t>, field<"bytes", uint64_t>, field<"latency_ms", double>,
+                        field<"delta", int64_t>, field<"ok", bool>, field<"request_id_a", std::string_view>,
+                        field<"request_id_b", std::string_view>, field<"a_long_name_for_the_region", std::string_view>>;
+    const std::string record = R"({"ts": "2024-05-01", "host": "web-1", "level": "info", "status": 200, "bytes": 5120,)"
+        R"( "latency_ms": 12.5, "delta": -3, "ok": true, "request_id_b": "b", "request_id_a": "a",)"
+        R"( "a_long_name_for_the_region": "eu", "extra": {"status": 500}})";
+    PatternSeeker ps(record);
+    const auto wide = Wide::parseJson(ps);
+    assert(wide.complete());
+    auto [ts, host, level, status, bytes] = ps.getJsonProps({ "ts", "host", "level", "status", "bytes" });
+    assert(wide.get<"ts">() == ts.to_string_view() && wide.get<"host">() == host.to_string_view());
+    assert(wide.get<"level">().to_string_view() == level.to_string_view());
+    auto levelValue = wide.get<"level">();
+    assert(levelValue.getOffset() == level.getOffset());
+    assert(wide.get<"status">() == status.takeUInt32() && wide.get<"bytes">() == bytes.takeUInt64());
+    assert(wide.get<"latency_ms">() == 12.5 && wide.get<"delta">() == -3 && wide.get<"ok">());
+    assert(wide.get<"request_id_a">() == "a" && wide.get<"request_id_b">() == "b");
+    assert(wide.get<"a_long_name_for_the_region">() == "eu");
+    
+    // A value of a wrong type leaves the field missing
+    assert(!Wide::parseJson(PatternSeeker(std::string_view(R"({"status": "busy", "ok": 1})"))).has<"status">());
+    assert(!Wide::parseJson(PatternSeeker(std::string_view(R"({"ok": 1})"))).has<"ok">());
+    assert(!Wide::parseJson(PatternSeeker(std::string_view(R"({"ok": trueish})"))).has<"ok">());
+    assert(!Wide::parseJson(PatternSeeker(std::string_view(R"({"ok": falsey})"))).has<"ok">());
+    const auto off = Wide::parseJson(PatternSeeker(std::string_view(R"({"ok": false })")));
+    assert(off.has<"ok">() && !off.get<"ok">());
+    
+    // XML attributes: only whole names match and both quotes work
+    PatternSeeker xml(std::string_view(R"(<root><user uid="9" id = "42" name='Ann' score="0.5"/><user id="1"/></root>)"));
+    xml.to("<user", move_before);
+    const auto attrs = User::parseXmlAttrs(xml);
+    assert(attrs.complete() && attrs.get<"id">() == 42 && attrs.get<"name">() == "Ann" && attrs.get<"score">() == 0.5);
+    const auto none = User::parseXmlAttrs(PatternSeeker(std::string_view("<user>text id=\"1\"</user>")));
+    assert(none.found() == 0);
+    assert(User::parseXmlAttrs(PatternSeeker(std::string_view("<a id=\"5\" broken><b name=\"x\"/>"))).found() == 1);
+    assert(User::parseJson(PatternSeeker(std::string_view{})).found() == 0);
+    assert(!User::parseXmlAttrs(PatternSeeker(std::string_view(R"(<a id=7><b name="z">)"))).has<"id">());
+    assert(User::parseXmlAttrs(PatternSeeker(std::string_view(R"(<a name="x" id=7><b id="8">)"))).found() == 0b10);
+    
+    std::cout << "  ✓ Record schemas passed" << std::endl;
+}
+
+void test_json_path() {
+    std::cout << "Testing Json paths..." << std::endl;
+    
+    // Decoys of the same names in a nested object and in strings come before the real ones
+    PatternSeeker doc(R"({"x": {"c": 0, "b": "\"c\": -1"}, "note": "\"a\": {\"b\": 5}",)"
+                      R"( "a": { "skip": [{"c": 1}, "]"], "b": [10, {"c": 2}, "s,]", {"c": 3, "d": [4, 5]}] }})");
+    
+    const auto path = JsonPath::compile("$.a.b[3].c");
+    assert(path && path.size() == 4);
+    auto value = path.find(doc);
+    assert(value.to_string() == "3");
+    assert(value.getOffset() == doc.to_string_view().find("3, \"d\""));
+    
+    assert(JsonPath::compile("$.a.b[2]").find(doc).to_string() == "s,]");
+    assert(JsonPath::compile("$['a'][\"b\"][3].d[1]").find(doc).to_string() == "5");
+    assert(JsonPath::compile("$.a.b[1]").find(doc).to_string() == R"({"c": 2})");
+    assert(JsonPath::compile("$.x.b").find(doc).to_string() == R"(\"c\": -1)");
+    assert(JsonPath::compile("$").find(PatternSeeker(std::string_view(" [1] "))).to_string() == "[1]");
+    
+    // The chained lookup finds the first "c" of the document instead
+    assert(doc.getJsonProp("a").getJsonProp("c").to_string() == "1");
+    
+    assert(JsonPath::compile("$.a.b[4]").find(doc).isEmpty());
+    assert(JsonPath::compile("$.a.missing").find(doc).isEmpty());
+    assert(JsonPath::compile("$.a[0]").find(doc).isEmpty());
+    assert(JsonPath::compile("$.x.c.deeper").find(doc).isEmpty());
+    assert(JsonPath::compile("$.a.b[0]").find(PatternSeeker(std::string_view("{\"a\": {\"b\": []}}"))).isEmpty());
+    
+    // A bracketed name with escaped quotes is the raw text of the key
+    PatternSeeker escaped(std::string_view(R"({"x\"y": 1, "z\\": {"q": 2}})"));
+    assert(JsonPath::compile(R"($["x\"y"])").find(escaped).to_string() == "1");
+    assert(JsonPath::compile(R"($["z\\"].q)").find(escaped).to_string() == "2");
+    
+    for (auto invalid : { "", "a.b", "$.", "$..a", "$[", "$[x]", "$[1", "$['a", "$.a[99999999999999999999]" })
+        assert(!JsonPath::compile(invalid) && JsonPath::compile(invalid).find(doc).isEmpty());
+    
+    std::cout << "  ✓ Json paths passed" << std::endl;
+}
+
+// Counts what goes upstream of an arena
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t live = 0;
+    
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        ++live;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        --live;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+void test_arena() {
+    std::cout << "Testing arena..." << std::endl;
+    
+    CountingResource upstream;
+    {
+        Arena arena(256, &upstream);
+        auto* a = static_cast<char*>(arena.allocate(10, 1));
+        auto* b = arena.allocate(8, 64);
+        assert(reinterpret_cast<uintptr_t>(b) % 64 == 0 && static_cast<char*>(b) > a);
+        assert(arena.allocate(10000, 8));
+        assert(upstream.allocations == 2 && upstream.live == 2);
+        
+        // The largest chunk is kept, so the next requests don't go upstream
+        for (int request = 0; request < 10; ++request) {
+            arena.reset();
+            assert(arena.allocate(5000, 8));
+            assert(arena.allocate(3000, 8));
+        }
+        assert(upstream.allocations == 2 && upstream.live == 1);
+    }
+    assert(upstream.live == 0);
+    
+    // A buffer on the stack is used first
+    alignas(std::max_align_t) std::byte stack[128];
+    Arena onStack(stack, sizeof(stack), &upstream);
+    assert(onStack.allocate(100, 1) == stack);
+    assert(onStack.allocate(100, 1));
+    assert(upstream.allocations == 3);
+    onStack.reset();
+    assert(onStack.allocate(100, 1) == stack);
+    assert(onStack.allocate(100, 1));
+    assert(upstream.allocations == 3);
+    
+    // Nothing of the owned data goes to the default resource when an arena is given
+    const std::string json = R"({"user": {"name": "Bob", "tags": ["a", "b\n"]}, "level": "warn"})";
+    Arena arena(1024, &upstream);
+    auto* previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    {
+        PatternSeeker::JsonIndex index(PatternSeeker(json), &arena);
+        assert(index.getJsonProp("name").to_string_view() == "Bob");
+        const auto path = JsonPath::compile("$.user.tags[1]", &arena);
+        auto tag = path.find(PatternSeeker(json));
+        assert(tag.decodeJsonString(arena).value() == "b\n");
+        const MultiPattern levels({ "error", "warn" }, &arena);
+        assert(PatternSeeker(json).toAnyOf(levels).index == 1);
+        assert(PatternSeeker(json).toAnyOf({ "fatal", "warn" }).index == 1);
+        StreamSeeker stream(64, &arena);
+        stream.append(json);
+        assert(stream.getXmlTag("none").status == StreamStatus::need_more_data);
+    }
+    std::pmr::set_default_resource(previous);
+    
+    std::cout << "  ✓ Arena passed" << std::endl;
+}
+
+void test_stream_seeker() {
+    std::cout << "Testing StreamSeeker..." << std::endl;
+    
+    const std::string data = "HTTP/1.1 200 OK\r\nContent-Length: 17\r\n\r\n<msg><id>42</id><text>hello</text></msg>tail";
+    
+    // Every split of the data into two chunks gives the same results
+    for (size_t split = 0; split <= data.size(); ++split) {
+        StreamSeeker stream(8);
+        stream.append(std::string_view(data).substr(0, split));
+        
+        auto drive = [&](auto&& search) {
+            auto result = search();
+            if (result.status == StreamStatus::need_more_data) {
+                stream.append(std::string_view(data).substr(split));
+                stream.finish();
+                result = search();
+            }
+            return result;
+        };
+        
+        auto length = drive([&] { return stream.extract("Content-Length: ", "\r\n", move_after); });
+        assert(length.status == StreamStatus::found);
+        assert(length.value.takeUInt64() == 17);
+        
+        auto id = drive([&] { return stream.getXmlTag("id", move_after); });
+        assert(id.value.to_string() == "<id>42</id>");
+        assert(id.value.getOffset() == data.find("<id>"));
+        
+        auto text = drive([&] { return stream.extract("</msg>", move_after); });
+        assert(text.value.to_string() == "<text>hello</text>");
+        if (!stream.isFinished())
+            stream.append(std::string_view(data).substr(split));
+        assert(stream.seeker().to_string() == "tail");
+    }
+    
+    // Byte by byte: the search waits for the whole pattern and resumes
+    StreamSeeker stream;
+    const std::string record = "noise ... END_OF_RECORD rest";
+    size_t fed = 0;
+    while (stream.to("END_OF_RECORD", move_after) == StreamStatus::need_more_data)
+        stream.append(std::string_view(record).substr(fed++, 1));
+    assert(fed == record.find("END_OF_RECORD") + 13);
+    assert(stream.getOffset() == fed);
+    
+    // commit forgets the parsed data and keeps the rest
+    stream.commit();
+    assert(stream.getOffset() == 0);
+    assert(stream.getStreamPosition() == fed);
+    stream.append(std::string_view(record).substr(fed));
+    assert(stream.seeker().to_string() == " rest");
+    
+    // Without more data a missing pattern is reported as such
+    assert(stream.extract("[", "]").status == StreamStatus::need_more_data);
+    stream.finish();
+    assert(stream.extract("[", "]").status == StreamStatus::not_found);
+    assert(!stream.getXmlTag("id"));
+    
+    // A tag split byte by byte: the name must be whole and the nested tags closed
+    StreamSeeker tags;
+    const std::string xml = "<names>x</names><name><name>in</name></name>";
+    fed = 0;
+    while (tags.getXmlTag("name").status == StreamStatus::need_more_data)
+        tags.append(std::string_view(xml).substr(fed++, 1));
+    assert(fed == xml.size());
+    assert(tags.getXmlTag("name", move_after).value.to_string() == "<name><name>in</name></name>");
+    tags.finish();
+    assert(tags.getXmlTag("name").status == StreamStatus::not_found);
+    
+    // A nested element byte by byte: the depth is kept between the attempts, a cut tag is counted once whole
+    std::string deep = "<list><item a=\"x>\"><item/><items>no</items><item>1</item>\n</item ><item>2</item></list>";
+    for (int i = 0; i < 50; ++i)
+        deep.insert(deep.find("</item >"), "<item><item k='</item>'/></item>");
+    PatternSeeker whole(deep);
+    StreamSeeker nested;
+    fed = 0;
+    StreamResult first;
+    while ((first = nested.getXmlTag("item", move_after)).status == StreamStatus::need_more_data)
+        nested.append(std::string_view(deep).substr(fed++, 1));
+    assert(first.value.to_string_view() == whole.getXmlTag("item").to_string_view());
+    assert(fed == first.value.getOffset() + first.value.size());
+    while ((first = nested.getXmlTag("item")).status == StreamStatus::need_more_data)
+        nested.append(std::string_view(deep).substr(fed++, 1));
+    assert(first.value.to_string() == "<item>2</item>");
+    
+    // Records of a stream are parsed and committed one by one through a small buffer
+    StreamSeeker records(16);
+    const std::string lines = "{\"n\": 1}\n{\"n\": 22}\n{\"n\": 333}\n";
+    uint64_t sum = 0;
+    for (size_t i = 0; i < lines.size(); i += 5) {
+        records.append(std::string_view(lines).substr(i, 5));
+        while (auto line = records.extract("\n", move_after)) {
+            sum += line.value.getJsonProp("n").takeUInt64(0);
+            records.commit();
+        }
+    }
+    assert(sum == 356);
+    assert(records.size() == 0);
+    
+    std::cout << "  ✓ StreamSeeker passed" << std::endl;
+}
+
+void test_mapped_seeker() {
+    std::cout << "Testing MappedPatternSeeker..." << std::endl;
+    
+    const std::string path = "pattern_seeker_mapped_test.ndjson";
+    const std::string data = "{\"id\": 1, \"text\": \"a}b\"}\n\n{\"id\": 22}\n{\"id\": 333}";
+    std::ofstream(path, std::ios::binary) << data;
+    
+    {
+        MappedPatternSeeker file(path, advice_sequential | advice_huge_pages);
+        assert(file.isOpen());
+        assert(file.size() == data.size());
+        assert(file.seeker().to_string() == data);
+        static_assert(std::ranges::input_range<RecordRange>);
+        
+        // One record per line, the empty line is skipped
+        std::vector<std::string> ids;
+        std::vector<size_t> offsets;
+        for (auto record : file.records()) {
+            ids.push_back(record.getJsonProp("id").to_string());
+            offsets.push_back(record.getOffset());
+        }
+        assert((ids == std::vector<std::string>{ "1", "22", "333" }));
+        assert((offsets == std::vector<size_t>{ 0, data.find("{\"id\": 22"), data.find("{\"id\": 333") }));
+        
+        // The same records framed by the brackets, the one in the string doesn't end a record
+        size_t count = 0;
+        for (auto record : file.records('{', '}')) {
+            assert(record.startsWith("{") && record.to_string().back() == '}');
+            ++count;
+        }
+        assert(count == 3);
+        
+        MappedPatternSeeker moved = std::move(file);
+        assert(moved.isOpen() && !file.isOpen());
+        assert(moved.seeker().getJsonProp("id").to_string() == "1");
+    }
+    
+    // An empty file is an empty document, a missing one isn't open
+    std::ofstream(path, std::ios::binary | std::ios::trunc);
+    MappedPatternSeeker empty(path);
+    assert(empty.isOpen() && empty.size() == 0 && empty.seeker().isEmpty());
+    assert(empty.records().begin() == empty.records().end());
+    std::remove(path.c_str());
+    assert(!MappedPatternSeeker(path).isOpen());
+    
+    std::cout << "  ✓ MappedPatternSeeker passed" << std::endl;
+}
+
+void test_parallel_records() {
+    std::cout << "Testing parallel_for_each_record..." << std::endl;
+    
+    // Enough records for several chunks
+    std::string lines;
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < 20000; ++i) {
+        lines += "{\"id\": " + std::to_string(i) + ", \"text\": \"{x}\"}\n";
+        expected += i;
+    }
+    
+    for (size_t threads : { 1, 4 }) {
+        ThreadPool pool(threads);
+        assert(pool.size() == threads);
+        
+        PerThread<uint64_t> sums(pool);
+        PerThread<size_t> counts(pool);
+        parallel_for_each_record(PatternSeeker(lines), '\n', [&](PatternSeeker record, size_t worker) {
+            sums.local(worker) += record.getJsonProp("id").takeUInt64(0);
+            ++counts.local(worker);
+        }, pool);
+        assert(sums.merge(0, std::plus<>{}) == expected);
+        assert(counts.merge(0, std::plus<>{}) == 20000);
+        
+        // Framed by the brackets, the ones inside the strings are ignored
+        PerThread<uint64_t> framed(pool);
+        parallel_for_each_record(PatternSeeker(lines), '{', '}', [&](PatternSeeker record, size_t worker) {
+            assert(record.startsWith("{\"id\""));
+            assert(lines.compare(record.getOffset(), record.size(), record.to_string_view()) == 0);
+            framed.local(worker) += record.getJsonProp("id").takeUInt64(0);
+        }, pool);
+        assert(framed.merge(0, std::plus<>{}) == expected);
+        
+        // An exception of the callback reaches the caller
+        bool thrown = false;
+        try {
+            parallel_for_each_record(PatternSeeker(lines), '\n', [](PatternSeeker record) {
+                if (record.getJsonProp("id").to_string() == "12345")
+                    throw std::runtime_error("bad record");
+            }, pool);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        
+        // A nested call on the same pool runs in place on the worker of its caller
+        PerThread<size_t> nested(pool);
+        pool.run(6, [&](size_t, size_t worker) {
+            parallel_for_each_record(PatternSeeker(lines), '\n', [&](PatternSeeker, size_t inner) {
+                assert(inner == worker);
+                ++nested.local(inner);
+            }, pool);
+        });
+        assert(nested.merge(0, std::plus<>{}) == 6 * 20000);
+    }
+    
+#if defined(PATTERN_SEEKER_WITH_EXECUTION)
+    // Execution policy overload
+    std::atomic<uint64_t> sum{0};
+    parallel_for_each_record(std::execution::par, PatternSeeker(lines), '\n', [&](PatternSeeker record) {
+        sum += record.getJsonProp("id").takeUInt64(0);
+    });
+    assert(sum == expected);
+#endif
+    
+    std::cout << "  ✓ parallel_for_each_record passed" << std::endl;
+}
+
+void test_pipeline() {
+    std::cout << "Testing pipeline..." << std::endl;
+    
+    // The buffer lives while any of its views does
+    SharedSeeker message;
+    {
+        std::string received = "{\"id\": 7, \"user\": \"alice\"}";
+        auto buffer = SharedBuffer::copy(received);
+        assert(buffer.useCount() == 1);
+        message = SharedSeeker(buffer);
+        assert(buffer.useCount() == 2);
+        received.assign(received.size(), 'x');
+    }
+    assert(message.buffer().useCount() == 1);
+    assert(message->getJsonProp("user").to_string() == "alice");
+    
+    auto adopted = SharedBuffer::adopt(std::string("a\nbb\nccc\n"));
+    RecordBatch batch(adopted);
+    for (auto rest = adopted.seeker(); rest.isNotEmpty();)
+        assert(batch.add(rest.extract("\n", move_after)));
+    assert(batch.size() == 3 && !batch.full());
+    assert(batch[2].to_string() == "ccc" && batch[2].getOffset() == 5);
+    assert(adopted.useCount() == 2);
+    
+    auto moved = std::move(batch);
+    assert(batch.empty() && moved.size() == 3);
+    size_t total = 0;
+    moved.forEach([&](PatternSeeker record) { total += record.size(); });
+    assert(total == 6);
+    moved.reset();
+    assert(adopted.useCount() == 1);
+    
+    auto filled = SharedBuffer::allocate(16);
+    std::memcpy(filled.writableData(), "id=42", 5);
+    filled.shrink(5);
+    assert(filled.seeker().to_string() == "id=42");
+    
+    // Wrapping around the ring, one at a time and in batches
+    SpscRing<int> ring(5);
+    assert(ring.capacity() == 8);
+    int next = 0, expectedNext = 0;
+    for (int round = 0; round < 100; ++round) {
+        int values[5] = { next, next + 1, next + 2, next + 3, next + 4 };
+        const size_t pushed = ring.tryPush(std::span<int>(values, 1 + round % 5));
+        next += static_cast<int>(pushed);
+        while (ring.tryPush(int(next)))
+            ++next;
+        assert(!ring.tryPush(int(next)));
+        
+        int out[3];
+        const size_t popped = ring.tryPop(std::span<int>(out, 1 + round % 3));
+        for (size_t i = 0; i < popped; ++i)
+            assert(out[i] == expectedNext++);
+        for (int value; expectedNext + 2 < next && ring.tryPop(value);)
+            assert(value == expectedNext++);
+    }
+    
+    // One producer splits the buffers into batches, one consumer parses them
+    constexpr size_t BUFFERS = 200;
+    constexpr size_t LINES = 100;
+    SpscRing<RecordBatch> batches(16);
+    uint64_t sum = 0, expectedSum = 0;
+    std::thread consumer([&] {
+        for (RecordBatch records; batches.pop(records);)
+            records.forEach([&](PatternSeeker record) { sum += record.getJsonProp("id").takeUInt64(0); });
+    });
+    for (size_t b = 0; b < BUFFERS; ++b) {
+        std::string lines;
+        for (size_t i = 0; i < LINES; ++i) {
+            lines += "{\"id\": " + std::to_string(b * LINES + i) + "}\n";
+            expectedSum += b * LINES + i;
+        }
+        auto buffer = SharedBuffer::adopt(std::move(lines));
+        RecordBatch records(buffer);
+        for (auto rest = buffer.seeker(); rest.isNotEmpty();) {
+            const auto line = rest.extract("\n", move_after);
+            if (!records.add(line)) {
+                batches.push(std::move(records));
+                records.reset(buffer);
+                records.add(line);
+            }
+        }
+        batches.push(std::move(records));
+    }
+    batches.close();
+    consumer.join();
+    assert(sum == expectedSum);
+    
+    // Several producers and consumers, every value arrives once
+    constexpr size_t PRODUCERS = 3;
+    constexpr size_t CONSUMERS = 3;
+    constexpr uint64_t VALUES = 20000;
+    MpmcRing<SharedSeeker> shared(64, PRODUCERS);
+    std::atomic<uint64_t> sharedSum{0};
+    std::atomic<uint64_t> sharedCount{0};
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < CONSUMERS; ++c) {
+        threads.emplace_back([&] {
+            for (SharedSeeker value; shared.pop(value);) {
+                sharedSum += value->takeUInt64(0);
+                ++sharedCount;
+            }
+        });
+    }
+    for (size_t p = 0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&, p] {
+            for (uint64_t i = p; i < VALUES; i += PRODUCERS)
+                shared.push(SharedSeeker(SharedBuffer::copy(std::to_string(i))));
+            shared.close();
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    assert(sharedCount == VALUES);
+    assert(sharedSum == VALUES * (VALUES - 1) / 2);
+    SharedSeeker left;
+    assert(!shared.tryPop(left));
+    
+    std::cout << "  ✓ Pipeline passed" << std::endl;
+}
+
+void test_stats() {
+    std::cout << "Testing operation stats..." << std::endl;
+    
+#if defined(PATTERN_SEEKER_WITH_STATS)
+    const StatsSnapshot before = statsSnapshot();
+    
+    PatternSeeker ps(std::string_view(R"({"id": 42, "name": "x"} <a>1</a> tail)"));
+    assert(ps.getJsonProp("id").takeUInt64(0) == 42);
+    assert(ps.getJsonProp("missing").isEmpty());
+    assert(ps.to("tail"));
+    assert(!ps.to("nothing"));
+    assert(ps.getXmlTagBody("a").to_string() == "1");
+    assert(PatternSeeker(std::string_view("key=value;")).extract("=", ";").to_string() == "value");
+    // the searches inside getXmlAttr are a part of it, not calls of their own
+    assert(PatternSeeker(std::string_view("<b id=\"7\"/>")).getXmlAttr("id").to_string() == "7");
+    
+    // The other threads are counted too, also after they finish
+    std::thread([] { PatternSeeker(std::string_view("abc")).to("c"); }).join();
+    
+    const StatsSnapshot stats = statsSnapshot() - before;
+    const auto& to = stats[StatsOperation::to];
+    assert(to.calls == 3 && to.failures == 1);
+    // "tail" ends at 36 and the miss scans all 38 bytes, "c" ends at 3
+    assert(to.scannedBytes == 36 + 38 + 3);
+    assert(stats[StatsOperation::json_prop].calls == 2 && stats[StatsOperation::json_prop].failures == 1);
+    assert(stats[StatsOperation::take_number].calls == 1 && stats[StatsOperation::take_number].failures == 0);
+    assert(stats[StatsOperation::xml_tag].calls == 1);
+    assert(stats[StatsOperation::xml_attr].calls == 1 && stats[StatsOperation::xml_attr].scannedBytes == 9);
+    assert(stats[StatsOperation::extract].calls == 1 && stats[StatsOperation::extract].scannedBytes == 10);
+    assert(stats[StatsOperation::to_any_of].calls == 0);
+    // the first call of a thread is always timed
+    assert(to.timedCalls >= 1 && to.timedCalls <= to.calls && to.seconds() > 0);
+    
+    const std::string text = prometheusText(stats);
+    assert(text.find("# TYPE pattern_seeker_calls_total counter\n") != std::string::npos);
+    assert(text.find("pattern_seeker_calls_total{operation=\"to\"} 3\n") != std::string::npos);
+    assert(text.find("pattern_seeker_failures_total{operation=\"json_prop\"} 1\n") != std::string::npos);
+    assert(text.find("pattern_seeker_timed_seconds_total{operation=\"to\"} ") != std::string::npos);
+    assert(text.find("# TYPE pattern_seeker_timed_calls_total counter\n") != std::string::npos);
+    assert(text.find("# TYPE pattern_seeker_estimated_seconds gauge\n") != std::string::npos);
+#endif
+    
+    std::cout << "  ✓ Operation stats passed" << std::endl;
+}
+
+void test_cached_seeker() {
+    std::cout << "Testing CachedSeeker..." << std::endl;
+    
+    const std::string message = R"({"type": "order", "id": 7, "items": [1, 2]} <route id="eu" zone="b"><hop>a</hop><hop/></route>)";
+    const PatternSeeker ps(message);
+    CachedSeeker cached(ps);
+    
+    // Every rule starts from the beginning of the message and gets the same results as without the cache
+    for (int rule = 0; rule < 5; ++rule) {
+        cached.reset(ps);
+        PatternSeeker plain = ps;
+        assert(cached.getJsonProp("type").to_string() == "order");
+        assert(cached.getJsonProp("id").getOffset() == PatternSeeker(plain).getJsonProp("id").getOffset());
+        assert(cached.getJsonProp("missing").isEmpty());
+        assert(cached.getXmlAttr("zone").to_string() == "b");
+        assert(cached.getXmlTagBody("hop").to_string() == "a");
+        assert(cached.extract("[", "]").to_string() == "1, 2");
+        
+        assert(cached.to("<route", move_after) && plain.to("<route", move_after));
+        assert(cached.seeker().to_string_view() == plain.to_string_view());
+        assert(!cached.to("<none>", move_after));
+        assert(cached.extract(">", move_after).to_string() == plain.extract(">", move_after).to_string());
+        auto tag = cached.getXmlTag("hop", move_after);
+        assert(tag.to_string() == plain.getXmlTag("hop", move_after).to_string());
+        assert(tag.getOffset() == 68);
+        assert(cached.getXmlTag("hop", move_before).to_string() == "<hop/>");
+        plain.getXmlTag("hop", move_before);
+        assert(cached.seeker().to_string_view() == plain.to_string_view());
+        assert(cached.extract("<", "/>", move_after).to_string() == "hop");
+        assert(cached.seeker().to_string() == "</route>");
+    }
+    assert(cached.misses() == 12);
+    assert(cached.hits() == 4 * 12);
+    
+    // The same lookup on a shorter view is another key
+    cached.reset(ps.to_string_view().substr(0, 20));
+    assert(cached.getJsonProp("id").isEmpty());
+    assert(cached.misses() == 13);
+    
+    // A view of another buffer clears the cache
+    const std::string other = R"({"type": "refund"})";
+    cached.reset(PatternSeeker(other));
+    assert(cached.getJsonProp("type").to_string() == "refund");
+    assert(cached.misses() == 14);
+    cached.clear();
+    assert(cached.getJsonProp("type").to_string() == "refund");
+    assert(cached.misses() == 15);
+    
+    // Long patterns and more keys than slots are still right
+    const std::string longName(40, 'x');
+    const std::string big = "{\"" + longName + "\": 1, " + [] {
+        std::string props;
+        for (int i = 0; i < 200; ++i)
+            props += "\"p" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+        return props;
+    }() + "\"end\": 0}";
+    CachedSeeker many{PatternSeeker(big)};
+    for (int pass = 0; pass < 2; ++pass) {
+        assert(many.getJsonProp(longName).to_string() == "1");
+        for (int i = 0; i < 200; ++i)
+            assert(many.getJsonProp("p" + std::to_string(i)).takeUInt64(0) == uint64_t(i));
+    }
+    assert(many.hits() + many.misses() == 402);
+    
+    std::cout << "  ✓ CachedSeeker passed" << std::endl;
+}
+
+void test_batch_plan() {
+    std::cout << "Testing batch extraction plans..." << std::endl;
+    
+    ExtractionPlan plan;
+    plan.to("user=").extract(" ", move_after)
+        .to("bytes=").takeUInt64()
+        .to("delta=").takeInt64()
+        .to("ratio=").takeDouble()
+        .getJsonProp("id");
+    assert(plan.columns() == 5);
+    assert(plan.columnType(0) == ColumnType::string && plan.columnType(3) == ColumnType::float64);
+    assert(plan.columnCount(ColumnType::string) == 2);
+    
+    std::vector<std::string> lines;
+    std::mt19937 rng(5);
+    for (int i = 0; i < 100; ++i) {
+        std::string line = "ts=" + std::to_string(i) + " user=u" + std::to_string(rng() % 1000) + " ";
+        if (i % 7 != 3)
+            line += "bytes=" + std::to_string(rng()) + " ";
+        line += "delta=-" + std::to_string(rng() % 50) + " ratio=0." + std::to_string(rng() % 100);
+        line += i % 5 ? " {\"id\":\"" + std::to_string(i) + "\"}" : " {\"id\":\"\"}";
+        lines.push_back(line);
+    }
+    lines.push_back("");
+    lines.push_back("user=last");
+    std::vector<std::string_view> records(lines.begin(), lines.end());
+    
+    BatchResult result;
+    for (size_t distance : { 0, 1, 4, 16, 1000 }) {
+        BatchExecutor(plan, distance).run(records, result);
+        assert(result.size() == records.size());
+        assert(result.strings(0).size() == records.size() && result.uint64s(0).empty());
+        
+        for (size_t i = 0; i < records.size(); ++i) {
+            const auto found = [&](const PatternSeeker& value) {
+                const char* data = value.to_string_view().data();
+                return data >= records[i].data() && data <= records[i].data() + records[i].size();
+            };
+            // the same calls by hand, a record stops at the first failure
+            PatternSeeker ps(records[i]);
+            bool valid = ps.to("user=", move_after);
+            const auto user = valid ? ps.extract(" ", move_after) : PatternSeeker{std::string_view{}};
+            valid = valid && found(user);
+            assert(result.strings(0)[i] == user.to_string_view());
+            std::optional<uint64_t> bytes;
+            if (valid && ps.to("bytes=", move_after))
+                bytes = ps.takeUInt64();
+            valid = valid && bytes;
+            assert(result.uint64s(1)[i] == bytes.value_or(0));
+            std::optional<int64_t> delta;
+            if (valid && ps.to("delta=", move_after))
+                delta = ps.takeInt64();
+            valid = valid && delta;
+            assert(result.int64s(2)[i] == delta.value_or(0));
+            std::optional<double> ratio;
+            if (valid && ps.to("ratio=", move_after))
+                ratio = ps.takeDouble();
+            valid = valid && ratio;
+            assert(result.doubles(3)[i] == ratio.value_or(0.0));
+            const auto id = valid ? ps.getJsonProp("id") : PatternSeeker{std::string_view{}};
+            assert(result.strings(4)[i] == id.to_string_view());
+            assert(result.valid()[i] == (valid && found(id)));
+        }
+    }
+    assert(result.valid()[0] && result.strings(4)[0].empty() && result.strings(4)[1] == "1");
+    assert(!result.valid()[3] && result.strings(0)[3].starts_with("u") && result.int64s(2)[3] == 0);
+    assert(!result.valid()[100] && !result.valid()[101]);
+    
+    // Cursor steps and a result reused for another plan
+    ExtractionPlan header;
+    header.expect("GET").skipWhiteSpaces().extract(" ").skip(4).extract("/", "\r\n", move_after);
+    const std::string_view requests[] = { "GET  /index HTTP/1.1\r\n", "POST /x HTTP/1.1\r\n", "GET /a " };
+    BatchExecutor(header).run(requests, result);
+    assert(result.size() == 3 && result.valid()[0] && !result.valid()[1] && !result.valid()[2]);
+    assert(result.strings(0)[0] == "/index" && result.strings(1)[0] == "1.1");
+    assert(result.strings(0)[2] == "/a" && result.strings(1)[2].empty());
+    assert(result.uint64s(0).empty() && result.strings(2).empty());
+    
+    // A count of skip() above 32 bits isn't truncated
+    ExtractionPlan far;
+    far.skip(size_t(1) << 32);
+    BatchExecutor(far).run(requests, result);
+    assert(!result.valid()[0] && !result.valid()[1] && !result.valid()[2]);
+    
+    std::cout << "  ✓ Batch extraction plans passed" << std::endl;
+}
+
 void test_xml() {
     std::cout << "Testing XML operations..." << std::endl;
     
@@ -151,6 +1470,22 @@ void test_xml() {
     auto nameTag = ps.getXmlTag("name");
     assert(nameTag.to_string() == "<name>John</name>");
     
+    // Only whole names match and the nested tags of the same name are counted
+    PatternSeeker tricky(std::string_view(
+        "<names>all</names><name/></name><name id=\"a>b\"><name>inner</name> tail</name><name >last</name>"));
+    assert(tricky.getXmlTag("names").to_string() == "<names>all</names>");
+    assert(tricky.getXmlTag("name").to_string() == "<name/>");
+    assert(tricky.getXmlTagBody("name").isEmpty());
+    tricky.getXmlTag("name", move_after);
+    auto nested = tricky.getXmlTag("name", move_after);
+    assert(nested.to_string() == "<name id=\"a>b\"><name>inner</name> tail</name>");
+    assert(nested.getOffset() == 32);
+    assert(PatternSeeker(nested).getXmlTagBody("name").to_string() == "<name>inner</name> tail");
+    assert(tricky.getXmlTagBody("name").to_string() == "last");
+    assert(tricky.to_string() == "<name >last</name>");
+    assert(PatternSeeker(std::string_view("<nam")).getXmlTag("nam").isEmpty());
+    assert(PatternSeeker(std::string_view("<a><a></a>")).getXmlTag("a").isEmpty());
+    
     std::cout << "  ✓ XML operations passed" << std::endl;
 }
 
@@ -168,6 +1503,460 @@ void test_xml_attributes() {
     std::cout << "  ✓ XML attributes passed" << std::endl;
 }
 
+void test_xml_tokenizer() {
+    std::cout << "Testing XML tokenizer..." << std::endl;
+    
+    const std::string soap = "<?xml version=\"1.0\"?>\n<Envelope xmlns=\"urn:x\">\n  <!-- a <comment> -->\n"
+        "  <Body><Order id=\"7\" note='a &amp; b' empty=\"\">Tom &amp; Jerry<![CDATA[<raw>]]></Order>"
+        "<Item sku=\"A1\"/><Item sku=\"B2\" /></Body>\n</Envelope>";
+    XmlTokenizer xml{PatternSeeker(soap)};
+    std::vector<std::string> events;
+    size_t maxDepth = 0;
+    while (auto event = xml.next()) {
+        maxDepth = std::max(maxDepth, xml.depth());
+        std::string line;
+        switch (event.type) {
+        case XmlEventType::start_tag: line = "<" + event.name.to_string() + "|" + event.value.to_string(); break;
+        case XmlEventType::attribute: line = "@" + event.name.to_string() + "=" + event.value.to_string(); break;
+        case XmlEventType::text: line = "t:" + event.value.to_string(); break;
+        case XmlEventType::cdata: line = "c:" + event.value.to_string(); break;
+        case XmlEventType::end_tag: line = ">" + event.name.to_string(); break;
+        default: break;
+        }
+        if (event.hasEntities)
+            line += "&";
+        events.push_back(line);
+    }
+    const std::vector<std::string> expected{
+        "<Envelope|xmlns=\"urn:x\"", "@xmlns=urn:x", "<Body|",
+        "<Order|id=\"7\" note='a &amp; b' empty=\"\"", "@id=7", "@note=a &amp; b&", "@empty=",
+        "t:Tom &amp; Jerry&", "c:<raw>", ">Order",
+        "<Item|sku=\"A1\"", "@sku=A1", ">Item", "<Item|sku=\"B2\" ", "@sku=B2", ">Item",
+        ">Body", ">Envelope" };
+    assert(events == expected);
+    assert(maxDepth == 3 && xml.depth() == 0);
+    assert(xml.next().type == XmlEventType::end);
+    
+    // The views keep the offsets in the data
+    XmlTokenizer offsets{PatternSeeker(std::string_view("<a><b>text</b></a>"))};
+    offsets.next();
+    offsets.next();
+    auto text = offsets.next();
+    assert(text.type == XmlEventType::text && text.value.getOffset() == 6);
+    
+    // Errors stop the tokenizer
+    for (const char* broken : { "<a", "<a b></a>", "<a b=c></a>", "text <!-- no end", "< a>", "<a b\"c=\"d\">" }) {
+        XmlTokenizer bad{PatternSeeker(std::string_view(broken))};
+        XmlEvent event;
+        while ((event = bad.next()))
+            ;
+        assert(event.type == XmlEventType::error);
+        assert(bad.next().type == XmlEventType::error);
+    }
+    
+    // Many tags in one pass give the same as getXmlTagBody for each one
+    std::string large = "<Envelope><Body>";
+    for (int i = 0; i < 200; ++i)
+        large += "<f" + std::to_string(i % 20) + ">" + std::to_string(i) + "</f" + std::to_string(i % 20) + ">";
+    large += "</Body></Envelope>";
+    std::vector<std::string> firsts(20);
+    XmlTokenizer pass{PatternSeeker(large)};
+    std::string open;
+    while (auto event = pass.next()) {
+        if (event.type == XmlEventType::start_tag)
+            open = event.name.to_string();
+        else if (event.type == XmlEventType::text && open[0] == 'f' && firsts[std::stoi(open.substr(1))].empty())
+            firsts[std::stoi(open.substr(1))] = event.value.to_string();
+    }
+    for (int i = 0; i < 20; ++i) {
+        PatternSeeker ps(large);
+        assert(ps.getXmlTagBody("f" + std::to_string(i)).to_string() == firsts[i]);
+    }
+    
+    std::cout << "  ✓ XML tokenizer passed" << std::endl;
+}
+
+void test_lazy_ranges() {
+    std::cout << "Testing lazy element ranges..." << std::endl;
+    
+    static_assert(std::ranges::input_range<PatternSeeker::JsonElements>);
+    static_assert(std::ranges::view<PatternSeeker::JsonElements>);
+    static_assert(std::ranges::borrowed_range<PatternSeeker::XmlChildren>);
+    
+    PatternSeeker doc(R"({"items": [ 1, "a,]\"b", {"k": [1, "]"]}, [2, 3], "", -4.5e1 ], "n": 0})");
+    // the array ends where its elements end, so it is walked right from the position of the value
+    auto array = doc;
+    assert(array.to("\"items\":", move_after));
+    std::vector<std::string> items;
+    for (auto item : array.jsonArrayElements())
+        items.push_back(item.to_string());
+    assert((items == std::vector<std::string>{ "1", R"(a,]\"b)", R"({"k": [1, "]"]})", "[2, 3]", "", "-4.5e1" }));
+    
+    // The elements keep the original pointer and the offsets of the document
+    auto third = *std::ranges::next(array.jsonArrayElements().begin(), 2);
+    assert(third.getOffset() == doc.to_string_view().find("{\"k\""));
+    
+    // Only the elements that are taken are parsed, the broken tail is never reached
+    PatternSeeker broken(std::string_view("[1, 2, 3, {\"unterminated\": [ "));
+    std::vector<std::string> firstTwo;
+    for (auto item : broken.jsonArrayElements() | std::views::take(2))
+        firstTwo.push_back(item.to_string());
+    assert((firstTwo == std::vector<std::string>{ "1", "2" }));
+    
+    auto odd = PatternSeeker(std::string_view("[1,2,3,4,5]")).jsonArrayElements()
+        | std::views::filter([](PatternSeeker item) { return item.takeUInt64(0) % 2 == 1; });
+    assert(std::ranges::distance(odd) == 3);
+    
+    assert(std::ranges::distance(PatternSeeker(std::string_view(" [ ] ")).jsonArrayElements()) == 0);
+    assert(std::ranges::distance(PatternSeeker(std::string_view("{\"a\": 1}")).jsonArrayElements()) == 0);
+    assert(std::ranges::distance(PatternSeeker(std::string_view("[\n[],\n{}\n]")).jsonArrayElements()) == 2);
+    
+    // Siblings only: <items> isn't <item>, nested tags of the same name stay inside their parent,
+    // and the range ends with the parent of the first tag
+    PatternSeeker xml(std::string_view(
+        "<root><items>no</items><list>"
+        "<item id=\"1\">a</item>"
+        "<!-- <item>commented</item> -->"
+        "<note x=\"<item>\"><item>nested in another tag</item></note>"
+        "<item id=\"2\"><item>inner</item></item>"
+        "<item id=\"3\"/>"
+        "</list><item>after the list</item></root>"));
+    std::vector<std::string> tags;
+    for (auto tag : xml.xmlChildren("item"))
+        tags.push_back(tag.getXmlAttr("id").to_string());
+    assert((tags == std::vector<std::string>{ "1", "2", "3" }));
+    
+    auto second = *std::ranges::next(xml.xmlChildren("item").begin());
+    assert(second.to_string() == "<item id=\"2\"><item>inner</item></item>");
+    assert(second.getOffset() == xml.to_string_view().find("<item id=\"2\""));
+    assert(std::ranges::distance(xml.xmlChildren("missing")) == 0);
+    assert(std::ranges::distance(xml.getXmlTag("root").xmlChildren("items")) == 1);
+    
+    std::cout << "  ✓ Lazy element ranges passed" << std::endl;
+}
+
+void test_string_view_lookups() {
+    std::cout << "Testing string_view lookups..." << std::endl;
+    
+    std::string json = R"({"username": "alice", "name": "Bob", "request_correlation_id": 42})";
+    PatternSeeker ps(json);
+    
+    std::string_view key = "name";
+    assert(ps.getJsonProp(key).to_string() == "Bob");
+    assert(ps.getJsonProp(std::string("request_correlation_id")).to_string() == "42");
+    assert(ps.getJsonProp("user").isEmpty());
+    
+    std::string xml = "<root><name id=\"7\">John</name></root>";
+    PatternSeeker px(xml);
+    auto body = px.getXmlTagBody(std::string_view("name"));
+    assert(body.to_string() == "John");
+    assert(body.getOffset() == xml.find("John"));
+    assert(px.getXmlTag("age").isEmpty());
+    assert(px.getXmlAttr(std::string_view("id")).to_string() == "7");
+    
+    std::cout << "  ✓ String_view lookups passed" << std::endl;
+}
+
+template <FixedString Str>
+void check_pattern_find(const std::string& haystack) {
+    constexpr std::string_view needle = Str.view();
+    for (size_t from = 0; from <= haystack.size() + 1; ++from) {
+        assert(pattern<Str>::find(haystack, from) == std::string_view(haystack).find(needle, from));
+    }
+}
+
+void test_compile_time_patterns() {
+    std::cout << "Testing compile-time patterns..." << std::endl;
+    using namespace PatterSeekerNS::literals;
+    
+    PatternSeeker ps(R"({"id": 5, "user_id": 42, "name": "Bob"})");
+    auto copy = ps;
+    assert(copy.to(pattern<"\"user_id\":">{}, move_after));
+    copy.skipWhiteSpaces();
+    assert(copy.takeUInt64() == 42u);
+    assert(!copy.to("\"missing\""_pat));
+    
+    assert(ps.extract("\"name\": \""_pat, "\""_pat).to_string() == "Bob");
+    assert(ps.extract(", "_pat).to_string() == "{\"id\": 5");
+    assert(ps.getJsonProp("user_id"_pat).to_string() == "42");
+    assert(ps.getJsonProp("user"_pat).isEmpty());
+    
+    assert(ps.startsWith("{\"id\""_pat));
+    assert(ps.expect("{\"id\": "_pat));
+    assert(!ps.expect("{"_pat));
+    assert(ps.takeUInt64() == 5u);
+    
+    // Every specialization must agree with std::string_view::find
+    std::mt19937 rng(42);
+    std::string haystack;
+    for (int i = 0; i < 512; ++i)
+        haystack += "abc"[rng() % 3];
+    haystack += "abcabcabcabcabcabcabcab";
+    check_pattern_find<"a">(haystack);
+    check_pattern_find<"abc">(haystack);
+    check_pattern_find<"abcabcab">(haystack);
+    check_pattern_find<"abcabcabc">(haystack);
+    check_pattern_find<"abcabcabcabcabca">(haystack);
+    check_pattern_find<"abcabcabcabcabcab">(haystack);
+    check_pattern_find<"abcabcabcabcabcabcabcab">(haystack);
+    check_pattern_find<"ccc">(haystack);
+    check_pattern_find<"x">(haystack);
+    
+    std::cout << "  ✓ Compile-time patterns passed" << std::endl;
+}
+
+void test_search_backends() {
+    std::cout << "Testing search backends..." << std::endl;
+    
+    const auto initial = activeSearchBackend();
+    assert(isSearchBackendSupported(SearchBackend::scalar));
+    assert(isSearchBackendSupported(initial));
+    
+    std::mt19937 rng(7);
+    for (auto backend : { SearchBackend::scalar, SearchBackend::sse2, SearchBackend::avx2,
+                          SearchBackend::avx512, SearchBackend::neon }) {
+        if (!setSearchBackend(backend))
+            continue;
+        assert(activeSearchBackend() == backend);
+        
+        for (int round = 0; round < 2000; ++round) {
+            std::string haystack;
+            const size_t size = rng() % 300;
+            for (size_t i = 0; i < size; ++i)
+                haystack += "ab\"c"[rng() % 4];
+            
+            std::string needle;
+            const size_t needleSize = 2 + rng() % 24;
+            if (size > needleSize && rng() % 2) {
+                needle = haystack.substr(rng() % (size - needleSize), needleSize);
+            } else {
+                for (size_t i = 0; i < needleSize; ++i)
+                    needle += "ab\"c"[rng() % 4];
+            }
+            
+            const size_t from = rng() % (size + 2);
+            PatternSeeker ps(haystack);
+            const size_t expected = std::string_view(haystack).find(needle);
+            assert(ps.to(needle) == (expected != std::string_view::npos));
+            if (ps.to(needle, move_before))
+                assert(ps.getOffset() == expected);
+            
+            // needles of any size, also the short ones the forward kernels don't get
+            PatternSeeker back(haystack);
+            const auto shortNeedle = std::string_view(needle).substr(0, 1 + rng() % needle.size());
+            const size_t expectedBack = std::string_view(haystack).rfind(shortNeedle);
+            assert(back.rto(shortNeedle, move_before) == (expectedBack != std::string_view::npos));
+            if (expectedBack != std::string_view::npos)
+                assert(back.getOffset() == expectedBack);
+            
+            auto sub = PatternSeeker(haystack);
+            sub.skip(std::min(from, haystack.size()));
+            const size_t expectedFrom = std::string_view(haystack).find(needle, std::min(from, haystack.size()));
+            auto extracted = sub.extract(needle);
+            if (expectedFrom == std::string_view::npos)
+                assert(extracted.isEmpty());
+            else
+                assert(extracted.size() == expectedFrom - std::min(from, haystack.size()));
+        }
+        
+        // Case-insensitive search compared with lower-cased copies, the bytes next to the letters
+        // in ASCII ('@' and '`', '[' and '{') must not fold
+        for (int round = 0; round < 2000; ++round) {
+            constexpr std::string_view ALPHABET = "aAbB@`[{c";
+            std::string haystack, needle;
+            const size_t size = rng() % 200;
+            for (size_t i = 0; i < size; ++i)
+                haystack += ALPHABET[rng() % ALPHABET.size()];
+            const size_t needleSize = 1 + rng() % 20;
+            if (size > needleSize && rng() % 2) {
+                needle = haystack.substr(rng() % (size - needleSize), needleSize);
+                for (auto& c : needle)
+                    c = rng() % 2 ? static_cast<char>(std::toupper(c)) : c;
+            } else {
+                for (size_t i = 0; i < needleSize; ++i)
+                    needle += ALPHABET[rng() % ALPHABET.size()];
+            }
+            auto lower = [](std::string str) {
+                for (auto& c : str)
+                    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                return str;
+            };
+            const size_t expected = std::string_view(lower(haystack)).find(lower(needle));
+            PatternSeeker ps(haystack);
+            assert(ps.to(ignore_case(needle), move_before) == (expected != std::string_view::npos));
+            if (expected != std::string_view::npos)
+                assert(ps.getOffset() == expected);
+        }
+        
+        PatternSeeker xml(std::string_view("<a><item id=\"42\">x</item></a>"));
+        assert(xml.getXmlTag("item").to_string() == "<item id=\"42\">x</item>");
+        assert(xml.getXmlAttr("id").to_string() == "42");
+    }
+    assert(!setSearchBackend(static_cast<SearchBackend>(100)));
+    setSearchBackend(initial);
+    
+    std::cout << "  ✓ Search backends passed" << std::endl;
+}
+
+// The byte-at-a-time matcher extract(char, char) used to be
+static std::string reference_brackets(const std::string& str, char start, char end, bool skipStrings) {
+    size_t i = 0;
+    bool inString = false;
+    size_t startIndex = std::string::npos;
+    int depth = 0;
+    for (; i < str.size(); ++i) {
+        const char ch = str[i];
+        if (skipStrings && ch == '\\') {
+            ++i;
+            continue;
+        }
+        if (skipStrings && inString) {
+            if (ch == '"') inString = false;
+            continue;
+        }
+        if (skipStrings && ch == '"') {
+            inString = true;
+        } else if (ch == start) {
+            if (depth++ == 0) startIndex = i;
+        } else if (ch == end && depth > 0) {
+            if (--depth == 0) return str.substr(startIndex, i + 1 - startIndex);
+        }
+    }
+    return {};
+}
+
+void test_vectorized_brackets() {
+    std::cout << "Testing vectorized bracket matching..." << std::endl;
+    
+    PatternSeeker ps(R"(x {"text": "}", "list": [1, {"a": "]"}]} tail)");
+    auto naive = ps;
+    assert(naive.extract('{', '}').to_string() == R"({"text": "})");
+    auto quoted = ps.extractQuoteAware('{', '}', move_after);
+    assert(quoted.to_string() == R"({"text": "}", "list": [1, {"a": "]"}]})");
+    assert(quoted.getOffset() == 2);
+    assert(ps.to_string() == " tail");
+    
+    PatternSeeker escaped(R"({"a": "\"}\\", "b": 1} rest)");
+    assert(escaped.extractQuoteAware('{', '}').to_string() == R"({"a": "\"}\\", "b": 1})");
+    assert(PatternSeeker("[[]").extractQuoteAware('[', ']').isEmpty());
+    assert(PatternSeeker("||").extract('|', '|').isEmpty());
+    
+    // Deep nesting across many 64-byte blocks, with and without strings inside
+    std::mt19937 rng(3);
+    for (int round = 0; round < 300; ++round) {
+        std::string doc;
+        const size_t size = rng() % 600;
+        for (size_t i = 0; i < size; ++i)
+            doc += "{}[]\"\\ab"[rng() % 8];
+        
+        for (auto backend : { SearchBackend::scalar, SearchBackend::sse2, SearchBackend::avx2,
+                              SearchBackend::avx512, SearchBackend::neon }) {
+            if (!setSearchBackend(backend))
+                continue;
+            PatternSeeker plain(doc);
+            auto expected = reference_brackets(doc, '{', '}', false);
+            assert(plain.extract('{', '}', move_after).to_string() == expected);
+            
+            PatternSeeker aware(doc);
+            expected = reference_brackets(doc, '[', ']', true);
+            assert(aware.extractQuoteAware('[', ']').to_string() == expected);
+        }
+    }
+    setSearchBackend(detail::bestSearchBackend());
+    
+    std::cout << "  ✓ Vectorized bracket matching passed" << std::endl;
+}
+
+// The leftmost match of any of the patterns, the first pattern on a tie
+static PatternMatch reference_any_of(std::string_view haystack, const std::vector<std::string>& patterns) {
+    PatternMatch best;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        const size_t pos = haystack.find(patterns[i]);
+        if (pos < best.position) {
+            best.position = pos;
+            best.index = i;
+        }
+    }
+    return best;
+}
+
+void test_multi_pattern() {
+    std::cout << "Testing multi-pattern search..." << std::endl;
+    
+    PatternSeeker log(std::string_view("ts=1 level=warn msg=\"disk\" level=error"));
+    auto match = log.toAnyOf({"error", "warn", "fatal"}, move_after);
+    assert(match && match.index == 1 && match.position == 11);
+    assert(log.getOffset() == 15);
+    assert(!log.toAnyOf({"fatal", "panic"}));
+    assert(log.getOffset() == 15);
+    
+    PatternSeeker fields(std::string_view("name=value;flag,rest"));
+    const MultiPattern separators{ ";", "," };
+    auto [name, first] = fields.extractUntilAnyOf({ "=" }, move_after);
+    assert(name.to_string() == "name" && first.index == 0);
+    auto [value, second] = fields.extractUntilAnyOf(separators, move_after);
+    assert(value.to_string() == "value" && value.getOffset() == 5 && second.index == 0);
+    auto [flag, third] = fields.extractUntilAnyOf(separators, move_before);
+    assert(flag.to_string() == "flag" && third.index == 1);
+    assert(fields.to_string() == ",rest");
+    auto [none, missing] = fields.extractUntilAnyOf({ "|" });
+    assert(none.isEmpty() && !missing);
+    
+    // Overlaps and prefixes: the leftmost start wins, then the first pattern in the set
+    assert(MultiPattern({ "abcd", "bc" }).find("xabcd").index == 0);
+    assert(MultiPattern({ "bcd", "abcdef" }).find("abcdex").position == 1);
+    assert(MultiPattern({ "ab", "abc", "ab" }).find("zabc").index == 0);
+    assert(MultiPattern({ "abc", "ab" }).find("zabc").index == 0);
+    assert(MultiPattern({ "x", "" }).find("ax").index == 1);
+    assert(MultiPattern({ "", "x" }).find("ax", 1).index == 0);
+    assert(MultiPattern({ "a", "" }).find("ab").index == 0);
+    assert(!MultiPattern({ "a" }).find("a", 2));
+    
+    const std::vector<std::string> keywords{ "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta",
+                                             "theta", "iota", "kappa", "lambda", "mu", "nu", "xi" };
+    const MultiPattern large(keywords);
+    assert(large.count() == keywords.size() && large.pattern(13) == "xi");
+    assert(large.find("the zetas and etas").index == 5);
+    assert(large.find("thetas").index == 7);
+    
+    std::mt19937 rng(11);
+    for (auto backend : { SearchBackend::scalar, SearchBackend::sse2, SearchBackend::avx2,
+                          SearchBackend::avx512, SearchBackend::neon }) {
+        if (!setSearchBackend(backend))
+            continue;
+        
+        for (int round = 0; round < 2000; ++round) {
+            std::string haystack;
+            const size_t size = rng() % 300;
+            for (size_t i = 0; i < size; ++i)
+                haystack += "abcd"[rng() % 4];
+            
+            // small sets go to Teddy and large ones to Aho-Corasick
+            std::vector<std::string> patterns(1 + rng() % (round % 2 ? 8 : 40));
+            for (auto& pattern : patterns) {
+                const size_t patternSize = 1 + rng() % 7;
+                if (size > patternSize && rng() % 2) {
+                    pattern = haystack.substr(rng() % (size - patternSize), patternSize);
+                } else {
+                    for (size_t i = 0; i < patternSize; ++i)
+                        pattern += "abcde"[rng() % 5];
+                }
+            }
+            
+            const MultiPattern set(patterns);
+            const size_t from = rng() % (size + 1);
+            auto expected = reference_any_of(std::string_view(haystack).substr(from), patterns);
+            if (expected)
+                expected.position += from;
+            const auto found = set.find(haystack, from);
+            assert(found.position == expected.position && found.index == expected.index);
+        }
+    }
+    setSearchBackend(detail::bestSearchBackend());
+    
+    std::cout << "  ✓ Multi-pattern search passed" << std::endl;
+}
+
 void test_offset() {
     std::cout << "Testing offset operations..." << std::endl;
     
@@ -193,14 +1982,42 @@ int main() {
         test_starts_with();
         test_to();
         test_extract();
+        test_reverse_search();
+        test_unchecked_seeker();
+        test_seek_chain();
+        test_ignore_case();
+        test_fields();
+        test_utf8();
         test_extract_brackets();
         test_take_uint64();
         test_take_int64();
+        test_number_parsing();
         test_skip_whitespaces();
+        test_char_classes();
         test_json();
+        test_json_strings();
+        test_json_props();
+        test_json_index();
+        test_json_path();
+        test_schema();
+        test_arena();
+        test_stream_seeker();
+        test_mapped_seeker();
+        test_parallel_records();
+        test_pipeline();
+        test_batch_plan();
+        test_cached_seeker();
         test_xml();
         test_xml_attributes();
+        test_xml_tokenizer();
+        test_lazy_ranges();
+        test_string_view_lookups();
+        test_compile_time_patterns();
+        test_search_backends();
+        test_vectorized_brackets();
+        test_multi_pattern();
         test_offset();
+        test_stats();
         
         std::cout << std::endl;
         std::cout << "=== All tests passed! ===" << std::endl;